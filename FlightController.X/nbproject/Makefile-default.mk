@@ -45,17 +45,17 @@ OBJECTDIR=build/${CND_CONF}/${IMAGE_TYPE}
 DISTDIR=dist/${CND_CONF}/${IMAGE_TYPE}
 
 # Source Files Quoted if spaced
-SOURCEFILES_QUOTED_IF_SPACED=src/i2c.c src/location_tracking.c src/lsm330tr.c src/main.c src/pid.c
+SOURCEFILES_QUOTED_IF_SPACED=src/calib.c src/evlog.c src/fft.c src/i2c.c src/idle.c src/imu.c src/location_tracking.c src/lsm330tr.c src/main.c src/motor.c src/overload.c src/params.c src/params_link.c src/pid.c src/pipe.c src/power.c src/predict.c src/profile.c src/rc.c src/replay.c src/spi.c src/stack.c src/timing.c src/trig.c src/vibe.c
 
 # Object Files Quoted if spaced
-OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/src/i2c.o ${OBJECTDIR}/src/location_tracking.o ${OBJECTDIR}/src/lsm330tr.o ${OBJECTDIR}/src/main.o ${OBJECTDIR}/src/pid.o
-POSSIBLE_DEPFILES=${OBJECTDIR}/src/i2c.o.d ${OBJECTDIR}/src/location_tracking.o.d ${OBJECTDIR}/src/lsm330tr.o.d ${OBJECTDIR}/src/main.o.d ${OBJECTDIR}/src/pid.o.d
+OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/src/calib.o ${OBJECTDIR}/src/evlog.o ${OBJECTDIR}/src/fft.o ${OBJECTDIR}/src/i2c.o ${OBJECTDIR}/src/idle.o ${OBJECTDIR}/src/imu.o ${OBJECTDIR}/src/location_tracking.o ${OBJECTDIR}/src/lsm330tr.o ${OBJECTDIR}/src/main.o ${OBJECTDIR}/src/motor.o ${OBJECTDIR}/src/overload.o ${OBJECTDIR}/src/params.o ${OBJECTDIR}/src/params_link.o ${OBJECTDIR}/src/pid.o ${OBJECTDIR}/src/pipe.o ${OBJECTDIR}/src/power.o ${OBJECTDIR}/src/predict.o ${OBJECTDIR}/src/profile.o ${OBJECTDIR}/src/rc.o ${OBJECTDIR}/src/replay.o ${OBJECTDIR}/src/spi.o ${OBJECTDIR}/src/stack.o ${OBJECTDIR}/src/timing.o ${OBJECTDIR}/src/trig.o ${OBJECTDIR}/src/vibe.o
+POSSIBLE_DEPFILES=${OBJECTDIR}/src/calib.o.d ${OBJECTDIR}/src/evlog.o.d ${OBJECTDIR}/src/fft.o.d ${OBJECTDIR}/src/i2c.o.d ${OBJECTDIR}/src/idle.o.d ${OBJECTDIR}/src/imu.o.d ${OBJECTDIR}/src/location_tracking.o.d ${OBJECTDIR}/src/lsm330tr.o.d ${OBJECTDIR}/src/main.o.d ${OBJECTDIR}/src/motor.o.d ${OBJECTDIR}/src/overload.o.d ${OBJECTDIR}/src/params.o.d ${OBJECTDIR}/src/params_link.o.d ${OBJECTDIR}/src/pid.o.d ${OBJECTDIR}/src/pipe.o.d ${OBJECTDIR}/src/power.o.d ${OBJECTDIR}/src/predict.o.d ${OBJECTDIR}/src/profile.o.d ${OBJECTDIR}/src/rc.o.d ${OBJECTDIR}/src/replay.o.d ${OBJECTDIR}/src/spi.o.d ${OBJECTDIR}/src/stack.o.d ${OBJECTDIR}/src/timing.o.d ${OBJECTDIR}/src/trig.o.d ${OBJECTDIR}/src/vibe.o.d
 
 # Object Files
-OBJECTFILES=${OBJECTDIR}/src/i2c.o ${OBJECTDIR}/src/location_tracking.o ${OBJECTDIR}/src/lsm330tr.o ${OBJECTDIR}/src/main.o ${OBJECTDIR}/src/pid.o
+OBJECTFILES=${OBJECTDIR}/src/calib.o ${OBJECTDIR}/src/evlog.o ${OBJECTDIR}/src/fft.o ${OBJECTDIR}/src/i2c.o ${OBJECTDIR}/src/idle.o ${OBJECTDIR}/src/imu.o ${OBJECTDIR}/src/location_tracking.o ${OBJECTDIR}/src/lsm330tr.o ${OBJECTDIR}/src/main.o ${OBJECTDIR}/src/motor.o ${OBJECTDIR}/src/overload.o ${OBJECTDIR}/src/params.o ${OBJECTDIR}/src/params_link.o ${OBJECTDIR}/src/pid.o ${OBJECTDIR}/src/pipe.o ${OBJECTDIR}/src/power.o ${OBJECTDIR}/src/predict.o ${OBJECTDIR}/src/profile.o ${OBJECTDIR}/src/rc.o ${OBJECTDIR}/src/replay.o ${OBJECTDIR}/src/spi.o ${OBJECTDIR}/src/stack.o ${OBJECTDIR}/src/timing.o ${OBJECTDIR}/src/trig.o ${OBJECTDIR}/src/vibe.o
 
 # Source Files
-SOURCEFILES=src/i2c.c src/location_tracking.c src/lsm330tr.c src/main.c src/pid.c
+SOURCEFILES=src/calib.c src/evlog.c src/fft.c src/i2c.c src/idle.c src/imu.c src/location_tracking.c src/lsm330tr.c src/main.c src/motor.c src/overload.c src/params.c src/params_link.c src/pid.c src/pipe.c src/power.c src/predict.c src/profile.c src/rc.c src/replay.c src/spi.c src/stack.c src/timing.c src/trig.c src/vibe.c
 
 
 CFLAGS=
@@ -94,12 +94,42 @@ endif
 # ------------------------------------------------------------------------------------
 # Rules for buildStep: compile
 ifeq ($(TYPE_IMAGE), DEBUG_RUN)
+${OBJECTDIR}/src/calib.o: src/calib.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/calib.o.d 
+	@${RM} ${OBJECTDIR}/src/calib.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/calib.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/calib.o.d" -o ${OBJECTDIR}/src/calib.o src/calib.c   
+	
+${OBJECTDIR}/src/evlog.o: src/evlog.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/evlog.o.d 
+	@${RM} ${OBJECTDIR}/src/evlog.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/evlog.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/evlog.o.d" -o ${OBJECTDIR}/src/evlog.o src/evlog.c   
+	
+${OBJECTDIR}/src/fft.o: src/fft.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/fft.o.d 
+	@${RM} ${OBJECTDIR}/src/fft.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/fft.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/fft.o.d" -o ${OBJECTDIR}/src/fft.o src/fft.c   
+	
 ${OBJECTDIR}/src/i2c.o: src/i2c.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}/src" 
 	@${RM} ${OBJECTDIR}/src/i2c.o.d 
 	@${RM} ${OBJECTDIR}/src/i2c.o 
 	@${FIXDEPS} "${OBJECTDIR}/src/i2c.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/i2c.o.d" -o ${OBJECTDIR}/src/i2c.o src/i2c.c   
 	
+${OBJECTDIR}/src/idle.o: src/idle.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/idle.o.d 
+	@${RM} ${OBJECTDIR}/src/idle.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/idle.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/idle.o.d" -o ${OBJECTDIR}/src/idle.o src/idle.c   
+	
+${OBJECTDIR}/src/imu.o: src/imu.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/imu.o.d 
+	@${RM} ${OBJECTDIR}/src/imu.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/imu.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/imu.o.d" -o ${OBJECTDIR}/src/imu.o src/imu.c   
+	
 ${OBJECTDIR}/src/location_tracking.o: src/location_tracking.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}/src" 
 	@${RM} ${OBJECTDIR}/src/location_tracking.o.d 
@@ -118,19 +148,139 @@ ${OBJECTDIR}/src/main.o: src/main.c  nbproject/Makefile-${CND_CONF}.mk
 	@${RM} ${OBJECTDIR}/src/main.o 
 	@${FIXDEPS} "${OBJECTDIR}/src/main.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/main.o.d" -o ${OBJECTDIR}/src/main.o src/main.c   
 	
+${OBJECTDIR}/src/motor.o: src/motor.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/motor.o.d 
+	@${RM} ${OBJECTDIR}/src/motor.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/motor.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/motor.o.d" -o ${OBJECTDIR}/src/motor.o src/motor.c   
+	
+${OBJECTDIR}/src/overload.o: src/overload.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/overload.o.d 
+	@${RM} ${OBJECTDIR}/src/overload.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/overload.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/overload.o.d" -o ${OBJECTDIR}/src/overload.o src/overload.c   
+	
+${OBJECTDIR}/src/params.o: src/params.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/params.o.d 
+	@${RM} ${OBJECTDIR}/src/params.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/params.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/params.o.d" -o ${OBJECTDIR}/src/params.o src/params.c   
+	
+${OBJECTDIR}/src/params_link.o: src/params_link.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/params_link.o.d 
+	@${RM} ${OBJECTDIR}/src/params_link.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/params_link.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/params_link.o.d" -o ${OBJECTDIR}/src/params_link.o src/params_link.c   
+	
 ${OBJECTDIR}/src/pid.o: src/pid.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}/src" 
 	@${RM} ${OBJECTDIR}/src/pid.o.d 
 	@${RM} ${OBJECTDIR}/src/pid.o 
 	@${FIXDEPS} "${OBJECTDIR}/src/pid.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/pid.o.d" -o ${OBJECTDIR}/src/pid.o src/pid.c   
 	
+${OBJECTDIR}/src/pipe.o: src/pipe.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/pipe.o.d 
+	@${RM} ${OBJECTDIR}/src/pipe.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/pipe.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/pipe.o.d" -o ${OBJECTDIR}/src/pipe.o src/pipe.c   
+	
+${OBJECTDIR}/src/power.o: src/power.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/power.o.d 
+	@${RM} ${OBJECTDIR}/src/power.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/power.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/power.o.d" -o ${OBJECTDIR}/src/power.o src/power.c   
+	
+${OBJECTDIR}/src/predict.o: src/predict.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/predict.o.d 
+	@${RM} ${OBJECTDIR}/src/predict.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/predict.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/predict.o.d" -o ${OBJECTDIR}/src/predict.o src/predict.c   
+	
+${OBJECTDIR}/src/profile.o: src/profile.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/profile.o.d 
+	@${RM} ${OBJECTDIR}/src/profile.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/profile.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/profile.o.d" -o ${OBJECTDIR}/src/profile.o src/profile.c   
+	
+${OBJECTDIR}/src/rc.o: src/rc.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/rc.o.d 
+	@${RM} ${OBJECTDIR}/src/rc.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/rc.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/rc.o.d" -o ${OBJECTDIR}/src/rc.o src/rc.c   
+	
+${OBJECTDIR}/src/replay.o: src/replay.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/replay.o.d 
+	@${RM} ${OBJECTDIR}/src/replay.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/replay.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/replay.o.d" -o ${OBJECTDIR}/src/replay.o src/replay.c   
+	
+${OBJECTDIR}/src/spi.o: src/spi.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/spi.o.d 
+	@${RM} ${OBJECTDIR}/src/spi.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/spi.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/spi.o.d" -o ${OBJECTDIR}/src/spi.o src/spi.c   
+	
+${OBJECTDIR}/src/stack.o: src/stack.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/stack.o.d 
+	@${RM} ${OBJECTDIR}/src/stack.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/stack.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/stack.o.d" -o ${OBJECTDIR}/src/stack.o src/stack.c   
+	
+${OBJECTDIR}/src/timing.o: src/timing.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/timing.o.d 
+	@${RM} ${OBJECTDIR}/src/timing.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/timing.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/timing.o.d" -o ${OBJECTDIR}/src/timing.o src/timing.c   
+	
+${OBJECTDIR}/src/trig.o: src/trig.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/trig.o.d 
+	@${RM} ${OBJECTDIR}/src/trig.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/trig.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/trig.o.d" -o ${OBJECTDIR}/src/trig.o src/trig.c   
+	
+${OBJECTDIR}/src/vibe.o: src/vibe.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/vibe.o.d 
+	@${RM} ${OBJECTDIR}/src/vibe.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/vibe.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG -D__MPLAB_DEBUGGER_ICD3=1 -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/vibe.o.d" -o ${OBJECTDIR}/src/vibe.o src/vibe.c   
+	
 else
+${OBJECTDIR}/src/calib.o: src/calib.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/calib.o.d 
+	@${RM} ${OBJECTDIR}/src/calib.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/calib.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/calib.o.d" -o ${OBJECTDIR}/src/calib.o src/calib.c   
+	
+${OBJECTDIR}/src/evlog.o: src/evlog.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/evlog.o.d 
+	@${RM} ${OBJECTDIR}/src/evlog.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/evlog.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/evlog.o.d" -o ${OBJECTDIR}/src/evlog.o src/evlog.c   
+	
+${OBJECTDIR}/src/fft.o: src/fft.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/fft.o.d 
+	@${RM} ${OBJECTDIR}/src/fft.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/fft.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/fft.o.d" -o ${OBJECTDIR}/src/fft.o src/fft.c   
+	
 ${OBJECTDIR}/src/i2c.o: src/i2c.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}/src" 
 	@${RM} ${OBJECTDIR}/src/i2c.o.d 
 	@${RM} ${OBJECTDIR}/src/i2c.o 
 	@${FIXDEPS} "${OBJECTDIR}/src/i2c.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/i2c.o.d" -o ${OBJECTDIR}/src/i2c.o src/i2c.c   
 	
+${OBJECTDIR}/src/idle.o: src/idle.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/idle.o.d 
+	@${RM} ${OBJECTDIR}/src/idle.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/idle.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/idle.o.d" -o ${OBJECTDIR}/src/idle.o src/idle.c   
+	
+${OBJECTDIR}/src/imu.o: src/imu.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/imu.o.d 
+	@${RM} ${OBJECTDIR}/src/imu.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/imu.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/imu.o.d" -o ${OBJECTDIR}/src/imu.o src/imu.c   
+	
 ${OBJECTDIR}/src/location_tracking.o: src/location_tracking.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}/src" 
 	@${RM} ${OBJECTDIR}/src/location_tracking.o.d 
@@ -149,12 +299,102 @@ ${OBJECTDIR}/src/main.o: src/main.c  nbproject/Makefile-${CND_CONF}.mk
 	@${RM} ${OBJECTDIR}/src/main.o 
 	@${FIXDEPS} "${OBJECTDIR}/src/main.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/main.o.d" -o ${OBJECTDIR}/src/main.o src/main.c   
 	
+${OBJECTDIR}/src/motor.o: src/motor.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/motor.o.d 
+	@${RM} ${OBJECTDIR}/src/motor.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/motor.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/motor.o.d" -o ${OBJECTDIR}/src/motor.o src/motor.c   
+	
+${OBJECTDIR}/src/overload.o: src/overload.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/overload.o.d 
+	@${RM} ${OBJECTDIR}/src/overload.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/overload.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/overload.o.d" -o ${OBJECTDIR}/src/overload.o src/overload.c   
+	
+${OBJECTDIR}/src/params.o: src/params.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/params.o.d 
+	@${RM} ${OBJECTDIR}/src/params.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/params.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/params.o.d" -o ${OBJECTDIR}/src/params.o src/params.c   
+	
+${OBJECTDIR}/src/params_link.o: src/params_link.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/params_link.o.d 
+	@${RM} ${OBJECTDIR}/src/params_link.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/params_link.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/params_link.o.d" -o ${OBJECTDIR}/src/params_link.o src/params_link.c   
+	
 ${OBJECTDIR}/src/pid.o: src/pid.c  nbproject/Makefile-${CND_CONF}.mk
 	@${MKDIR} "${OBJECTDIR}/src" 
 	@${RM} ${OBJECTDIR}/src/pid.o.d 
 	@${RM} ${OBJECTDIR}/src/pid.o 
 	@${FIXDEPS} "${OBJECTDIR}/src/pid.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/pid.o.d" -o ${OBJECTDIR}/src/pid.o src/pid.c   
 	
+${OBJECTDIR}/src/pipe.o: src/pipe.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/pipe.o.d 
+	@${RM} ${OBJECTDIR}/src/pipe.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/pipe.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/pipe.o.d" -o ${OBJECTDIR}/src/pipe.o src/pipe.c   
+	
+${OBJECTDIR}/src/power.o: src/power.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/power.o.d 
+	@${RM} ${OBJECTDIR}/src/power.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/power.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/power.o.d" -o ${OBJECTDIR}/src/power.o src/power.c   
+	
+${OBJECTDIR}/src/predict.o: src/predict.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/predict.o.d 
+	@${RM} ${OBJECTDIR}/src/predict.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/predict.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/predict.o.d" -o ${OBJECTDIR}/src/predict.o src/predict.c   
+	
+${OBJECTDIR}/src/profile.o: src/profile.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/profile.o.d 
+	@${RM} ${OBJECTDIR}/src/profile.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/profile.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/profile.o.d" -o ${OBJECTDIR}/src/profile.o src/profile.c   
+	
+${OBJECTDIR}/src/rc.o: src/rc.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/rc.o.d 
+	@${RM} ${OBJECTDIR}/src/rc.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/rc.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/rc.o.d" -o ${OBJECTDIR}/src/rc.o src/rc.c   
+	
+${OBJECTDIR}/src/replay.o: src/replay.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/replay.o.d 
+	@${RM} ${OBJECTDIR}/src/replay.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/replay.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/replay.o.d" -o ${OBJECTDIR}/src/replay.o src/replay.c   
+	
+${OBJECTDIR}/src/spi.o: src/spi.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/spi.o.d 
+	@${RM} ${OBJECTDIR}/src/spi.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/spi.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/spi.o.d" -o ${OBJECTDIR}/src/spi.o src/spi.c   
+	
+${OBJECTDIR}/src/stack.o: src/stack.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/stack.o.d 
+	@${RM} ${OBJECTDIR}/src/stack.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/stack.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/stack.o.d" -o ${OBJECTDIR}/src/stack.o src/stack.c   
+	
+${OBJECTDIR}/src/timing.o: src/timing.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/timing.o.d 
+	@${RM} ${OBJECTDIR}/src/timing.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/timing.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/timing.o.d" -o ${OBJECTDIR}/src/timing.o src/timing.c   
+	
+${OBJECTDIR}/src/trig.o: src/trig.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/trig.o.d 
+	@${RM} ${OBJECTDIR}/src/trig.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/trig.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/trig.o.d" -o ${OBJECTDIR}/src/trig.o src/trig.c   
+	
+${OBJECTDIR}/src/vibe.o: src/vibe.c  nbproject/Makefile-${CND_CONF}.mk
+	@${MKDIR} "${OBJECTDIR}/src" 
+	@${RM} ${OBJECTDIR}/src/vibe.o.d 
+	@${RM} ${OBJECTDIR}/src/vibe.o 
+	@${FIXDEPS} "${OBJECTDIR}/src/vibe.o.d" $(SILENT) -rsi ${MP_CC_DIR}../  -c ${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -D_SUPPRESS_PLIB_WARNING -D_DISABLE_OPENADC10_CONFIGPORT_WARNING -MMD -MF "${OBJECTDIR}/src/vibe.o.d" -o ${OBJECTDIR}/src/vibe.o src/vibe.c   
+	
 endif
 
 # ------------------------------------------------------------------------------------
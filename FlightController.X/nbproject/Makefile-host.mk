@@ -0,0 +1,143 @@
+#
+# Host build of the firmware, runs the unchanged control loop on Linux with
+# the simulated hardware of src/host, @see src/hal.h.
+#
+#   make host                  build build/host/FlightController
+#   make host-run              build and run it, FC_HOST_SECONDS and FC_HOST_IMU
+#                              are passed through, @see src/host/hal_host.h
+#   make host-test             build and run the tests of src/host/test, each one
+#                              is linked with the firmware objects but main.o
+#   make host-bench            build and run the wall clock kernel benchmark, with
+#                              the default flags it fails on a regression against
+#                              src/host/bench/baseline.txt
+#   make host-bench-baseline   measure the kernels again and write the baseline
+#   make host-bench-ci         measure the baseline from HOST_BENCH_BASE, checked
+#                              out aside, and compare this tree with it on the
+#                              same machine, for CI where the committed baseline
+#                              is of another one. Run it with the merge target of
+#                              the change, HOST_BENCH_BASE=origin/main.
+#   make host-configs          build every supported loop rate and transport, I2C
+#                              at 100 and SPI at 100, 200, 400 and 800, fly each
+#                              for two simulated seconds and run its tests
+#   make host-replay-check     record a flight with RECORD, turn its packets into
+#                              a log with tools/replay_capture.py as for a board,
+#                              replay the log with REPLAY and check that both
+#                              print the same outputs, @see src/replay.h
+#   make host-clean            remove the host build
+#
+#   HOST_FLAGS="-DPROFILE"     extra firmware flags, e.g. -DLOOP_RATE_HZ=400
+#   SANITIZE=1                 build with address and undefined behaviour sanitizers
+#
+# The MPLAB makefiles are untouched, this file is included by ../Makefile.
+#
+
+HOST_CC ?= gcc
+HOST_DIR = build/host
+HOST_OUT = $(HOST_DIR)/FlightController
+HOST_SRC = $(wildcard src/*.c) $(wildcard src/host/*.c)
+HOST_OBJ = $(patsubst src/%.c,$(HOST_DIR)/%.o,$(HOST_SRC))
+HOST_TEST_SRC = $(wildcard src/host/test/test_*.c)
+HOST_TEST_OUT = $(patsubst src/host/test/%.c,$(HOST_DIR)/test/%,$(HOST_TEST_SRC))
+HOST_TEST_OBJ = $(filter-out $(HOST_DIR)/main.o,$(HOST_OBJ))
+HOST_BENCH = $(HOST_DIR)/bench/bench
+HOST_BENCH_BASELINE = src/host/bench/baseline.txt
+HOST_BENCH_BASE ?= HEAD
+HOST_CFLAGS = -std=gnu99 -O2 -g -fno-omit-frame-pointer -Wall -Wextra -Wno-unknown-pragmas -DHAL_HOST -Isrc -Isrc/host $(HOST_FLAGS)
+HOST_LDLIBS = -lm
+HOST_TEST_LDLIBS = $(HOST_LDLIBS) -pthread
+HOST_CONFIGS = i2c-100 spi-100 spi-200 spi-400 spi-800
+HOST_UBSAN = -fsanitize=undefined -fno-sanitize-recover=undefined
+ifeq ($(SANITIZE),1)
+HOST_CFLAGS += -fsanitize=address,undefined
+endif
+
+.PHONY: host host-run host-test host-bench host-bench-baseline host-bench-ci host-configs host-replay-check host-clean host-force
+
+host: $(HOST_OUT)
+
+host-run: $(HOST_OUT)
+	./$(HOST_OUT)
+
+host-test: $(HOST_TEST_OUT)
+	@for t in $^; do echo "$$t"; ./$$t || exit 1; done
+
+# the baseline is of the default build, other flags only report
+host-bench: $(HOST_BENCH)
+	./$(HOST_BENCH) $(if $(strip $(HOST_FLAGS)$(SANITIZE)),,$(HOST_BENCH_BASELINE))
+
+host-bench-baseline: $(HOST_BENCH)
+	@test -z "$(strip $(HOST_FLAGS)$(SANITIZE))" || { echo "the baseline is of the default build"; exit 1; }
+	./$(HOST_BENCH) -w $(HOST_BENCH_BASELINE)
+
+# the base is built from its own checkout, its baseline is written into HOST_DIR
+host-bench-ci:
+	rm -rf $(HOST_DIR)/base && git worktree prune
+	git worktree add --detach $(HOST_DIR)/base $(HOST_BENCH_BASE)
+	$(MAKE) -C $(HOST_DIR)/base/FlightController.X host-bench-baseline HOST_FLAGS= SANITIZE= \
+		HOST_BENCH_BASELINE=$(CURDIR)/$(HOST_DIR)/base.txt
+	git worktree remove --force $(HOST_DIR)/base
+	$(MAKE) host-bench HOST_FLAGS= SANITIZE= HOST_BENCH_BASELINE=$(HOST_DIR)/base.txt
+
+# each configuration builds in its own directory below HOST_DIR
+host-configs:
+	@for c in $(HOST_CONFIGS); do \
+		flags="-DLOOP_RATE_HZ=$${c#*-}"; \
+		if [ $${c%-*} = spi ]; then flags="$$flags -DLSM330_USE_SPI"; fi; \
+		echo "host: $$c"; \
+		$(MAKE) -s host HOST_DIR=$(HOST_DIR)/$$c HOST_FLAGS="$(HOST_FLAGS) $$flags" || exit 1; \
+		FC_HOST_SECONDS=2 ./$(HOST_DIR)/$$c/FlightController || exit 1; \
+		$(MAKE) -s host-test HOST_DIR=$(HOST_DIR)/$$c HOST_FLAGS="$(HOST_FLAGS) $$flags" || exit 1; \
+	done
+
+# the two builds take turns in HOST_DIR, the recorder is kept aside
+host-replay-check:
+	$(MAKE) host HOST_FLAGS="$(HOST_FLAGS) -DRECORD"
+	cp $(HOST_OUT) $(HOST_DIR)/record
+	FC_HOST_RECORD=$(HOST_DIR)/replay.rec ./$(HOST_DIR)/record | grep -v '^{' > $(HOST_DIR)/record.csv
+	python3 tools/replay_capture.py $(HOST_DIR)/replay.rec $(HOST_DIR)/replay.log
+	$(MAKE) host HOST_FLAGS="$(HOST_FLAGS) -DREPLAY"
+	FC_HOST_REPLAY=$(HOST_DIR)/replay.log ./$(HOST_OUT) > $(HOST_DIR)/replay.csv
+	@# the run ends inside a tick, whose frame never reached the log
+	head -n $$(wc -l < $(HOST_DIR)/replay.csv) $(HOST_DIR)/record.csv | cmp - $(HOST_DIR)/replay.csv
+	@test $$(wc -l < $(HOST_DIR)/replay.csv) -gt 1
+	@echo "host: replay of $$(($$(wc -l < $(HOST_DIR)/replay.csv) - 1)) ticks matches the flight"
+
+host-clean:
+	rm -rf $(HOST_DIR)
+
+# rebuild everything when the flags change, the stamp is only written when
+# they differ from the last build so its time tells the objects
+HOST_STAMP = $(HOST_DIR)/cflags
+$(HOST_STAMP): host-force
+	@mkdir -p $(HOST_DIR)
+	@echo '$(HOST_CFLAGS)' | cmp -s - $@ || echo '$(HOST_CFLAGS)' > $@
+
+$(HOST_OUT): $(HOST_OBJ)
+	$(HOST_CC) $(HOST_CFLAGS) -o $@ $^ $(HOST_LDLIBS)
+
+# every object depends on every header, the build is small enough
+$(HOST_DIR)/%.o: src/%.c $(wildcard src/*.h) $(wildcard src/host/*.h) $(HOST_STAMP)
+	@mkdir -p $(dir $@)
+	$(HOST_CC) $(HOST_CFLAGS) -c -o $@ $<
+
+$(HOST_DIR)/test/%: src/host/test/%.c $(HOST_TEST_OBJ) $(wildcard src/host/test/*.h)
+	@mkdir -p $(dir $@)
+	$(HOST_CC) $(HOST_CFLAGS) -Isrc/host/test -o $@ $< $(HOST_TEST_OBJ) $(HOST_TEST_LDLIBS)
+
+# the trig kernel wraps binary angles on purpose, its test builds it under
+# UBSan in every build so an overflow that is undefined fails the test
+$(HOST_DIR)/test/test_trig: src/host/test/test_trig.c src/trig.c $(HOST_TEST_OBJ) $(wildcard src/host/test/*.h)
+	@mkdir -p $(dir $@)
+	$(HOST_CC) $(HOST_CFLAGS) $(HOST_UBSAN) -Isrc/host/test -o $@ $< src/trig.c \
+		$(filter-out $(HOST_DIR)/trig.o,$(HOST_TEST_OBJ)) $(HOST_TEST_LDLIBS)
+
+# the link decoder is private to params_link.c, its test includes the source
+# with the link built in, in place of the object of the build
+$(HOST_DIR)/test/test_params: src/host/test/test_params.c src/params_link.c $(HOST_TEST_OBJ) $(wildcard src/host/test/*.h)
+	@mkdir -p $(dir $@)
+	$(HOST_CC) $(HOST_CFLAGS) -Isrc/host/test -o $@ $< \
+		$(filter-out $(HOST_DIR)/params_link.o,$(HOST_TEST_OBJ)) $(HOST_TEST_LDLIBS)
+
+$(HOST_BENCH): src/host/bench/bench.c $(HOST_TEST_OBJ)
+	@mkdir -p $(dir $@)
+	$(HOST_CC) $(HOST_CFLAGS) -o $@ $< $(HOST_TEST_OBJ) $(HOST_LDLIBS)
@@ -0,0 +1,199 @@
+/*
+ * File:   calib.c
+ * Author: Kevin Dederer
+ * Comments: streaming zero offset calibration. Each axis keeps a Welford
+ *           running mean and variance. At boot sampling stops as soon as the
+ *           confidence interval of every mean is inside CALIB_CI_G, and starts
+ *           over if the spread shows the craft being moved. In flight steady
+ *           one second windows nudge the offsets to follow slow bias drift,
+ *           the loop only queues the raw readings and the float work is done
+ *           a sample per step by a background job.
+ * Revision history:
+ */
+
+#include "config.h"
+
+#define CALIB_Z95_SQ (3.8416)   // 1.96 squared, 95% two sided
+
+#if (CALIB_TRACK_RING & (CALIB_TRACK_RING - 1)) != 0
+#error "CALIB_TRACK_RING must be a power of 2"
+#endif
+
+#define CALIB_TRACK_MASK (CALIB_TRACK_RING - 1)
+
+/*
+ * calib_sample - one queued reading
+ * @param x, y, z - the raw counts
+ * @param steady - the tick was steady, @see calib_track_push
+ */
+typedef struct
+{
+    int16_t x;
+    int16_t y;
+    int16_t z;
+    uint8_t steady;
+} calib_sample;
+
+/*
+ * calib_track_data - the in flight tracking, the loop writes the ring and
+ *              the job reads it, both from the main loop
+ * @param ring, head, tail - the queued readings
+ * @param sensor - the offsets to adjust
+ * @param window - the estimate of the current window
+ */
+typedef struct
+{
+    calib_sample ring[CALIB_TRACK_RING];
+    uint32_t head;
+    uint32_t tail;
+    sensor_data *sensor;
+    calib_data window;
+} calib_track_data;
+
+PRIVATE calib_track_data track;
+
+/*
+ * CALIB AXIS PUSH - adds a sample to one axis
+ * @param *axis - the axis statistics
+ * @param n - the sample count including this sample
+ * @param value - the sample
+ */
+PRIVATE void calib_axis_push(calib_axis *axis, unsigned int n, float value)
+{
+    float delta = value - axis->mean;
+
+    axis->mean += delta / n;
+    axis->m2 += delta * (value - axis->mean);
+}
+
+/*
+ * CALIB AXIS VARIANCE - the sample variance of one axis
+ * @param *axis - the axis statistics
+ * @param n - the sample count
+ * @return the variance in g squared.
+ */
+PRIVATE float calib_axis_variance(const calib_axis *axis, unsigned int n)
+{
+    return axis->m2 / (n - 1);
+}
+
+/*
+ * CALIB RESET - starts a new estimate, the restart count is kept
+ * @param *calib - the estimate
+ */
+void calib_reset(calib_data *calib)
+{
+    unsigned int restarts = calib->restarts;
+
+    *calib = (calib_data) {0};
+    calib->restarts = restarts;
+}
+
+/*
+ * CALIB PUSH - adds one raw reading to the estimate
+ * @param *calib - the estimate
+ * @param x, y, z - the raw acceleration in g
+ * @return calib_converged when every mean is within CALIB_CI_G or
+ *              CALIB_MAX_SAMPLES still samples were taken, calib_motion if the
+ *              estimate was restarted, calib_running otherwise.
+ */
+enum calib_result calib_push(calib_data *calib, float x, float y, float z)
+{
+    float vx, vy, vz, vmax, limit;
+
+    calib->n++;
+    calib_axis_push(&calib->x, calib->n, x);
+    calib_axis_push(&calib->y, calib->n, y);
+    calib_axis_push(&calib->z, calib->n, z);
+    if(calib->n < CALIB_MIN_SAMPLES) return calib_running;
+
+    vx = calib_axis_variance(&calib->x, calib->n);
+    vy = calib_axis_variance(&calib->y, calib->n);
+    vz = calib_axis_variance(&calib->z, calib->n);
+    vmax = (vx > vy) ? vx : vy;
+    vmax = (vz > vmax) ? vz : vmax;
+
+    if(vmax > CALIB_MOTION_G * CALIB_MOTION_G)
+    {
+        calib->restarts++;
+        calib_reset(calib);
+        return calib_motion;
+    }
+
+    // 1.96 * sqrt(var / n) < CALIB_CI_G, without the square root
+    limit = CALIB_CI_G * CALIB_CI_G * calib->n / CALIB_Z95_SQ;
+    if(vmax < limit || calib->n >= CALIB_MAX_SAMPLES) return calib_converged;
+    return calib_running;
+}
+
+/*
+ * CALIB APPLY - moves the zero offsets towards the estimate, the craft is
+ *              assumed level so the offsets bring the reading to 0, 0, 1g
+ * @param *calib - the estimate
+ * @param *lsm330 - the sensor struct holding the offsets
+ * @param gain - share of the difference to apply, 1 replaces the offsets
+ */
+void calib_apply(const calib_data *calib, sensor_data *lsm330, float gain)
+{
+    float scale = (1 << LSM330_ZERO_SHIFT) / lsm330->sensitivity;   // offset units per g
+
+    lsm330->zero_x += lroundf(gain * ((0.0 - calib->x.mean) * scale - lsm330->zero_x));
+    lsm330->zero_y += lroundf(gain * ((0.0 - calib->y.mean) * scale - lsm330->zero_y));
+    lsm330->zero_z += lroundf(gain * ((1.0 - calib->z.mean) * scale - lsm330->zero_z));
+}
+
+/*
+ * CALIB TRACK PUSH - queues the raw reading of a control tick for the in
+ *              flight bias tracking. If the job fell behind the newest queued
+ *              reading is marked unsteady instead, a window with a gap in it
+ *              is not used.
+ * @param *lsm330 - the raw reading, and the offsets calib_track_step() adjusts
+ * @param steady - nonzero if the pilot asks for a level hover this tick and
+ *              the attitude is still
+ */
+HOT_PATH void calib_track_push(sensor_data *lsm330, int steady)
+{
+    calib_sample *s;
+
+    track.sensor = lsm330;
+    if(track.head - track.tail >= CALIB_TRACK_RING)
+    {
+        track.ring[(track.head - 1) & CALIB_TRACK_MASK].steady = 0;
+        return;
+    }
+    s = &track.ring[track.head++ & CALIB_TRACK_MASK];
+    s->x = lsm330->raw_x;
+    s->y = lsm330->raw_y;
+    s->z = lsm330->raw_z;
+    s->steady = steady;
+}
+
+/*
+ * CALIB TRACK STEP - adds one queued reading to the window, called from the
+ *              loop slack. A window is only used if the craft was steady and
+ *              asked to be level for all of it and the spread shows no motion,
+ *              the offsets then move by CALIB_TRACK_GAIN of the difference.
+ *              Bounded by CALIB_TRACK_STEP_TICKS.
+ * @return 1 if a reading was taken, 0 if none was queued.
+ */
+int calib_track_step(void)
+{
+    const calib_sample *s;
+    float g;
+
+    if(track.tail == track.head) return 0;
+    s = &track.ring[track.tail++ & CALIB_TRACK_MASK];
+    if(!s->steady)
+    {
+        calib_reset(&track.window);
+        return 1;
+    }
+    g = track.sensor->sensitivity;
+    if(calib_push(&track.window, s->x * g, s->y * g, s->z * g) == calib_motion)
+        return 1;
+    if(track.window.n < CALIB_TRACK_WINDOW) return 1;
+
+    calib_apply(&track.window, track.sensor, CALIB_TRACK_GAIN);
+    calib_reset(&track.window);
+    return 1;
+}
@@ -0,0 +1,74 @@
+/*
+ * File:   calib.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the streaming accelerometer zero offset calibration
+ * Revision history:
+ */
+
+#ifndef CALIB_H
+#define	CALIB_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define CALIB_MIN_SAMPLES (16)          // samples before convergence or motion is judged
+#define CALIB_MAX_SAMPLES (400)         // accept the mean after this many still samples
+#define CALIB_BOOT_LIMIT (3000)         // give up waiting for stillness at boot, 30s at 100hz
+#define CALIB_CI_G (0.002)              // 95% confidence half width of the mean to stop at, g
+#define CALIB_MOTION_G (0.03)           // standard deviation that means the craft is moving, g
+#define CALIB_TRACK_WINDOW (LOOP_RATE_HZ)   // samples per in flight estimate, one second
+#define CALIB_TRACK_GAIN (0.02)         // share of each steady in flight estimate applied
+#define CALIB_LEVEL_RAD (1.0 * RAD)     // pitch and roll setpoints counted as level flight
+#define CALIB_HOVER_G (0.05)            // vertical acceleration setpoint off 1g counted as hover
+#define CALIB_STILL_RAD_S (2.0 * RAD)   // measured pitch and roll rates counted as still, rad/s
+#define CALIB_TRACK_RING (8)            // samples queued for the tracking job, must be a power of 2
+#define CALIB_TRACK_STEP_TICKS (2000)   // worst case core ticks of one calib_track_step() (50us)
+
+/*
+ * calib_axis - Welford running mean and variance of one axis
+ * @param mean - the running mean
+ * @param m2 - sum of squared differences from the mean
+ */
+typedef struct
+{
+    float mean;
+    float m2;
+} calib_axis;
+
+/*
+ * calib_data - running estimate over all three axes
+ * @param n - samples in the estimate
+ * @param restarts - estimates thrown away because of motion
+ * @param x, y, z - the per axis statistics
+ */
+typedef struct
+{
+    unsigned int n;
+    unsigned int restarts;
+    calib_axis x, y, z;
+} calib_data;
+
+/*
+ * calib_result - state of the estimate after a sample
+ * calib_motion - the variance showed motion, the estimate was restarted
+ * calib_running - more samples are needed
+ * calib_converged - the mean is known to within CALIB_CI_G
+ */
+enum calib_result
+{
+    calib_motion = -1, calib_running = 0, calib_converged = 1
+};
+
+void calib_reset(calib_data *calib);
+enum calib_result calib_push(calib_data *calib, float x, float y, float z);
+void calib_apply(const calib_data *calib, sensor_data *lsm330, float gain);
+void calib_track_push(sensor_data *lsm330, int steady);
+int calib_track_step(void);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* CALIB_H */
+
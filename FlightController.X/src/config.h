@@ -1,48 +1,153 @@
-/* 
- * File:   config.h
- * Author: tbriggs, Kevin Dederer
- * Comments: main configuration file, includes all necessary "#include" files
- *           for the project.
- * Revision history: 
- */
-
-#ifndef CONFIG_H
-#define	CONFIG_H
-
-#ifdef	__cplusplus
-extern "C" {
-#endif
-    
-#include <stdlib.h>
-#include <stdint.h>
-#include <p32xxxx.h>
-#include <xc.h>
-#include <plib.h>
-#include <peripheral/system.h>
-#include <errno.h>
-#include <math.h>
-#include "i2c.h"
-#include "lsm330tr.h"  
-#include "pid.h"
-
-#define SYS_FREQ (80000000L)
-#define PB_DIV 8
-#define PRESCALE 256
-#define TOGGLES_PER_SEC 1
-#define T1_TICK (SYS_FREQ/PB_DIV/PRESCALE/TOGGLES_PER_SEC)
-#define T2_TICK (SYS_FREQ/PB_DIV/PRESCALE/TOGGLES_PER_SEC)
-#define	GetSystemClock()      (80000000ul)
-#define	GetPeripheralClock()  (10000000ul) 
-#define	GetInstructionClock() (GetSystemClock())
-
-#define OFFSET (10000.0)    // decimal place shift
-#define RAD (M_PI / 180.0)  // conversion from degrees to radians
-#define DT (1/100.0)  // change in time between sensor readings
-#define DT_OFFSET (100) // decimal shift * time step ***** Change if DT, OFFSET or sample rate change
-#define I2C_CLOCK_FREQ (400000)
-
-#ifdef	__cplusplus
-}
-#endif
-
-#endif	/* CONFIG_H */
+/* 
+ * File:   config.h
+ * Author: tbriggs, Kevin Dederer
+ * Comments: main configuration file, includes all necessary "#include" files
+ *           for the project.
+ * Revision history: 
+ */
+
+#ifndef CONFIG_H
+#define	CONFIG_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <math.h>
+
+#define SYS_FREQ (80000000L)
+#define PB_DIV 8
+#define PRESCALE 256
+#define TOGGLES_PER_SEC 1
+#define T1_TICK (SYS_FREQ/PB_DIV/PRESCALE/TOGGLES_PER_SEC)
+#define T2_TICK (SYS_FREQ/PB_DIV/PRESCALE/TOGGLES_PER_SEC)
+#define	GetSystemClock()      (80000000ul)
+#define	GetPeripheralClock()  (10000000ul) 
+#define	GetInstructionClock() (GetSystemClock())
+#define CORE_TICKS_PER_US (GetSystemClock() / 2000000L)   // core timer counts at half the system clock
+
+//#define PROFILE    // time the control path kernels, @see profile.h
+//#define I2C_PROFILE    // count the bus traffic of every i2c operation, reported with PROFILE, @see i2c.h
+//#define REPLAY     // replay a recorded control input log instead of flying, host build only, @see replay.h
+//#define RECORD     // send the control inputs of every tick as a log out of UART1, a file on the host, @see replay.h
+//#define RUN_FROM_RAM   // execute the HOT_PATH functions from ram instead of flash
+//#define LSM330_USE_SPI // talk to the lsm330 over SPI2 with DMA burst reads instead of I2C2, @see spi.h
+//#define RC_SBUS        // read the receiver as SBUS on UART1 instead of PPM on input capture 1, @see rc.h
+//#define MOTOR_PWM_FREE_RUN // run the 16ms pwm period off timer 2 alone instead of aligned to the control tick, @see motor.h
+//#define PARAMS_LINK    // read and write the tunable parameters over UART1, @see params_link.h
+//#define HAL_HOST       // build for Linux on simulated hardware, set by nbproject/Makefile-host.mk, @see hal.h
+
+// control loop rate, everything tied to the rate is derived from it below and
+// in lsm330tr.c (sensor odr and bandwidth) and fir_coeffs.h (filter sets)
+#ifndef LOOP_RATE_HZ
+#define LOOP_RATE_HZ (100)      // 100, 200, 400 or 800, may be set on the command line
+#endif
+
+// sensor samples per control tick. Above 1 the lsm330 runs PIPE_DECIMATE
+// times faster than the loop with its fifo in stream mode, every tick
+// processes the block that arrived and keeps one sample, @see pipe.h. The
+// vibration analyser needs PIPE_SAMPLE_HZ of 400 or more, @see vibe.c, the
+// default keeps the sensor at 400 or 800 for every loop rate
+#ifndef PIPE_DECIMATE
+#if LOOP_RATE_HZ == 100
+#define PIPE_DECIMATE (4)       // 1, 2 or 4, may be set on the command line
+#elif LOOP_RATE_HZ == 200
+#define PIPE_DECIMATE (2)
+#else
+#define PIPE_DECIMATE (1)
+#endif
+#endif
+#define PIPE_SAMPLE_HZ (LOOP_RATE_HZ * PIPE_DECIMATE)  // sensor and filter sample rate
+#define PIPE_BLOCK (PIPE_DECIMATE + 1)  // longest block, one spare for the sensor clock running ahead
+
+#include "hal.h"
+
+// HOT_PATH marks the control path functions that stall on flash wait states.
+// With RUN_FROM_RAM they are copied to ram at startup. Ram and flash are in
+// different 256MB regions that a jal cannot cross, so both sides call long:
+// HOT_PATH goes on the prototype too so flash code calls into ram long, and
+// the flash functions the hot path calls are declared FLASH_CALL. The small
+// accessors it uses are HOT_PATH themselves. The compiler's own helpers, the
+// float arithmetic of the fpu-less MX and libm, are in flash as well, the
+// configuration that defines RUN_FROM_RAM also needs "Use indirect calls"
+// (-mlong-calls) set for xc32-gcc. tools/map_report.py shows the size of the
+// hot path against the available ram.
+#ifdef RUN_FROM_RAM
+#define HOT_PATH __longramfunc__
+#define HOT_PATH_IN_RAM (1)
+#define FLASH_CALL __longcall__ __attribute__((noinline))
+#else
+#define HOT_PATH
+#define HOT_PATH_IN_RAM (0)
+#define FLASH_CALL
+#endif
+#include "i2c.h"
+#include "spi.h"
+#include "lsm330tr.h"  
+#include "imu.h"
+#include "pid.h"
+#include "fft.h"
+#include "trig.h"
+#include "vibe.h"
+#include "profile.h"
+#include "overload.h"
+#include "evlog.h"
+#include "motor.h"
+#include "rc.h"
+#include "power.h"
+#include "calib.h"
+#include "timing.h"
+#include "predict.h"
+#include "fir_coeffs.h"
+#include "pipe.h"
+#include "params.h"
+#include "params_link.h"
+#include "replay.h"
+#include "idle.h"
+#include "stack.h"
+
+#define OFFSET (10000.0)    // decimal place shift
+#define RAD (M_PI / 180.0)  // conversion from degrees to radians
+#define DT (1.0 / LOOP_RATE_HZ)  // nominal change in time between sensor readings, measured by timing.c
+#define DT_OFFSET (OFFSET * DT) // decimal shift * time step
+#define LOOP_TICKS (SYS_FREQ / 2 / LOOP_RATE_HZ)  // core timer ticks per control tick
+#define I2C_CLOCK_FREQ (400000)
+
+#if LOOP_RATE_HZ != 100 && LOOP_RATE_HZ != 200 && LOOP_RATE_HZ != 400 && LOOP_RATE_HZ != 800
+#error "LOOP_RATE_HZ must be 100, 200, 400 or 800"
+#endif
+#if PIPE_DECIMATE != 1 && PIPE_DECIMATE != 2 && PIPE_DECIMATE != 4
+#error "PIPE_DECIMATE must be 1, 2 or 4"
+#endif
+// the fifo needs the sensor rate to match exactly, and a fir set must exist for it
+#if PIPE_DECIMATE > 1 && PIPE_SAMPLE_HZ != 400 && PIPE_SAMPLE_HZ != 800
+#error "PIPE_SAMPLE_HZ must be 400 or 800 with PIPE_DECIMATE above 1"
+#endif
+#if (SYS_FREQ / 2) % LOOP_RATE_HZ != 0
+#error "LOOP_RATE_HZ must divide the core timer clock"
+#endif
+// the status poll and the sample burst of every imu must fit in half a tick,
+// on I2C the worst case only fits at 100, the faster rates need the spi transport
+#if !defined(LSM330_USE_SPI) && LOOP_RATE_HZ != 100
+#error "I2C runs the loop at 100 only, define LSM330_USE_SPI for a faster LOOP_RATE_HZ"
+#endif
+#if !defined(LSM330_USE_SPI) && IMU_COUNT * LSM330_READ_WORST_US > 500000 / LOOP_RATE_HZ
+#error "I2C is too slow for LOOP_RATE_HZ, define LSM330_USE_SPI"
+#endif
+// a full block is one burst, its bytes and their acknowledge bits must fit one transaction
+#if !defined(LSM330_USE_SPI) && (6 * PIPE_BLOCK + 3) * 9 * 1000000 / I2C_CLOCK_FREQ > I2C_TRANSACTION_US
+#error "a block burst does not fit I2C_TRANSACTION_US, lower PIPE_DECIMATE or define LSM330_USE_SPI"
+#endif
+#if VIBE_STEP_TICKS >= LOOP_TICKS / 2 || EVLOG_DRAIN_TICKS >= LOOP_TICKS / 2 || PARAMS_LINK_STEP_TICKS >= LOOP_TICKS / 2 || \
+    REPLAY_STEP_TICKS >= LOOP_TICKS / 2 || CALIB_TRACK_STEP_TICKS >= LOOP_TICKS / 2
+#error "background steps do not fit the loop slack at LOOP_RATE_HZ"
+#endif
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* CONFIG_H */
@@ -0,0 +1,176 @@
+/*
+ * File:   evlog.c
+ * Author: Kevin Dederer
+ * Comments: lock free binary event log. Writers reserve a slot with a compare
+ *           and swap on the head index, fill it and commit it by writing the
+ *           sequence number last, so interrupts at any priority may log while
+ *           the main loop is writing or draining. Only the main loop drains,
+ *           one step formats a record into a line with a literal format and
+ *           the following steps write it EVLOG_DRAIN_BYTES at a time.
+ * Revision history:
+ */
+
+#include "config.h"
+
+#if (EVLOG_SIZE & (EVLOG_SIZE - 1)) != 0
+#error "EVLOG_SIZE must be a power of 2"
+#endif
+#if EVLOG_DRAIN_BYTES * 10 * CORE_TICKS_PER_US * 1000000 / EVLOG_CONSOLE_BAUD >= EVLOG_DRAIN_TICKS
+#error "EVLOG_DRAIN_BYTES do not fit EVLOG_DRAIN_TICKS at EVLOG_CONSOLE_BAUD"
+#endif
+
+/*
+ * evlog_data - the ring and its indexes
+ * @param ring - the event records
+ * @param head - next sequence number to reserve, written by any context
+ * @param tail - next sequence number to drain, written by the main loop
+ * @param tick - control tick counter stamped into each record
+ * @param dropped - events lost because the ring was full, written by any context
+ * @param line - the formatted record being written, main loop only
+ * @param length - characters in line
+ * @param written - characters of line already written
+ */
+typedef struct
+{
+    volatile evlog_record ring[EVLOG_SIZE];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint16_t tick;
+    volatile unsigned int dropped;
+    char line[EVLOG_LINE];
+    int length;
+    int written;
+} evlog_data;
+
+PRIVATE evlog_data evlog;
+
+#define EVLOG_MESSAGE(id, message, arg) message,
+PRIVATE const char *evlog_message[EVLOG_EVENT_COUNT] = {
+    EVLOG_EVENTS(EVLOG_MESSAGE)
+};
+#undef EVLOG_MESSAGE
+
+#define EVLOG_ARG(id, message, arg) arg,
+PRIVATE const uint8_t evlog_arg[EVLOG_EVENT_COUNT] = {
+    EVLOG_EVENTS(EVLOG_ARG)
+};
+#undef EVLOG_ARG
+
+/*
+ * EVLOG WRITE - logs an event, safe from any interrupt priority
+ * @param id - the event
+ * @param arg - argument printed with the event message
+ */
+void evlog_write(enum evlog_event id, uint32_t arg)
+{
+    uint32_t seq;
+    volatile evlog_record *rec;
+
+    do
+    {
+        seq = evlog.head;
+        if(seq - evlog.tail >= EVLOG_SIZE)
+        {
+            __sync_fetch_and_add(&evlog.dropped, 1);    // writers at other priorities count too
+            return;
+        }
+    } while(!__sync_bool_compare_and_swap(&evlog.head, seq, seq + 1));
+
+    rec = &evlog.ring[seq & (EVLOG_SIZE - 1)];
+    rec->id = id;
+    rec->tick = evlog.tick;
+    rec->time = hal_core_ticks();
+    rec->arg = arg;
+    __sync_synchronize();
+    rec->seq = seq + 1;
+}
+
+/*
+ * EVLOG TICK - advances the tick counter, called at the start of each control tick
+ */
+void evlog_tick(void)
+{
+    evlog.tick++;
+}
+
+/*
+ * EVLOG FORMAT - formats a record into the line
+ * @param *rec - the record
+ * @return the length of the line.
+ */
+PRIVATE int evlog_format(const evlog_record *rec)
+{
+    char *line = evlog.line;
+    unsigned int tick = rec->tick;
+    unsigned long time = rec->time, arg = rec->arg;
+    int n;
+
+    if(rec->id >= EVLOG_EVENT_COUNT)
+        return snprintf(line, EVLOG_LINE, "[%u.%lu] unknown event %u %lu\n", tick, time, rec->id, arg);
+    switch(evlog_arg[rec->id])
+    {
+    case evlog_unsigned:
+        n = snprintf(line, EVLOG_LINE, "[%u.%lu] %s %lu\n", tick, time, evlog_message[rec->id], arg);
+        break;
+    case evlog_signed:
+        n = snprintf(line, EVLOG_LINE, "[%u.%lu] %s %ld\n", tick, time, evlog_message[rec->id],
+                     (long) (int32_t) rec->arg);
+        break;
+    case evlog_hex:
+        n = snprintf(line, EVLOG_LINE, "[%u.%lu] %s 0x%lx\n", tick, time, evlog_message[rec->id], arg);
+        break;
+    default:
+        n = snprintf(line, EVLOG_LINE, "[%u.%lu] %s\n", tick, time, evlog_message[rec->id]);
+        break;
+    }
+    return n;
+}
+
+/*
+ * EVLOG DRAIN - one step of printing the committed records, called from the
+ *              loop slack. A step either formats the oldest record or writes
+ *              up to EVLOG_DRAIN_BYTES of its line, the console blocks for
+ *              each byte so the bytes bound the step to EVLOG_DRAIN_TICKS.
+ * @return 1 if a step was done, 0 if there was nothing to drain.
+ */
+int evlog_drain(void)
+{
+    uint32_t seq = evlog.tail;
+    volatile evlog_record *rec = &evlog.ring[seq & (EVLOG_SIZE - 1)];
+    evlog_record copy;
+    int n;
+
+    if(evlog.written < evlog.length)
+    {
+        n = evlog.length - evlog.written;
+        if(n > EVLOG_DRAIN_BYTES) n = EVLOG_DRAIN_BYTES;
+        fwrite(&evlog.line[evlog.written], 1, n, stdout);
+        evlog.written += n;
+        return 1;
+    }
+
+    if(rec->seq != seq + 1) return 0;   // empty, or reserved but not yet committed
+
+    copy = *rec;
+    evlog.tail = seq + 1;
+
+    n = evlog_format(&copy);
+    if(n < 0) n = 0;
+    if(n >= EVLOG_LINE)
+    {
+        n = EVLOG_LINE - 1;     // cut, the newline goes in place of the last character
+        evlog.line[n - 1] = '\n';
+    }
+    evlog.length = n;
+    evlog.written = 0;
+    return 1;
+}
+
+/*
+ * EVLOG DROPPED - the number of events lost to a full ring
+ * @return the dropped event count.
+ */
+unsigned int evlog_dropped(void)
+{
+    return evlog.dropped;
+}
@@ -0,0 +1,88 @@
+/*
+ * File:   evlog.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the binary event log. Events are written as fixed
+ *           size records to a ram ring at the call site and formatted later
+ *           from the loop slack, a few bytes of the line per step so the
+ *           blocking console output fits the step budget.
+ *           tools/evlog_decode.py reads the event list below, keep one event
+ *           per line.
+ * Revision history:
+ */
+
+#ifndef EVLOG_H
+#define	EVLOG_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define EVLOG_SIZE (64)             // records in the ring, must be a power of 2
+#define EVLOG_DRAIN_TICKS (20000)   // worst case core ticks of a drain step (500us)
+#define EVLOG_LINE (96)             // longest formatted line, longer ones are cut
+#define EVLOG_CONSOLE_BAUD (115200) // the console printf blocks on, one byte in 87us
+#define EVLOG_DRAIN_BYTES (4)       // console bytes per drain step, 350us
+
+// event id, message, how the record argument is printed after the message
+#define EVLOG_EVENTS(X) \
+    X(ev_none,             "no event", evlog_none) \
+    X(ev_i2c_collision,    "I2C XMIT master bus collision, status", evlog_hex) \
+    X(ev_i2c_arbitration,  "I2C ARBITRATION LOSS, status", evlog_hex) \
+    X(ev_i2c_overflow,     "I2C XMIT Overflow, status", evlog_hex) \
+    X(ev_i2c_unspecified,  "I2C XMIT Unspecified error, status", evlog_hex) \
+    X(ev_i2c_clock,        "I2C Bus Clock Frequency error exceeds 10%, hz", evlog_unsigned) \
+    X(ev_i2c_recover,      "I2C bus recovered after error", evlog_signed) \
+    X(ev_overload_mode,    "overload mode changed to", evlog_unsigned) \
+    X(ev_timing_clamped,   "sample interval clamped, us", evlog_unsigned) \
+    X(ev_params_swapped,   "parameter set swapped in, values changed", evlog_unsigned) \
+    X(ev_params_link_baud, "parameter link baud rate error exceeds 2%, baud", evlog_unsigned) \
+    X(ev_idle_overrun,     "background job overran its budget, job", evlog_unsigned) \
+    X(ev_replay_dropped,   "replay log ends, ring full at frame", evlog_unsigned) \
+    X(ev_imu_prime_failed, "no sensor sample to prime the filter, motors held, failed reads", evlog_unsigned) \
+
+/*
+ * evlog_arg - how the argument of an event is printed
+ * evlog_none - not at all
+ * evlog_unsigned, evlog_signed - in decimal
+ * evlog_hex - in hex
+ */
+enum evlog_arg
+{
+    evlog_none, evlog_unsigned, evlog_signed, evlog_hex
+};
+#define EVLOG_ENUM(id, message, arg) id,
+enum evlog_event
+{
+    EVLOG_EVENTS(EVLOG_ENUM)
+    EVLOG_EVENT_COUNT
+};
+#undef EVLOG_ENUM
+
+/*
+ * evlog_record - one logged event, 16 bytes, little endian
+ * @param seq - write sequence number + 1, written last to commit the record
+ * @param id - the evlog_event
+ * @param tick - low 16 bits of the control tick counter
+ * @param time - core timer value within the tick
+ * @param arg - event argument
+ */
+typedef struct
+{
+    uint32_t seq;
+    uint16_t id;
+    uint16_t tick;
+    uint32_t time;
+    uint32_t arg;
+} evlog_record;
+
+FLASH_CALL void evlog_write(enum evlog_event id, uint32_t arg);
+void evlog_tick(void);
+int evlog_drain(void);
+unsigned int evlog_dropped(void);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* EVLOG_H */
+
@@ -0,0 +1,165 @@
+/*
+ * File:   fft.c
+ * Author: Kevin Dederer
+ * Comments: fixed point (Q15) radix-2 fft kernel used by the vibration analyser.
+ *           A real sequence of N points is packed into N/2 complex points, run
+ *           through the complex transform and split back into N/2 power bins.
+ *           Every butterfly stage scales by 1/2 so the result can not overflow.
+ * Revision history:
+ */
+
+#include "config.h"
+
+// one full period of sin() in Q15, FFT_MAX_POINTS entries
+PRIVATE const int16_t sin_table[FFT_MAX_POINTS] = {
+         0,   1608,   3212,   4808,   6393,   7962,   9512,  11039,
+     12539,  14010,  15446,  16846,  18204,  19519,  20787,  22005,
+     23170,  24279,  25329,  26319,  27245,  28105,  28898,  29621,
+     30273,  30852,  31356,  31785,  32137,  32412,  32609,  32728,
+     32767,  32728,  32609,  32412,  32137,  31785,  31356,  30852,
+     30273,  29621,  28898,  28105,  27245,  26319,  25329,  24279,
+     23170,  22005,  20787,  19519,  18204,  16846,  15446,  14010,
+     12539,  11039,   9512,   7962,   6393,   4808,   3212,   1608,
+         0,  -1608,  -3212,  -4808,  -6393,  -7962,  -9512, -11039,
+    -12539, -14010, -15446, -16846, -18204, -19519, -20787, -22005,
+    -23170, -24279, -25329, -26319, -27245, -28105, -28898, -29621,
+    -30273, -30852, -31356, -31785, -32137, -32412, -32609, -32728,
+    -32767, -32728, -32609, -32412, -32137, -31785, -31356, -30852,
+    -30273, -29621, -28898, -28105, -27245, -26319, -25329, -24279,
+    -23170, -22005, -20787, -19519, -18204, -16846, -15446, -14010,
+    -12539, -11039,  -9512,  -7962,  -6393,  -4808,  -3212,  -1608,
+};
+
+/*
+ * FFT SIN Q15 - table lookup of sin(2 * pi * index / FFT_MAX_POINTS)
+ * @param index - the angle in 1/FFT_MAX_POINTS of a turn, wraps around.
+ * @return the sine in Q15.
+ */
+int16_t fft_sin_q15(int index)
+{
+    return sin_table[index & (FFT_MAX_POINTS - 1)];
+}
+
+/*
+ * FFT COS Q15 - table lookup of cos(2 * pi * index / FFT_MAX_POINTS)
+ * @param index - the angle in 1/FFT_MAX_POINTS of a turn, wraps around.
+ * @return the cosine in Q15.
+ */
+int16_t fft_cos_q15(int index)
+{
+    return sin_table[(index + FFT_MAX_POINTS / 4) & (FFT_MAX_POINTS - 1)];
+}
+
+/*
+ * FFT BIT REVERSE - reorders the complex input into bit reversed order in place
+ * @param re - real part of the 2^log2n point sequence
+ * @param im - imaginary part of the 2^log2n point sequence
+ * @param log2n - log2 of the number of complex points
+ */
+void fft_bit_reverse(int16_t *re, int16_t *im, int log2n)
+{
+    int n = 1 << log2n;
+    int i, j = 0, bit;
+    int16_t t;
+
+    for(i = 1; i < n; i++)
+    {
+        bit = n >> 1;
+        while(j & bit)
+        {
+            j ^= bit;
+            bit >>= 1;
+        }
+        j |= bit;
+        if(i < j)
+        {
+            t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+}
+
+/*
+ * FFT STAGE - runs one decimation in time butterfly stage in place. Stages
+ *              are exposed separately so a caller can spread a transform
+ *              over several calls.
+ * @param re - real part of the bit reversed sequence
+ * @param im - imaginary part of the bit reversed sequence
+ * @param log2n - log2 of the number of complex points
+ * @param stage - the stage to run, 0 to log2n - 1
+ */
+void fft_stage(int16_t *re, int16_t *im, int log2n, int stage)
+{
+    int n = 1 << log2n;
+    int half = 1 << stage;
+    int step = FFT_MAX_POINTS >> (stage + 1);   // twiddle table stride for this span
+    int i, j, k;
+    int32_t c, s, tr, ti;
+
+    for(k = 0; k < half; k++)
+    {
+        c = fft_cos_q15(k * step);
+        s = fft_sin_q15(k * step);
+        for(i = k; i < n; i += half << 1)
+        {
+            j = i + half;
+            // t = x[j] * exp(-j * theta)
+            tr = (re[j] * c + im[j] * s) >> 15;
+            ti = (im[j] * c - re[j] * s) >> 15;
+            re[j] = (re[i] - tr) >> 1;
+            im[j] = (im[i] - ti) >> 1;
+            re[i] = (re[i] + tr) >> 1;
+            im[i] = (im[i] + ti) >> 1;
+        }
+    }
+}
+
+/*
+ * FFT COMPLEX Q15 - complete in place complex transform, output scaled by 1/n
+ * @param re - real part of the sequence
+ * @param im - imaginary part of the sequence
+ * @param log2n - log2 of the number of complex points
+ */
+void fft_complex_q15(int16_t *re, int16_t *im, int log2n)
+{
+    int stage;
+
+    fft_bit_reverse(re, im, log2n);
+    for(stage = 0; stage < log2n; stage++)
+        fft_stage(re, im, log2n, stage);
+}
+
+/*
+ * FFT REAL POWER - splits the transform of a packed real sequence into the
+ *              power of each bin of the real transform.
+ *              The real input x[0..2m-1] must have been packed as
+ *              re[n] = x[2n], im[n] = x[2n+1] before the complex transform.
+ * @param re - real part of the complex transform output
+ * @param im - imaginary part of the complex transform output
+ * @param log2n - log2 of the number of complex points (m)
+ * @param power - output, m bins of |X[k]|^2 for k = 0 to m-1 (Q30 / 4). The
+ *              odd part adds to the even part, xr and xi each reach 17 bits
+ *              with the sign, their squares are summed in 64 bits.
+ */
+void fft_real_power(const int16_t *re, const int16_t *im, int log2n, uint32_t *power)
+{
+    int m = 1 << log2n;
+    int step = FFT_MAX_POINTS >> (log2n + 1);   // twiddle stride for 2m points
+    int k, mk;
+    int32_t er, ei, o_r, o_i, c, s, xr, xi;
+
+    for(k = 0; k < m; k++)
+    {
+        mk = (m - k) & (m - 1);
+        // even part (Z[k] + conj(Z[m-k])) / 2, odd part -j(Z[k] - conj(Z[m-k])) / 2
+        er = (re[k] + re[mk]) >> 1;
+        ei = (im[k] - im[mk]) >> 1;
+        o_r = (im[k] + im[mk]) >> 1;
+        o_i = (re[mk] - re[k]) >> 1;
+        c = fft_cos_q15(k * step);
+        s = fft_sin_q15(k * step);
+        xr = er + ((o_r * c + o_i * s) >> 15);
+        xi = ei + ((o_i * c - o_r * s) >> 15);
+        power[k] = ((int64_t) xr * xr + (int64_t) xi * xi) >> 2;
+    }
+}
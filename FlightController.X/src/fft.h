@@ -0,0 +1,30 @@
+/*
+ * File:   fft.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the fixed point radix-2 fft kernel
+ * Revision history:
+ */
+
+#ifndef FFT_H
+#define	FFT_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define FFT_MAX_LOG2 (7)                    // largest supported real transform, 128 points
+#define FFT_MAX_POINTS (1 << FFT_MAX_LOG2)
+
+int16_t fft_sin_q15(int index);
+int16_t fft_cos_q15(int index);
+void fft_bit_reverse(int16_t *re, int16_t *im, int log2n);
+void fft_stage(int16_t *re, int16_t *im, int log2n, int stage);
+void fft_complex_q15(int16_t *re, int16_t *im, int log2n);
+void fft_real_power(const int16_t *re, const int16_t *im, int log2n, uint32_t *power);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* FFT_H */
+
@@ -0,0 +1,80 @@
+/*
+ * File:   fir_coeffs.h
+ * Author: Kevin Dederer
+ * Comments: fir filter coefficient sets for each supported PIPE_SAMPLE_HZ.
+ *           FIR_COEFFS is the 52 tap set, FIR_SHORT_COEFFS the 16 tap set
+ *           used while overloaded, @see pipe_fir. Both are in Q15
+ *           (round(c * 32768)). The sum of the magnitudes of every set is
+ *           below 65536 so a full scale int16 input can not overflow the
+ *           32 bit accumulator. All sets have the same dc gain. The 100hz long
+ *           set is the original design, the others are
+ *           scipy.signal.firwin(taps, 5, fs=PIPE_SAMPLE_HZ) (hamming) scaled to
+ *           that gain. With the tap counts fixed the transition band
+ *           widens as the rate goes up, -3db points:
+ *               rate      52 taps   16 taps
+ *               100hz     4.9hz     4.9hz
+ *               200hz     3.8hz     8.8hz
+ *               400hz     5.6hz     17hz
+ *               800hz     10hz      34hz
+ * Revision history:
+ */
+
+#ifndef FIR_COEFFS_H
+#define	FIR_COEFFS_H
+
+#define FIR_TAPS (52)
+#define FIR_SHORT_TAPS (16)
+#define FIR_SHIFT (15)      // fraction bits of the coefficients
+
+#if PIPE_SAMPLE_HZ == 100
+#define FIR_COEFFS \
+         0,     -2,     -7,    -18,    -36,    -66,   -111,   -171, \
+      -247,   -333,   -421,   -499,   -550,   -555,   -494,   -352, \
+      -116,    217,    639,   1133,   1668,   2209,   2712,   3135, \
+      3441,   3602,   3602,   3441,   3135,   2712,   2209,   1668, \
+      1133,    639,    217,   -116,   -352,   -494,   -555,   -550, \
+      -499,   -421,   -333,   -247,   -171,   -111,    -66,    -36, \
+       -18,     -7,     -2,      0
+#define FIR_SHORT_COEFFS \
+       101,    219,    557,   1167,   2000,   2909,   3688,   4138, \
+      4138,   3688,   2909,   2000,   1167,    557,    219,    101
+#elif PIPE_SAMPLE_HZ == 200
+#define FIR_COEFFS \
+       -24,    -22,    -21,    -19,    -15,     -6,      8,     30, \
+        63,    106,    162,    232,    315,    410,    517,    633, \
+       756,    882,   1008,   1130,   1243,   1345,   1432,   1499, \
+      1546,   1570,   1570,   1546,   1499,   1432,   1345,   1243, \
+      1130,   1008,    882,    756,    633,    517,    410,    315, \
+       232,    162,    106,     63,     30,      8,     -6,    -15, \
+       -19,    -21,    -22,    -24
+#define FIR_SHORT_COEFFS \
+       236,    376,    768,   1373,   2099,   2818,   3395,   3715, \
+      3715,   3395,   2818,   2099,   1373,    768,    376,    236
+#elif PIPE_SAMPLE_HZ == 400
+#define FIR_COEFFS \
+        43,     48,     58,     73,     94,    122,    155,    196, \
+       243,    296,    355,    419,    487,    558,    632,    705, \
+       779,    850,    917,    980,   1036,   1085,   1125,   1157, \
+      1178,   1188,   1188,   1178,   1157,   1125,   1085,   1036, \
+       980,    917,    850,    779,    705,    632,    558,    487, \
+       419,    355,    296,    243,    196,    155,    122,     94, \
+        73,     58,     48,     43
+#define FIR_SHORT_COEFFS \
+       275,    418,    821,   1422,   2119,   2792,   3321,   3611, \
+      3611,   3321,   2792,   2119,   1422,    821,    418,    275
+#elif PIPE_SAMPLE_HZ == 800
+#define FIR_COEFFS \
+        74,     78,     89,    107,    131,    162,    199,    242, \
+       290,    343,    400,    460,    522,    585,    649,    712, \
+       773,    831,    886,    936,    980,   1018,   1050,   1074, \
+      1090,   1099,   1099,   1090,   1074,   1050,   1018,    980, \
+       936,    886,    831,    773,    712,    649,    585,    522, \
+       460,    400,    343,    290,    242,    199,    162,    131, \
+       107,     89,     78,     74
+#define FIR_SHORT_COEFFS \
+       286,    429,    835,   1434,   2124,   2785,   3302,   3586, \
+      3586,   3302,   2785,   2124,   1434,    835,    429,    286
+#endif
+
+#endif	/* FIR_COEFFS_H */
+
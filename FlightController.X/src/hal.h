@@ -0,0 +1,77 @@
+/*
+ * File:   hal.h
+ * Author: Kevin Dederer
+ * Comments: hardware abstraction for the parts of the chip the flight code
+ *           touches directly: the core timer, timers 1 and 2, the motor pins
+ *           on PORTE, the I2C2 and SPI2 primitives, UART1 and their
+ *           interrupts. The PIC32 backend (hal_pic32.h) maps every call
+ *           straight onto plib, the host backend (host/hal_host.h, built with
+ *           HAL_HOST) simulates them on Linux with a fake lsm330 on the I2C
+ *           bus or behind its chip selects on SPI.
+ *
+ *           system
+ *             hal_init()                   - clocks, wait states and cache
+ *             hal_interrupts_enable()      - multi vectored interrupts on
+ *             hal_interrupts_disable()     - all interrupts off, returns the state
+ *             hal_interrupts_restore(state) - back to the state disable returned
+ *             hal_nop()                    - one idle instruction
+ *             hal_idle()                   - waits for the next interrupt, the
+ *                                            peripherals keep running
+ *           core timer, counts at half the system clock
+ *             hal_core_ticks()             - the current count
+ *             hal_core_reset()             - restarts the count at 0
+ *             hal_core_rewind(ticks)       - takes ticks off the count, keeping
+ *                                            the ticks since they were read
+ *             hal_core_alarm(ticks)        - interrupt whenever the count reaches ticks
+ *             hal_core_alarm_clear()       - acknowledges the interrupt
+ *             HAL_CORE_ISR(name)           - defines the interrupt handler
+ *           timers
+ *             hal_timer1_open(period)      - pb/8 tick, interrupt every period
+ *             hal_timer1_clear()           - acknowledges the interrupt
+ *             HAL_TIMER1_ISR(name)         - defines the interrupt handler
+ *             hal_timer2_open(period)      - pb/32 free running count
+ *             hal_timer2_read(), hal_timer2_write(value)
+ *           motor pins
+ *             hal_porte_output(bits)       - makes the bits outputs
+ *             hal_porte_read(), hal_porte_write(value)
+ *           I2C2, every call returns at once, i2c.c bounds the waits
+ *             hal_i2c_configure(freq)      - returns the clock achieved
+ *             hal_i2c_enable(on)
+ *             hal_i2c_start(), hal_i2c_restart() - 0 if the start went out
+ *             hal_i2c_stop()
+ *             hal_i2c_send(byte)           - 0 if the byte was accepted
+ *             hal_i2c_receive()            - starts a receive, nonzero on overflow
+ *             hal_i2c_get(), hal_i2c_ack(ack)
+ *             hal_i2c_idle(), hal_i2c_tx_ready(), hal_i2c_tx_done(),
+ *             hal_i2c_rx_ready(), hal_i2c_ack_done(), hal_i2c_acked()
+ *             hal_i2c_status()             - HAL_I2C_START, HAL_I2C_STOP, ...
+ *             hal_i2c_pins_claim(), hal_i2c_scl(high), hal_i2c_sda(high),
+ *             hal_i2c_pins_release()       - bit banged bus recovery
+ *           SPI2 with its two dma channels, mode 3, chip selects on port G
+ *             hal_spi_open(freq)           - master at freq, the dma channels set up
+ *             hal_spi_cs_open(cs)          - makes the chip select an idle high output
+ *             hal_spi_select(cs), hal_spi_deselect(cs)
+ *             hal_spi_put(byte), hal_spi_rx_ready(), hal_spi_get() - one polled byte
+ *             hal_spi_burst(tx, rx, bytes) - starts a full duplex dma transfer
+ *             hal_spi_burst_done()         - the last byte was received
+ *             hal_spi_burst_abort()        - stops both channels
+ *           UART1, 8N1
+ *             hal_uart_open(baud)          - receive interrupt on, returns the rate achieved
+ *             hal_uart_rx_ready(), hal_uart_read()
+ *             hal_uart_tx_ready(), hal_uart_write(byte)
+ *             hal_uart_clear()             - acknowledges the receive interrupt
+ *             HAL_UART_ISR(name)           - defines the receive interrupt handler
+ * Revision history:
+ */
+
+#ifndef HAL_H
+#define	HAL_H
+
+#ifdef HAL_HOST
+#include "host/hal_host.h"
+#else
+#include "hal_pic32.h"
+#endif
+
+#endif	/* HAL_H */
+
@@ -0,0 +1,199 @@
+/*
+ * File:   hal_pic32.h
+ * Author: Kevin Dederer
+ * Comments: PIC32 backend of the hardware abstraction, @see hal.h. Every
+ *           call is an inline wrapper around plib so the firmware build is
+ *           the same code as before the abstraction.
+ * Revision history:
+ */
+
+#ifndef HAL_PIC32_H
+#define	HAL_PIC32_H
+
+#include <p32xxxx.h>
+#include <xc.h>
+#include <plib.h>
+#include <peripheral/system.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define HAL_I2C_BUS (I2C2)
+#define HAL_UART (UART1)             // U1RX is RD2, U1TX is RD3
+#define HAL_I2C_SCL_BIT (BIT_5)     // SCL2 is RF5
+#define HAL_I2C_SDA_BIT (BIT_4)     // SDA2 is RF4
+#define HAL_SPI_CHN (SPI_CHANNEL2)
+#define HAL_SPI_DMA_TX (DMA_CHANNEL0)
+#define HAL_SPI_DMA_RX (DMA_CHANNEL1)
+
+#define HAL_I2C_START (I2C_START)
+#define HAL_I2C_STOP (I2C_STOP)
+#define HAL_I2C_ARBITRATION_LOSS (I2C_ARBITRATION_LOSS)
+#define HAL_I2C_TRANSMITTER_OVERFLOW (I2C_TRANSMITTER_OVERFLOW)
+#define HAL_I2C_BYTE_ACKNOWLEDGED (I2C_BYTE_ACKNOWLEDGED)
+
+#define HAL_TIMER1_ISR(name) void __ISR(_TIMER_1_VECTOR, IPL7SRS) name(void)
+#define HAL_UART_ISR(name) void __ISR(_UART_1_VECTOR, IPL3SOFT) name(void)
+#define HAL_CORE_ISR(name) void __ISR(_CORE_TIMER_VECTOR, IPL2SOFT) name(void)
+
+static inline void hal_init(void)
+{
+    SYSTEMConfig(GetSystemClock(), SYS_CFG_ALL);
+    SYSTEMConfig(SYS_FREQ, SYS_CFG_WAIT_STATES | SYS_CFG_PCACHE);
+}
+
+static inline void hal_interrupts_enable(void) { INTEnableSystemMultiVectoredInt(); }
+static inline unsigned int hal_interrupts_disable(void) { return INTDisableInterrupts(); }
+static inline void hal_interrupts_restore(unsigned int state) { INTRestoreInterrupts(state); }
+static inline void hal_nop(void) { _nop(); }
+static inline void hal_idle(void) { __asm__ volatile("wait"); }    // OSCCON.SLPEN is 0 from reset, so idle not sleep
+
+// the cp0 builtins instead of the plib functions, the hot path reads the timer from ram
+static inline unsigned int hal_core_ticks(void) { return _CP0_GET_COUNT(); }
+static inline void hal_core_reset(void) { _CP0_SET_COUNT(0); }
+static inline void hal_core_rewind(unsigned int ticks) { _CP0_SET_COUNT(_CP0_GET_COUNT() - ticks); }
+
+static inline void hal_core_alarm(unsigned int ticks)
+{
+    _CP0_SET_COMPARE(ticks);
+    mConfigIntCoreTimer(CT_INT_ON | CT_INT_PRIOR_2);
+}
+
+// the request stays asserted until compare is written, the same value rearms it
+static inline void hal_core_alarm_clear(void)
+{
+    _CP0_SET_COMPARE(_CP0_GET_COMPARE());
+    mCTClearIntFlag();
+}
+
+static inline void hal_timer1_open(unsigned int period)
+{
+    OpenTimer1(T1_ON | T1_SOURCE_INT | T1_PS_1_8, period);
+    ConfigIntTimer1(T1_INT_ON | T1_INT_PRIOR_7);
+}
+
+static inline void hal_timer1_clear(void) { mT1ClearIntFlag(); }
+static inline void hal_timer2_open(unsigned int period) { OpenTimer2(T2_ON | T2_PS_1_32, period); }
+static inline unsigned int hal_timer2_read(void) { return ReadTimer2(); }
+static inline void hal_timer2_write(unsigned int value) { WriteTimer2(value); }
+
+static inline void hal_porte_output(unsigned int bits) { PORTSetPinsDigitalOut(IOPORT_E, bits); }
+static inline unsigned int hal_porte_read(void) { return PORTE; }
+static inline void hal_porte_write(unsigned int value) { PORTE = value; }
+
+static inline unsigned int hal_i2c_configure(unsigned int freq)
+{
+    I2CConfigure(HAL_I2C_BUS, I2C_ENABLE_SLAVE_CLOCK_STRETCHING);
+    return I2CSetFrequency(HAL_I2C_BUS, GetSystemClock(), freq);
+}
+
+static inline void hal_i2c_enable(int on) { I2CEnable(HAL_I2C_BUS, on ? TRUE : FALSE); }
+static inline int hal_i2c_start(void) { return I2CStart(HAL_I2C_BUS) != I2C_SUCCESS; }
+static inline int hal_i2c_restart(void) { return I2CRepeatStart(HAL_I2C_BUS) != I2C_SUCCESS; }
+static inline void hal_i2c_stop(void) { I2CStop(HAL_I2C_BUS); }
+static inline int hal_i2c_send(uint8_t byte) { return I2CSendByte(HAL_I2C_BUS, byte) != I2C_SUCCESS; }
+static inline int hal_i2c_receive(void) { return I2CReceiverEnable(HAL_I2C_BUS, TRUE) == I2C_RECEIVE_OVERFLOW; }
+static inline uint8_t hal_i2c_get(void) { return I2CGetByte(HAL_I2C_BUS); }
+static inline void hal_i2c_ack(int ack) { I2CAcknowledgeByte(HAL_I2C_BUS, ack); }
+
+static inline int hal_i2c_idle(void) { return I2CBusIsIdle(HAL_I2C_BUS); }
+static inline int hal_i2c_tx_ready(void) { return I2CTransmitterIsReady(HAL_I2C_BUS); }
+static inline int hal_i2c_tx_done(void) { return I2CTransmissionHasCompleted(HAL_I2C_BUS); }
+static inline int hal_i2c_rx_ready(void) { return I2CReceivedDataIsAvailable(HAL_I2C_BUS); }
+static inline int hal_i2c_ack_done(void) { return I2CAcknowledgeHasCompleted(HAL_I2C_BUS); }
+static inline int hal_i2c_acked(void) { return I2CByteWasAcknowledged(HAL_I2C_BUS); }
+static inline unsigned int hal_i2c_status(void) { return I2CGetStatus(HAL_I2C_BUS); }
+
+static inline void hal_i2c_pins_claim(void)
+{
+    mPORTFOpenDrainOpen(HAL_I2C_SCL_BIT | HAL_I2C_SDA_BIT);
+    mPORTFSetBits(HAL_I2C_SCL_BIT | HAL_I2C_SDA_BIT);
+    mPORTFSetPinsDigitalOut(HAL_I2C_SCL_BIT);
+    mPORTFSetPinsDigitalIn(HAL_I2C_SDA_BIT);
+}
+
+static inline void hal_i2c_scl(int high)
+{
+    if(high) mPORTFSetBits(HAL_I2C_SCL_BIT);
+    else mPORTFClearBits(HAL_I2C_SCL_BIT);
+}
+
+static inline void hal_i2c_sda(int high)
+{
+    if(high) mPORTFSetBits(HAL_I2C_SDA_BIT);
+    else mPORTFClearBits(HAL_I2C_SDA_BIT);
+    mPORTFSetPinsDigitalOut(HAL_I2C_SDA_BIT);
+}
+
+static inline void hal_i2c_pins_release(void) { mPORTFSetPinsDigitalIn(HAL_I2C_SCL_BIT | HAL_I2C_SDA_BIT); }
+
+static inline void hal_spi_open(unsigned int freq)
+{
+    SpiChnOpen(HAL_SPI_CHN, SPI_OPEN_MSTEN | SPI_OPEN_CKP_HIGH | SPI_OPEN_SMP_END | SPI_OPEN_MODE8,
+               GetPeripheralClock() / freq);
+
+    // rx is paced by received bytes, tx by the empty transmit buffer
+    DmaChnOpen(HAL_SPI_DMA_RX, DMA_CHN_PRI3, DMA_OPEN_DEFAULT);
+    DmaChnSetEventControl(HAL_SPI_DMA_RX, DMA_EV_START_IRQ_EN | DMA_EV_START_IRQ(_SPI2_RX_IRQ));
+    DmaChnOpen(HAL_SPI_DMA_TX, DMA_CHN_PRI2, DMA_OPEN_DEFAULT);
+    DmaChnSetEventControl(HAL_SPI_DMA_TX, DMA_EV_START_IRQ_EN | DMA_EV_START_IRQ(_SPI2_TX_IRQ));
+}
+
+static inline void hal_spi_cs_open(unsigned int cs)
+{
+    mPORTGSetBits(cs);
+    mPORTGSetPinsDigitalOut(cs);
+}
+
+static inline void hal_spi_select(unsigned int cs) { mPORTGClearBits(cs); }
+static inline void hal_spi_deselect(unsigned int cs) { mPORTGSetBits(cs); }
+static inline void hal_spi_put(uint8_t byte) { SpiChnPutC(HAL_SPI_CHN, byte); }
+static inline int hal_spi_rx_ready(void) { return SpiChnDataRdy(HAL_SPI_CHN); }
+static inline uint8_t hal_spi_get(void) { return SpiChnReadC(HAL_SPI_CHN); }
+
+static inline void hal_spi_burst(const uint8_t *tx, uint8_t *rx, int bytes)
+{
+    DmaChnSetTxfer(HAL_SPI_DMA_RX, (void *) &SPI2BUF, rx, 1, bytes, 1);
+    DmaChnSetTxfer(HAL_SPI_DMA_TX, tx, (void *) &SPI2BUF, bytes, 1, 1);
+    DmaChnClrEvFlags(HAL_SPI_DMA_RX, DMA_EV_ALL_EVNTS);
+    DmaChnEnable(HAL_SPI_DMA_RX);
+    DmaChnStartTxfer(HAL_SPI_DMA_TX, DMA_WAIT_NOT, 0);
+}
+
+// the last received byte ends the burst
+static inline int hal_spi_burst_done(void) { return (DmaChnGetEvFlags(HAL_SPI_DMA_RX) & DMA_EV_BLOCK_DONE) != 0; }
+
+static inline void hal_spi_burst_abort(void)
+{
+    DmaChnAbortTxfer(HAL_SPI_DMA_TX);
+    DmaChnAbortTxfer(HAL_SPI_DMA_RX);
+}
+
+static inline unsigned int hal_uart_open(unsigned int baud)
+{
+    unsigned int rate;
+
+    UARTConfigure(HAL_UART, UART_ENABLE_PINS_TX_RX_ONLY | UART_ENABLE_HIGH_SPEED);
+    UARTSetFifoMode(HAL_UART, UART_INTERRUPT_ON_RX_NOT_EMPTY);
+    UARTSetLineControl(HAL_UART, UART_DATA_SIZE_8_BITS | UART_PARITY_NONE | UART_STOP_BITS_1);
+    rate = UARTSetDataRate(HAL_UART, GetPeripheralClock(), baud);
+    UARTEnable(HAL_UART, UART_ENABLE_FLAGS(UART_PERIPHERAL | UART_RX | UART_TX));
+    INTSetVectorPriority(INT_VECTOR_UART(HAL_UART), INT_PRIORITY_LEVEL_3);
+    INTClearFlag(INT_SOURCE_UART_RX(HAL_UART));
+    INTEnable(INT_SOURCE_UART_RX(HAL_UART), INT_ENABLED);
+    return rate;
+}
+
+static inline int hal_uart_rx_ready(void) { return UARTReceivedDataIsAvailable(HAL_UART); }
+static inline uint8_t hal_uart_read(void) { return UARTGetDataByte(HAL_UART); }
+static inline int hal_uart_tx_ready(void) { return UARTTransmitterIsReady(HAL_UART); }
+static inline void hal_uart_write(uint8_t byte) { UARTSendDataByte(HAL_UART, byte); }
+static inline void hal_uart_clear(void) { INTClearFlag(INT_SOURCE_UART_RX(HAL_UART)); }
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* HAL_PIC32_H */
+
@@ -0,0 +1,364 @@
+/*
+ * File:   bench.c
+ * Author: Kevin Dederer
+ * Comments: wall clock benchmark of the control path kernels on the host,
+ *           @see nbproject/Makefile-host.mk. The PROFILE report times the
+ *           kernels with the core timer, which the host only simulates, so
+ *           there it says nothing about speed. This calls every kernel in a
+ *           loop on the real clock instead. A kernel is timed in BENCH_RUNS
+ *           runs of about BENCH_RUN_NS each and the fastest run counts, it
+ *           is the one the rest of the machine disturbed least. The user
+ *           space instructions per call are counted over one more run with
+ *           the hardware counter of perf_event_open(), they hardly move with
+ *           the load of the machine but are null where the counter cannot be
+ *           opened, in most containers and virtual machines.
+ *
+ *           bench                  report only
+ *           bench baseline.txt     also fail if a kernel is more than
+ *                                  BENCH_REGRESSION_PCT slower than its line
+ *           bench -w baseline.txt  write the times as the new baseline
+ * Revision history:
+ */
+
+#define _GNU_SOURCE
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "config.h"
+
+#define BENCH_RUNS (25)
+#define BENCH_RUN_NS (2000000)          // 2ms
+#define BENCH_REGRESSION_PCT (25)       // allowed growth over the baseline, the host is noisy
+#define BENCH_VIBE_HZ (PIPE_SAMPLE_HZ / 5)  // vibration the notch is tuned to
+
+// name, function timed, one call of the kernel each
+#define BENCH_KERNELS(X) \
+    X(convert_accel,  bench_convert) \
+    X(pipe_run_long,  bench_pipe_long) \
+    X(pipe_run_short, bench_pipe_short) \
+    X(trig_atan2,     bench_atan2) \
+    X(libm_atan2f,    bench_atan2f) \
+    X(vibe_notch,     bench_notch) \
+    X(fft_power,      bench_fft) \
+    X(pid_control,    bench_pid) \
+
+/*
+ * bench_data - the inputs the kernels work on, set up once
+ * @param raw - an accelerometer frame as read from the bus
+ * @param lsm330 - zero offsets and sensitivity
+ * @param pipe - filter state
+ * @param block - the samples of a tick
+ * @param notch - notch history
+ * @param re, im, power - the transform of one vibration analysis
+ * @param location - attitude and setpoint
+ * @param engine - the pid state
+ * @param stamp - advancing timestamp for the pid
+ * @param n - call counter, varies the inputs
+ * @param sink - results the compiler must not drop
+ */
+typedef struct
+{
+    uint8_t raw[6];
+    sensor_data lsm330;
+    pipe_state pipe;
+    sensor_block block;
+    notch_state notch;
+    int16_t re[FFT_MAX_POINTS / 2];
+    int16_t im[FFT_MAX_POINTS / 2];
+    uint32_t power[FFT_MAX_POINTS / 2];
+    location_data location;
+    engine_data engine;
+    uint32_t stamp;
+    uint32_t n;
+    volatile int32_t sink;
+} bench_data;
+
+PRIVATE bench_data bench;
+
+PRIVATE void bench_convert(void)
+{
+    bench.raw[0] = bench.n++;
+    convert_accel(bench.raw, &bench.lsm330);
+    bench.sink = bench.lsm330.raw_x;
+}
+
+/*
+ * BENCH BLOCK - fills the block of a tick with a slowly turning gravity vector
+ */
+PRIVATE void bench_block(void)
+{
+    int i;
+
+    bench.n++;
+    bench.block.count = PIPE_DECIMATE;
+    for(i = 0; i < PIPE_DECIMATE; i++)
+    {
+        bench.block.axis[0][i] = (bench.n * 7 + i) & 0x3ff;
+        bench.block.axis[1][i] = (bench.n * 3 + i) & 0x1ff;
+        bench.block.axis[2][i] = 16000 + (bench.n & 0xff);
+    }
+}
+
+PRIVATE void bench_pipe_long(void)
+{
+    bench_block();
+    pipe_run(&bench.pipe, &bench.block, &bench.lsm330, &bench.location, 0);
+    bench.sink = bench.lsm330.out_z;
+}
+
+PRIVATE void bench_pipe_short(void)
+{
+    bench_block();
+    pipe_run(&bench.pipe, &bench.block, &bench.lsm330, &bench.location, 1);
+    bench.sink = bench.lsm330.out_z;
+}
+
+/*
+ * BENCH ATAN2 - the CORDIC angle, and the libm one it replaced on the same
+ *              inputs as floats
+ */
+PRIVATE void bench_atan2(void)
+{
+    bench.n++;
+    bench.sink = trig_atan2((int32_t) (bench.n * 2654435761u) >> 17, 16384);
+}
+
+PRIVATE void bench_atan2f(void)
+{
+    bench.n++;
+    bench.sink = atan2f((int32_t) (bench.n * 2654435761u) >> 17, 16384) * (float) (1 / TRIG_RAD_PER_UNIT);
+}
+
+PRIVATE void bench_notch(void)
+{
+    bench_block();
+    vibe_notch(bench.block.axis[2], bench.block.count, &bench.notch);
+    bench.sink = bench.block.axis[2][0];
+}
+
+/*
+ * BENCH FFT - the transform and power spectrum of one analysis of the
+ *              analyser, from a noisy packed input
+ */
+PRIVATE void bench_fft(void)
+{
+    int n;
+
+    for(n = 0; n < (1 << (VIBE_FFT_LOG2 - 1)); n++)
+    {
+        bench.re[n] = (bench.n * 2654435761u) >> 20;
+        bench.im[n] = (bench.n++ * 40503u) >> 4;
+    }
+    fft_complex_q15(bench.re, bench.im, VIBE_FFT_LOG2 - 1);
+    fft_real_power(bench.re, bench.im, VIBE_FFT_LOG2 - 1, bench.power);
+    bench.sink = bench.power[1];
+}
+
+PRIVATE void bench_pid(void)
+{
+    bench.stamp += LOOP_TICKS;
+    bench.location.predicted.pitch = (bench.n++ & 0xff) * 1e-4f;
+    pid_control_function(&bench.location, &bench.engine, bench.stamp, 0);
+    bench.sink = bench.engine.e1.speed;
+}
+
+/*
+ * bench_kernel - one entry of the kernel table
+ * @param name - name in the report and the baseline
+ * @param call - one call of the kernel
+ * @param ns - measured ns per call
+ * @param instructions - counted instructions per call, negative without a counter
+ * @param baseline - ns per call of the baseline, 0 if it has none
+ */
+typedef struct
+{
+    const char *name;
+    void (*call)(void);
+    double ns;
+    double instructions;
+    double baseline;
+} bench_kernel;
+
+#define BENCH_ENTRY(name, call) { #name, call, 0, -1, 0 },
+PRIVATE bench_kernel kernels[] = { BENCH_KERNELS(BENCH_ENTRY) };
+#undef BENCH_ENTRY
+#define BENCH_COUNT ((int) (sizeof(kernels) / sizeof(kernels[0])))
+
+/*
+ * BENCH NS - the monotonic wall clock
+ * @return nanoseconds.
+ */
+PRIVATE double bench_ns(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/*
+ * BENCH COUNTER OPEN - opens the instruction counter of this thread, user
+ *              space only so it works with perf_event_paranoid up to 2
+ * @return the counter, -1 if there is none.
+ */
+PRIVATE int bench_counter_open(void)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/*
+ * BENCH COUNT - counts the instructions of a run of calls
+ * @param counter - the counter, -1 to skip
+ * @param *k - the kernel, receives the instructions per call
+ * @param calls - calls in the run
+ */
+PRIVATE void bench_count(int counter, bench_kernel *k, unsigned long calls)
+{
+    uint64_t count;
+    unsigned long i;
+
+    if(counter < 0) return;
+    ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+    ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    for(i = 0; i < calls; i++) k->call();
+    ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+    if(read(counter, &count, sizeof(count)) == sizeof(count))
+        k->instructions = (double) count / calls;
+}
+
+/*
+ * BENCH TIME - times a kernel, the calls per run are found first
+ * @param *k - the kernel, receives the time and the instructions
+ * @param counter - the instruction counter, -1 if there is none
+ */
+PRIVATE void bench_time(bench_kernel *k, int counter)
+{
+    unsigned long calls = 1, i;
+    double start, ns, best = 0;
+    int run;
+
+    do
+    {
+        calls *= 2;
+        start = bench_ns();
+        for(i = 0; i < calls; i++) k->call();
+        ns = bench_ns() - start;
+    } while(ns < BENCH_RUN_NS / 4);
+    calls = calls * (BENCH_RUN_NS / ns) + 1;
+
+    for(run = 0; run < BENCH_RUNS; run++)
+    {
+        start = bench_ns();
+        for(i = 0; i < calls; i++) k->call();
+        ns = (bench_ns() - start) / calls;
+        if(run == 0 || ns < best) best = ns;
+    }
+    k->ns = best;
+    bench_count(counter, k, calls);
+}
+
+/*
+ * BENCH LOAD - reads a baseline, one "name ns" line per kernel, # comments
+ * @param *path - the file
+ * @return 0, -1 if it cannot be read.
+ */
+PRIVATE int bench_load(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[128], name[64];
+    double ns;
+    int k;
+
+    if(f == NULL) return -1;
+    while(fgets(line, sizeof(line), f) != NULL)
+    {
+        if(line[0] == '#' || sscanf(line, "%63s %lf", name, &ns) != 2) continue;
+        for(k = 0; k < BENCH_COUNT; k++)
+            if(strcmp(kernels[k].name, name) == 0) kernels[k].baseline = ns;
+    }
+    fclose(f);
+    return 0;
+}
+
+/*
+ * BENCH SAVE - writes the measured times as a baseline
+ * @param *path - the file
+ * @return 0, -1 if it cannot be written.
+ */
+PRIVATE int bench_save(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    int k;
+
+    if(f == NULL) return -1;
+    fprintf(f, "# ns per call of the host kernels, the fastest of %d runs, written by\n"
+               "# make host-bench-baseline. Only valid for the machine that wrote it and\n"
+               "# the default build, make host-bench compares against it. CI measures its\n"
+               "# own from the merge target instead, make host-bench-ci.\n", BENCH_RUNS);
+    for(k = 0; k < BENCH_COUNT; k++)
+        fprintf(f, "%s %.2f\n", kernels[k].name, kernels[k].ns);
+    return fclose(f);
+}
+
+int main(int argc, char **argv)
+{
+    const char *save = (argc == 3 && strcmp(argv[1], "-w") == 0) ? argv[2] : NULL;
+    const char *check = (argc == 2) ? argv[1] : NULL;
+    int k, regression, regressions = 0, counter = bench_counter_open();
+    char instructions[32];
+
+    if(check != NULL && bench_load(check) < 0)
+    {
+        perror(check);
+        return EXIT_FAILURE;
+    }
+
+    bench.raw[4] = 0x40;
+    bench.lsm330.sensitivity = 0.000061f;
+    bench.location.user.accel_z = 1.0;
+    bench_block();
+    pipe_prime(&bench.pipe, &bench.block, &bench.lsm330);
+    // a vibration for the analyser so the notch is tuned and filters
+    for(k = 0; k < 4 * FFT_MAX_POINTS; k++)
+    {
+        vibe_push_sample(2000 * sinf(2 * M_PI * BENCH_VIBE_HZ * k / PIPE_SAMPLE_HZ));
+        while(vibe_step());
+    }
+    if(vibe_peak_hz() == 0) fprintf(stderr, "bench: the notch is not tuned\n");
+
+    printf("{\"bench\":[");
+    for(k = 0; k < BENCH_COUNT; k++)
+    {
+        bench_kernel *b = &kernels[k];
+
+        bench_time(b, counter);
+        regression = b->baseline && b->ns * 100 > b->baseline * (100 + BENCH_REGRESSION_PCT);
+        regressions += regression;
+        if(b->instructions < 0) strcpy(instructions, "null");
+        else snprintf(instructions, sizeof(instructions), "%.1f", b->instructions);
+        printf("%s{\"name\":\"%s\",\"ns_per_call\":%.2f,\"instructions_per_call\":%s,"
+               "\"baseline\":%.2f,\"regression\":%s}",
+               k ? "," : "", b->name, b->ns, instructions, b->baseline, regression ? "true" : "false");
+    }
+    printf("],\"threshold_pct\":%d,\"regressions\":%d}\n", BENCH_REGRESSION_PCT, regressions);
+    if(counter >= 0) close(counter);
+
+    if(save != NULL && bench_save(save) < 0)
+    {
+        perror(save);
+        return EXIT_FAILURE;
+    }
+    return regressions ? EXIT_FAILURE : EXIT_SUCCESS;
+}
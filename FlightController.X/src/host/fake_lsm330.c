@@ -0,0 +1,278 @@
+/*
+ * File:   fake_lsm330.c
+ * Author: Kevin Dederer
+ * Comments: simulated lsm330 for the host backend, @see fake_lsm330.h.
+ * Revision history:
+ */
+
+#include "config.h"
+#include "fake_lsm330.h"
+
+#define FAKE_REG_WHOAMI (0x0f)
+#define FAKE_REG_CTRL5A (0x20)
+#define FAKE_REG_CTRL6A (0x24)
+#define FAKE_REG_CTRL7A (0x25)
+#define FAKE_REG_STATUS_A (0x27)
+#define FAKE_REG_OUT_X_L (0x28)
+#define FAKE_REG_OUT_Z_H (0x2d)
+#define FAKE_REG_FIFO_CTRL (0x2e)
+#define FAKE_REG_FIFO_SRC (0x2f)
+#define FAKE_WHOAMI_ACCEL (0x40)
+#define FAKE_WHOAMI_GYRO (0xd4)
+#define FAKE_STATUS_READY (0x0f)    // zyxda and the three axis bits
+#define FAKE_FIFO_EN (0x40)         // CTRL7A
+#define FAKE_FIFO_MODE (0xe0)       // FIFO_CTRL
+#define FAKE_FIFO_STREAM (0x40)
+#define FAKE_FIFO_EMPTY (0x20)      // FIFO_SRC
+#define FAKE_FIFO_OVRN (0x40)
+
+/*
+ * fake_device - one of the two devices in the package
+ * @param reg - the register file
+ * @param sensor - the package it belongs to
+ * @param next - the register a burst read would read next, for the fifo wrap
+ */
+typedef struct fake_sensor fake_sensor;
+typedef struct
+{
+    uint8_t reg[256];
+    fake_sensor *sensor;
+    int next;
+} fake_device;
+
+/*
+ * fake_sensor - one lsm330 package
+ * @param accel, gyro - the two devices
+ * @param source - the acceleration the accelerometer reports
+ * @param seed - noise state of the source
+ * @param fifo_level - samples waiting in the accelerometer fifo
+ * @param fifo_next_us - simulated time the next sample enters the fifo
+ */
+struct fake_sensor
+{
+    fake_device accel;
+    fake_device gyro;
+    fake_lsm330_source source;
+    uint32_t seed;
+    int fifo_level;
+    uint64_t fifo_next_us;
+};
+
+PRIVATE fake_sensor fake[FAKE_LSM330_COUNT];
+PRIVATE int fakes;
+
+/*
+ * FAKE NOISE - deterministic noise so host runs repeat exactly
+ * @param *seed - the noise state
+ * @return a value in -FAKE_LSM330_NOISE_G..FAKE_LSM330_NOISE_G.
+ */
+PRIVATE float fake_noise(uint32_t *seed)
+{
+    *seed = *seed * 1664525u + 1013904223u;
+    return ((int32_t) *seed / 2147483648.0) * FAKE_LSM330_NOISE_G;
+}
+
+/*
+ * FAKE LSM330 LEVEL - the craft sits level, 1g on z
+ */
+void fake_lsm330_level(uint64_t us, uint32_t *seed, float g[3])
+{
+    (void) us;
+    g[0] = fake_noise(seed);
+    g[1] = fake_noise(seed);
+    g[2] = 1.0 + fake_noise(seed);
+}
+
+/*
+ * FAKE LSM330 VIBRATING - level with a motor vibration on every axis
+ */
+void fake_lsm330_vibrating(uint64_t us, uint32_t *seed, float g[3])
+{
+    float vibe = FAKE_LSM330_VIBE_G * sin(2 * M_PI * FAKE_LSM330_VIBE_HZ * us / 1e6);
+
+    fake_lsm330_level(us, seed, g);
+    g[0] += vibe;
+    g[1] += vibe * 0.5;
+    g[2] += vibe * 0.25;
+}
+
+/*
+ * FAKE LATCH - takes a new sample into the output registers
+ * @param *sensor - the package
+ * @param us - simulated time of the sample
+ */
+PRIVATE void fake_latch(fake_sensor *sensor, uint64_t us)
+{
+    static const float scale_g[8] = { 2, 4, 6, 8, 16, 16, 16, 16 };
+    float g[3], count_g;
+    int32_t counts;
+    int i;
+
+    count_g = 2 * scale_g[(sensor->accel.reg[FAKE_REG_CTRL6A] >> 3) & 7] / 65536.0;
+    sensor->source(us, &sensor->seed, g);
+    for(i = 0; i < 3; i++)
+    {
+        counts = lroundf(g[i] / count_g);
+        counts = (counts > 32767) ? 32767 : (counts < -32768) ? -32768 : counts;
+        sensor->accel.reg[FAKE_REG_OUT_X_L + 2 * i] = counts & 0xff;
+        sensor->accel.reg[FAKE_REG_OUT_X_L + 2 * i + 1] = (counts >> 8) & 0xff;
+    }
+}
+
+/*
+ * FAKE FIFO PERIOD - the sample period set in CTRL5A
+ * @param *sensor - the package
+ * @return the period in microseconds, 0 while powered down.
+ */
+PRIVATE uint64_t fake_fifo_period(fake_sensor *sensor)
+{
+    static const float odr_hz[16] = { 0, 3.125, 6.25, 12.5, 25, 50, 100, 400, 800, 1600 };
+    float hz = odr_hz[sensor->accel.reg[FAKE_REG_CTRL5A] >> 4];
+
+    return (hz > 0) ? (uint64_t)(1e6 / hz) : 0;
+}
+
+/*
+ * FAKE FIFO ON - the fifo is enabled and in stream mode
+ * @param *sensor - the package
+ */
+PRIVATE int fake_fifo_on(fake_sensor *sensor)
+{
+    return (sensor->accel.reg[FAKE_REG_CTRL7A] & FAKE_FIFO_EN) &&
+           (sensor->accel.reg[FAKE_REG_FIFO_CTRL] & FAKE_FIFO_MODE) == FAKE_FIFO_STREAM;
+}
+
+/*
+ * FAKE FIFO FILL - queues the samples taken since the last call, the oldest
+ *              are lost once the fifo is full as in stream mode
+ * @param *sensor - the package
+ */
+PRIVATE void fake_fifo_fill(fake_sensor *sensor)
+{
+    uint64_t now = hal_host_time_us(), period = fake_fifo_period(sensor);
+
+    if(period == 0) return;
+    if(sensor->fifo_next_us == 0) sensor->fifo_next_us = now + period;
+    for(; sensor->fifo_next_us <= now; sensor->fifo_next_us += period)
+        if(sensor->fifo_level <= LSM330_FIFO_DEPTH) sensor->fifo_level++;
+}
+
+/*
+ * FAKE FIFO POP - latches the oldest queued sample, at the time it was taken
+ * @param *sensor - the package
+ */
+PRIVATE void fake_fifo_pop(fake_sensor *sensor)
+{
+    fake_fifo_fill(sensor);
+    if(sensor->fifo_level == 0)
+    {
+        fake_latch(sensor, hal_host_time_us());
+        return;
+    }
+    if(sensor->fifo_level > LSM330_FIFO_DEPTH) sensor->fifo_level = LSM330_FIFO_DEPTH;
+    fake_latch(sensor, sensor->fifo_next_us - sensor->fifo_level * fake_fifo_period(sensor));
+    sensor->fifo_level--;
+}
+
+/*
+ * FAKE FIFO SRC - the FIFO_SRC register, a level above the depth is an overrun
+ * @param *sensor - the package
+ */
+PRIVATE uint8_t fake_fifo_src(fake_sensor *sensor)
+{
+    int level;
+
+    fake_fifo_fill(sensor);
+    level = sensor->fifo_level;
+    if(level > LSM330_FIFO_DEPTH) return FAKE_FIFO_OVRN | (LSM330_FIFO_DEPTH - 1);
+    if(level == LSM330_FIFO_DEPTH) return FAKE_FIFO_OVRN;
+    return (level == 0 ? FAKE_FIFO_EMPTY : 0) | level;
+}
+
+/*
+ * FAKE READ - register read of either device. With the fifo on, a burst read
+ *              of the output registers wraps from OUT_Z_H back to OUT_X_L and
+ *              takes the next sample from the fifo.
+ * @param *ctx - the fake_device
+ * @param reg - register address
+ * @return the register value.
+ */
+PRIVATE uint8_t fake_read(void *ctx, uint8_t reg)
+{
+    fake_device *device = ctx;
+    fake_sensor *sensor = device->sensor;
+    int burst = reg == device->next;
+
+    device->next = reg + 1;
+    if(device == &sensor->accel)
+    {
+        if(fake_fifo_on(sensor))
+        {
+            if(reg == FAKE_REG_FIFO_SRC && !burst) return fake_fifo_src(sensor);
+            if(reg >= FAKE_REG_OUT_X_L && (reg <= FAKE_REG_OUT_Z_H || burst))
+            {
+                reg = FAKE_REG_OUT_X_L + (reg - FAKE_REG_OUT_X_L) % 6;
+                if(reg == FAKE_REG_OUT_X_L) fake_fifo_pop(sensor);
+                return device->reg[reg];
+            }
+        }
+        else if(reg == FAKE_REG_OUT_X_L) fake_latch(sensor, hal_host_time_us());
+        if(reg == FAKE_REG_STATUS_A) return FAKE_STATUS_READY;
+    }
+    return device->reg[reg];
+}
+
+/*
+ * FAKE WRITE - register write of either device
+ * @param *ctx - the fake_device
+ * @param reg - register address
+ * @param value - the new value
+ */
+PRIVATE void fake_write(void *ctx, uint8_t reg, uint8_t value)
+{
+    fake_device *device = ctx;
+
+    if(reg == FAKE_REG_WHOAMI || reg == FAKE_REG_FIFO_SRC ||
+       (reg >= FAKE_REG_OUT_X_L && reg <= FAKE_REG_OUT_Z_H))
+        return;     // read only
+    device->reg[reg] = value;
+    if(device == &device->sensor->accel && reg == FAKE_REG_FIFO_CTRL)
+    {
+        device->sensor->fifo_level = 0;     // bypass empties it, stream starts empty
+        device->sensor->fifo_next_us = hal_host_time_us() + fake_fifo_period(device->sensor);
+    }
+}
+
+/*
+ * FAKE LSM330 ATTACH - puts one more lsm330 on the transport of the build,
+ *              the I2C bus or the chip selects of the spi port
+ * @param *accel, *gyro - where the two devices sit
+ * @param source - the acceleration it reports
+ * @param seed - start of its noise sequence
+ * @return 0, or -1 if no sensor, address or chip select is left.
+ */
+int fake_lsm330_attach(const lsm330_bus *accel, const lsm330_bus *gyro, fake_lsm330_source source, uint32_t seed)
+{
+    fake_sensor *sensor;
+    hal_i2c_device accel_device = { accel->addr, fake_read, fake_write, NULL };
+    hal_i2c_device gyro_device = { gyro->addr, fake_read, fake_write, NULL };
+
+    if(fakes >= FAKE_LSM330_COUNT) return -1;
+    sensor = &fake[fakes];
+    sensor->accel.sensor = sensor;
+    sensor->accel.reg[FAKE_REG_WHOAMI] = FAKE_WHOAMI_ACCEL;
+    sensor->gyro.sensor = sensor;
+    sensor->gyro.reg[FAKE_REG_WHOAMI] = FAKE_WHOAMI_GYRO;
+    sensor->source = source;
+    sensor->seed = seed;
+
+    accel_device.ctx = &sensor->accel;
+    gyro_device.ctx = &sensor->gyro;
+#ifdef LSM330_USE_SPI
+    if(hal_host_attach_spi(accel->cs, &accel_device) < 0 || hal_host_attach_spi(gyro->cs, &gyro_device) < 0) return -1;
+#else
+    if(hal_host_attach_i2c(&accel_device) < 0 || hal_host_attach_i2c(&gyro_device) < 0) return -1;
+#endif
+    fakes++;
+    return 0;
+}
@@ -0,0 +1,45 @@
+/*
+ * File:   fake_lsm330.h
+ * Author: Kevin Dederer
+ * Comments: simulated lsm330 for the host backend. The accelerometer and the
+ *           gyro answer on I2C or SPI with their whoami values, keep every
+ *           register written to them and always report a new sample. The
+ *           sample is taken from a source function at the simulated time the
+ *           output registers are read and scaled with the full scale set in
+ *           CTRL6A, so the driver reads it exactly as from a real sensor. In
+ *           fifo stream mode samples are queued at the rate set in CTRL5A
+ *           and each one is taken at the simulated time it was queued.
+ * Revision history:
+ */
+
+#ifndef FAKE_LSM330_H
+#define	FAKE_LSM330_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define FAKE_LSM330_COUNT (3)       // sensors that can be attached
+#define FAKE_LSM330_NOISE_G (0.002) // peak noise of the built in sources
+#define FAKE_LSM330_VIBE_G (0.3)    // amplitude of the vibrating source
+#define FAKE_LSM330_VIBE_HZ (83.0)  // frequency of the vibrating source
+
+/*
+ * fake_lsm330_source - produces the acceleration the sensor feels
+ * @param us - simulated time of the sample
+ * @param seed - noise state, one per sensor
+ * @param g - receives x, y and z in g
+ */
+typedef void (*fake_lsm330_source)(uint64_t us, uint32_t *seed, float g[3]);
+
+void fake_lsm330_level(uint64_t us, uint32_t *seed, float g[3]);
+void fake_lsm330_vibrating(uint64_t us, uint32_t *seed, float g[3]);
+
+int fake_lsm330_attach(const lsm330_bus *accel, const lsm330_bus *gyro, fake_lsm330_source source, uint32_t seed);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* FAKE_LSM330_H */
+
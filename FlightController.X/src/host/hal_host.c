@@ -0,0 +1,798 @@
+/*
+ * File:   hal_host.c
+ * Author: Kevin Dederer
+ * Comments: Linux backend of the hardware abstraction, @see hal_host.h.
+ *           Simulated time is kept in core timer ticks since start. Timers 1
+ *           and 2 are derived from it with the target prescalers, the I2C
+ *           bus advances it by the bit time of every condition and byte and
+ *           SPI by the bit time of every byte.
+ * Revision history:
+ */
+
+#define _GNU_SOURCE
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "config.h"
+#include "fake_lsm330.h"
+
+#define HOST_CORE_PER_PB (GetSystemClock() / 2 / GetPeripheralClock())   // core ticks per pb tick
+#define HOST_TIMER1_PRESCALE (8)
+#define HOST_TIMER2_PRESCALE (32)
+#define HOST_I2C_AUTO_INCREMENT (0x80)
+#define HOST_SPI_READ (0x80)
+#define HOST_SPI_REGISTER (0x3f)
+#define HOST_PACE_TICKS (CORE_TICKS_PER_US * 1000)     // simulated time between checks of the wall clock
+
+// set by HAL_TIMER1_ISR and HAL_UART_ISR in the firmware, absent in a harness without them
+extern void (*const hal_timer1_handler)(void) __attribute__((weak));
+extern void (*const hal_uart_handler)(void) __attribute__((weak));
+extern void (*const hal_core_handler)(void) __attribute__((weak));
+
+/*
+ * host_i2c - the simulated bus
+ * @param device - the attached devices
+ * @param absent - the device does not answer its address, for fault tests
+ * @param devices - number of attached devices
+ * @param bit_ticks - core ticks per bit at the configured clock
+ * @param target - the device addressed by the current transfer, or NULL
+ * @param reg - the register pointer of the target
+ * @param expect - what the next byte sent is, the address, the register
+ *              pointer or data
+ * @param read - the current transfer reads from the target
+ * @param acked - the last byte sent was acknowledged
+ * @param rx - the byte received
+ * @param rx_ready - rx has not been taken yet
+ * @param status - HAL_I2C_START and HAL_I2C_STOP of the last condition
+ * @param stuck - clocks on SCL a slave still holds SDA low for, a start
+ *              collides until they are given, for fault tests
+ * @param starts, stops - start, restart and stop conditions put on the bus
+ */
+typedef struct
+{
+    hal_i2c_device device[HAL_HOST_I2C_DEVICES];
+    int absent[HAL_HOST_I2C_DEVICES];
+    int devices;
+    uint64_t bit_ticks;
+    const hal_i2c_device *target;
+    uint8_t reg;
+    enum { expect_address, expect_register, expect_data } expect;
+    int read;
+    int acked;
+    uint8_t rx;
+    int rx_ready;
+    unsigned int status;
+    int stuck;
+    unsigned int starts;
+    unsigned int stops;
+} host_i2c;
+
+/*
+ * host_spi - the simulated spi port. Both lsm330 devices increment the
+ *              register in a burst once configured, the simulation always
+ *              does and ignores the increment bit.
+ * @param device - the attached devices, addr is not used
+ * @param cs - the chip select of each device
+ * @param devices - number of attached devices
+ * @param byte_ticks - core ticks per byte at the configured clock
+ * @param target - the selected device, or NULL
+ * @param reg - the register pointer of the target
+ * @param command - the next byte is the command byte of a transfer
+ * @param read - the current transfer reads from the target
+ * @param rx, rx_ready - the byte received by the last polled transfer
+ * @param burst_due - now at which the dma burst ends, 0 when none runs
+ */
+typedef struct
+{
+    hal_i2c_device device[HAL_HOST_SPI_DEVICES];
+    unsigned int cs[HAL_HOST_SPI_DEVICES];
+    int devices;
+    uint64_t byte_ticks;
+    const hal_i2c_device *target;
+    uint8_t reg;
+    int command;
+    int read;
+    uint8_t rx;
+    int rx_ready;
+    uint64_t burst_due;
+} host_spi;
+
+/*
+ * host_uart - the pseudo terminal behind UART1
+ * @param fd - the master side, -1 until the uart is opened
+ * @param slave - the slave side, kept open so the master works before a
+ *              client connects
+ * @param rx, rx_ready - a byte read ahead from the terminal
+ * @param poll - now at which the terminal is looked at next
+ */
+typedef struct
+{
+    int fd;
+    int slave;
+    uint8_t rx;
+    int rx_ready;
+    uint64_t poll;
+} host_uart;
+
+/*
+ * host_data - the simulated chip
+ * @param now - core ticks since start, never wraps
+ * @param end - now at which the run stops
+ * @param core_base - now at the last core timer reset
+ * @param alarm - core timer count of the alarm interrupt, 0 when off
+ * @param alarm_due - now at which the alarm fires next, 0 once it fired
+ * @param interrupts - interrupts are enabled
+ * @param in_isr - an interrupt handler is running
+ * @param t1_period, t1_next - timer 1 period and due time in core ticks, 0 when off
+ * @param t2_period, t2_base - timer 2 period register and start time
+ * @param porte, porte_output - the port latch and its output pins
+ * @param i2c - the bus
+ * @param spi - the spi port
+ * @param uart - the serial port
+ * @param realtime - simulated time is held back to the wall clock
+ * @param pace_next - now at which the wall clock is compared next
+ * @param wall_start - the wall clock at start
+ */
+typedef struct
+{
+    uint64_t now;
+    uint64_t end;
+    uint64_t core_base;
+    unsigned int alarm;
+    uint64_t alarm_due;
+    int interrupts;
+    int in_isr;
+    uint64_t t1_period;
+    uint64_t t1_next;
+    unsigned int t2_period;
+    uint64_t t2_base;
+    unsigned int porte;
+    unsigned int porte_output;
+    host_i2c i2c;
+    host_spi spi;
+    host_uart uart;
+    int realtime;
+    uint64_t pace_next;
+    struct timespec wall_start;
+} host_data;
+
+PRIVATE host_data host = { .uart = { .fd = -1 } };
+
+/*
+ * HOST PACE - sleeps while simulated time is ahead of the wall clock
+ */
+PRIVATE void host_pace(void)
+{
+    struct timespec wall, wait;
+    double ahead;
+
+    clock_gettime(CLOCK_MONOTONIC, &wall);
+    ahead = host.now / (GetSystemClock() / 2.0) -
+            ((wall.tv_sec - host.wall_start.tv_sec) + (wall.tv_nsec - host.wall_start.tv_nsec) / 1e9);
+    if(ahead <= 0) return;
+    wait.tv_sec = (time_t) ahead;
+    wait.tv_nsec = (long) ((ahead - wait.tv_sec) * 1e9);
+    nanosleep(&wait, NULL);
+}
+
+/*
+ * HOST UART FILL - reads a byte ahead from the terminal if none is waiting
+ * @return 1 if a byte is waiting.
+ */
+PRIVATE int host_uart_fill(void)
+{
+    if(!host.uart.rx_ready && host.uart.fd >= 0 && read(host.uart.fd, &host.uart.rx, 1) == 1)
+        host.uart.rx_ready = 1;
+    return host.uart.rx_ready;
+}
+
+/*
+ * HOST ADVANCE - moves simulated time forward, delivers the timer 1
+ *              interrupts that came due and ends the run at its limit
+ * @param ticks - core ticks to advance
+ */
+PRIVATE void host_advance(uint64_t ticks)
+{
+    host.now += ticks;
+    if(host.end && host.now >= host.end)
+    {
+        fprintf(stderr, "host: %.3f simulated seconds\n", host.now / (GetSystemClock() / 2.0));
+        exit(EXIT_SUCCESS);
+    }
+    if(host.realtime && host.now >= host.pace_next)
+    {
+        host.pace_next += HOST_PACE_TICKS;
+        host_pace();
+    }
+    if(host.in_isr || !host.interrupts)
+        return;
+
+    host.in_isr = 1;
+    if(host.alarm_due && host.now >= host.alarm_due)
+    {
+        host.alarm_due = 0;
+        if(hal_core_handler)
+            hal_core_handler();
+    }
+    while(host.t1_period && host.now >= host.t1_next)
+    {
+        host.t1_next += host.t1_period;
+        if(hal_timer1_handler)
+            hal_timer1_handler();
+    }
+    if(host.uart.fd >= 0 && host.now >= host.uart.poll)
+    {
+        host.uart.poll = host.now + HAL_HOST_UART_POLL_US * CORE_TICKS_PER_US;
+        if(hal_uart_handler && host_uart_fill())
+            hal_uart_handler();
+    }
+    host.in_isr = 0;
+}
+
+/*
+ * HAL HOST SETUP - attaches the devices of a normal board, one fake lsm330
+ *              per imu. A harness can define its own to attach other devices.
+ */
+__attribute__((weak)) void hal_host_setup(void)
+{
+    static const lsm330_bus accel[3] = {
+        { LSM330_DEV_ACCEL, IMU1_CS_ACCEL }, { LSM330_DEV_ACCEL_ALT, IMU2_CS_ACCEL }, { LSM330_DEV_ACCEL, IMU3_CS_ACCEL } };
+    static const lsm330_bus gyro[3] = {
+        { LSM330_DEV_GYRO, IMU1_CS_GYRO }, { LSM330_DEV_GYRO_ALT, IMU2_CS_GYRO }, { LSM330_DEV_GYRO, IMU3_CS_GYRO } };
+    const char *signal = getenv("FC_HOST_IMU");
+    fake_lsm330_source source = fake_lsm330_level;
+    int i;
+
+    if(signal != NULL && strcmp(signal, "vibrating") == 0)
+        source = fake_lsm330_vibrating;
+    for(i = 0; i < IMU_COUNT; i++)
+        fake_lsm330_attach(&accel[i], &gyro[i], source, i + 1);
+}
+
+void hal_init(void)
+{
+    const char *seconds = getenv("FC_HOST_SECONDS");
+
+    if(host.end) return;
+    host.end = (seconds ? atof(seconds) : HAL_HOST_SECONDS) * (GetSystemClock() / 2);
+    host.realtime = getenv("FC_HOST_REALTIME") != NULL;
+    clock_gettime(CLOCK_MONOTONIC, &host.wall_start);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    hal_host_setup();
+}
+
+void hal_interrupts_enable(void)
+{
+    host.interrupts = 1;
+}
+
+unsigned int hal_interrupts_disable(void)
+{
+    unsigned int state = host.interrupts;
+
+    host.interrupts = 0;
+    return state;
+}
+
+void hal_interrupts_restore(unsigned int state)
+{
+    host.interrupts = state;
+}
+
+void hal_nop(void)
+{
+    host_advance(1);
+}
+
+void hal_idle(void)
+{
+    uint64_t next = host.end;
+
+    if(host.t1_period && host.t1_next < next) next = host.t1_next;
+    if(host.alarm_due && host.alarm_due < next) next = host.alarm_due;
+    if(host.uart.fd >= 0 && host.uart.poll < next) next = host.uart.poll;
+    host_advance(next > host.now ? next - host.now : 1);
+}
+
+unsigned int hal_core_ticks(void)
+{
+    host_advance(HAL_HOST_READ_TICKS);
+    return (unsigned int) (host.now - host.core_base);
+}
+
+void hal_core_reset(void)
+{
+    host.core_base = host.now;
+    host.alarm_due = host.alarm ? host.core_base + host.alarm : 0;
+}
+
+void hal_core_rewind(unsigned int ticks)
+{
+    host.core_base += ticks;
+    host.alarm_due = (host.alarm && host.now - host.core_base < host.alarm) ? host.core_base + host.alarm : 0;
+}
+
+void hal_core_alarm(unsigned int ticks)
+{
+    host.alarm = ticks;
+    host.alarm_due = (ticks && host.now - host.core_base < ticks) ? host.core_base + ticks : 0;
+}
+
+void hal_core_alarm_clear(void)
+{
+}
+
+void hal_timer1_open(unsigned int period)
+{
+    host.t1_period = (uint64_t) period * HOST_TIMER1_PRESCALE * HOST_CORE_PER_PB;
+    host.t1_next = host.now + host.t1_period;
+}
+
+void hal_timer1_clear(void)
+{
+}
+
+void hal_timer2_open(unsigned int period)
+{
+    host.t2_period = period;
+    host.t2_base = host.now;
+}
+
+unsigned int hal_timer2_read(void)
+{
+    uint64_t count = (host.now - host.t2_base) / (HOST_TIMER2_PRESCALE * HOST_CORE_PER_PB);
+
+    return count % ((uint64_t) host.t2_period + 1);
+}
+
+void hal_timer2_write(unsigned int value)
+{
+    host.t2_base = host.now - (uint64_t) value * HOST_TIMER2_PRESCALE * HOST_CORE_PER_PB;
+}
+
+void hal_porte_output(unsigned int bits)
+{
+    host.porte_output |= bits;
+}
+
+unsigned int hal_porte_read(void)
+{
+    return host.porte;
+}
+
+void hal_porte_write(unsigned int value)
+{
+    host.porte = value & host.porte_output;
+}
+
+/*
+ * HAL HOST ATTACH I2C - puts a device on the simulated bus
+ * @param *device - the device, copied
+ * @return 0, or -1 if the bus is full or the address is taken.
+ */
+int hal_host_attach_i2c(const hal_i2c_device *device)
+{
+    int i;
+
+    if(host.i2c.devices >= HAL_HOST_I2C_DEVICES) return -1;
+    for(i = 0; i < host.i2c.devices; i++)
+        if(host.i2c.device[i].addr == device->addr) return -1;
+    host.i2c.device[host.i2c.devices++] = *device;
+    return 0;
+}
+
+/*
+ * HAL HOST ATTACH SPI - puts a device behind a chip select of the spi port
+ * @param cs - its chip select bit on port G
+ * @param *device - the device, copied
+ * @return 0, or -1 if the port is full or the chip select is taken.
+ */
+int hal_host_attach_spi(unsigned int cs, const hal_i2c_device *device)
+{
+    int i;
+
+    if(host.spi.devices >= HAL_HOST_SPI_DEVICES || cs == 0) return -1;
+    for(i = 0; i < host.spi.devices; i++)
+        if(host.spi.cs[i] & cs) return -1;
+    host.spi.cs[host.spi.devices] = cs;
+    host.spi.device[host.spi.devices++] = *device;
+    return 0;
+}
+
+/*
+ * HAL HOST I2C ABSENT - takes an attached device off the bus or puts it back,
+ *              an absent device does not acknowledge its address
+ * @param addr - the 7 bit address
+ * @param absent - nonzero to take it off
+ * @return 0, or -1 if no device has the address.
+ */
+int hal_host_i2c_absent(uint8_t addr, int absent)
+{
+    int i;
+
+    for(i = 0; i < host.i2c.devices; i++)
+    {
+        if(host.i2c.device[i].addr != addr) continue;
+        host.i2c.absent[i] = absent;
+        return 0;
+    }
+    return -1;
+}
+
+/*
+ * HAL HOST I2C STUCK - a slave holds SDA low part way through a byte, as
+ *              after a reset in the middle of a read
+ * @param clocks - rising edges of SCL until it lets go, at most 9
+ */
+void hal_host_i2c_stuck(int clocks)
+{
+    host.i2c.stuck = clocks;
+}
+
+/*
+ * HAL HOST I2C CONDITIONS - the start and stop conditions put on the bus
+ * @param *starts - receives the starts and restarts
+ * @param *stops - receives the stops
+ */
+void hal_host_i2c_conditions(unsigned int *starts, unsigned int *stops)
+{
+    *starts = host.i2c.starts;
+    *stops = host.i2c.stops;
+}
+
+/*
+ * HAL HOST WAIT US - lets simulated time pass, delivering the interrupts
+ *              that come due
+ * @param us - microseconds to wait
+ */
+void hal_host_wait_us(uint32_t us)
+{
+    host_advance((uint64_t) us * CORE_TICKS_PER_US);
+}
+
+/*
+ * HAL HOST TIME US - simulated time since start
+ * @return microseconds.
+ */
+uint64_t hal_host_time_us(void)
+{
+    return host.now / CORE_TICKS_PER_US;
+}
+
+/*
+ * HAL HOST REPLAY MAP - maps the log named by FC_HOST_REPLAY read only, the
+ *              pages are only read in as the replay reaches them
+ * @param *bytes - receives the size of the log
+ * @return the start of the log, NULL if there is none.
+ */
+const void *hal_host_replay_map(size_t *bytes)
+{
+    const char *path = getenv("FC_HOST_REPLAY");
+    struct stat st;
+    void *log;
+    int fd;
+
+    if(path == NULL) return NULL;
+    fd = open(path, O_RDONLY);
+    if(fd < 0 || fstat(fd, &st) < 0 || st.st_size == 0)
+    {
+        perror("host: replay");
+        if(fd >= 0) close(fd);
+        return NULL;
+    }
+    log = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(log == MAP_FAILED) return NULL;
+    madvise(log, st.st_size, MADV_SEQUENTIAL);
+    *bytes = st.st_size;
+    return log;
+}
+
+/*
+ * HAL HOST RECORD WRITE - appends to the log named by FC_HOST_RECORD, the
+ *              file is created by the first write and flushed at exit
+ * @param *data - the bytes to append
+ * @param bytes - their number
+ * @return 0, -1 without FC_HOST_RECORD or if the write failed.
+ */
+int hal_host_record_write(const void *data, size_t bytes)
+{
+    static FILE *log;
+    const char *path = getenv("FC_HOST_RECORD");
+
+    if(log == NULL && path != NULL && (log = fopen(path, "wb")) == NULL)
+        perror("host: record");
+    if(log == NULL) return -1;
+    return fwrite(data, bytes, 1, log) == 1 ? 0 : -1;
+}
+
+unsigned int hal_i2c_configure(unsigned int freq)
+{
+    host.i2c.bit_ticks = (GetSystemClock() / 2) / freq;
+    return freq;
+}
+
+void hal_i2c_enable(int on)
+{
+    (void) on;
+    host.i2c.target = NULL;
+}
+
+int hal_i2c_start(void)
+{
+    if(host.i2c.stuck)
+    {
+        host_advance(host.i2c.bit_ticks);
+        return -1;      // sda is low, the start collides
+    }
+    host.i2c.status = HAL_I2C_START;
+    host.i2c.starts++;
+    host.i2c.expect = expect_address;
+    host.i2c.target = NULL;
+    host_advance(host.i2c.bit_ticks);
+    return 0;
+}
+
+int hal_i2c_restart(void)
+{
+    return hal_i2c_start();
+}
+
+void hal_i2c_stop(void)
+{
+    host.i2c.status = HAL_I2C_STOP;
+    host.i2c.stops++;
+    host.i2c.target = NULL;
+    host_advance(host.i2c.bit_ticks);
+}
+
+int hal_i2c_send(uint8_t byte)
+{
+    host_i2c *bus = &host.i2c;
+    int i;
+
+    host_advance(9 * bus->bit_ticks);
+    switch(bus->expect)
+    {
+        case expect_address:
+            bus->target = NULL;
+            for(i = 0; i < bus->devices; i++)
+                if(bus->device[i].addr == byte >> 1 && !bus->absent[i])
+                    bus->target = &bus->device[i];
+            bus->read = byte & 1;
+            bus->expect = bus->read ? expect_data : expect_register;
+            break;
+        case expect_register:
+            bus->reg = byte;
+            bus->expect = expect_data;
+            break;
+        case expect_data:
+            if(bus->target != NULL && !bus->read)
+            {
+                bus->target->write(bus->target->ctx, bus->reg & ~HOST_I2C_AUTO_INCREMENT, byte);
+                if(bus->reg & HOST_I2C_AUTO_INCREMENT) bus->reg++;
+            }
+            break;
+    }
+    bus->acked = bus->target != NULL;
+    return 0;
+}
+
+int hal_i2c_receive(void)
+{
+    host_i2c *bus = &host.i2c;
+
+    host_advance(9 * bus->bit_ticks);
+    bus->rx = 0xff;     // nothing drives the bus
+    if(bus->target != NULL && bus->read)
+    {
+        bus->rx = bus->target->read(bus->target->ctx, bus->reg & ~HOST_I2C_AUTO_INCREMENT);
+        if(bus->reg & HOST_I2C_AUTO_INCREMENT) bus->reg++;
+    }
+    bus->rx_ready = 1;
+    return 0;
+}
+
+uint8_t hal_i2c_get(void)
+{
+    host.i2c.rx_ready = 0;
+    return host.i2c.rx;
+}
+
+void hal_i2c_ack(int ack)
+{
+    (void) ack;
+}
+
+int hal_i2c_idle(void) { return 1; }
+int hal_i2c_tx_ready(void) { return 1; }
+int hal_i2c_tx_done(void) { return 1; }
+int hal_i2c_rx_ready(void) { return host.i2c.rx_ready; }
+int hal_i2c_ack_done(void) { return 1; }
+int hal_i2c_acked(void) { return host.i2c.acked; }
+
+unsigned int hal_i2c_status(void)
+{
+    return host.i2c.status | (host.i2c.acked ? 0 : HAL_I2C_BYTE_ACKNOWLEDGED);
+}
+
+void hal_i2c_pins_claim(void)
+{
+    host.i2c.target = NULL;
+}
+
+void hal_i2c_scl(int high)
+{
+    if(high && host.i2c.stuck) host.i2c.stuck--;
+    host_advance(1);
+}
+
+void hal_i2c_sda(int high)
+{
+    (void) high;
+    host_advance(1);
+}
+
+void hal_i2c_pins_release(void)
+{
+}
+
+/*
+ * HOST SPI BYTE - one full duplex byte with the selected device, the first
+ *              of a transfer is the command with the read bit and register
+ * @param out - the byte sent
+ * @return the byte received, 0xff when nothing drives the line.
+ */
+PRIVATE uint8_t host_spi_byte(uint8_t out)
+{
+    host_spi *port = &host.spi;
+    uint8_t in = 0xff;
+
+    if(port->target == NULL) return in;
+    if(port->command)
+    {
+        port->read = out & HOST_SPI_READ;
+        port->reg = out & HOST_SPI_REGISTER;
+        port->command = 0;
+    }
+    else if(port->read)
+        in = port->target->read(port->target->ctx, port->reg++);
+    else
+        port->target->write(port->target->ctx, port->reg++, out);
+    return in;
+}
+
+void hal_spi_open(unsigned int freq)
+{
+    host.spi.byte_ticks = 8 * (GetSystemClock() / 2) / freq;
+}
+
+void hal_spi_cs_open(unsigned int cs)
+{
+    (void) cs;
+}
+
+void hal_spi_select(unsigned int cs)
+{
+    int i;
+
+    host.spi.target = NULL;
+    for(i = 0; i < host.spi.devices; i++)
+        if(host.spi.cs[i] & cs) host.spi.target = &host.spi.device[i];
+    host.spi.command = 1;
+}
+
+void hal_spi_deselect(unsigned int cs)
+{
+    (void) cs;
+    host.spi.target = NULL;
+}
+
+void hal_spi_put(uint8_t byte)
+{
+    host.spi.rx = host_spi_byte(byte);
+    host.spi.rx_ready = 1;
+    host_advance(host.spi.byte_ticks);
+}
+
+int hal_spi_rx_ready(void)
+{
+    return host.spi.rx_ready;
+}
+
+uint8_t hal_spi_get(void)
+{
+    host.spi.rx_ready = 0;
+    return host.spi.rx;
+}
+
+/*
+ * HAL SPI BURST - the dma moves the whole burst at once, it only counts as
+ *              done once the time of its bytes has passed
+ */
+void hal_spi_burst(const uint8_t *tx, uint8_t *rx, int bytes)
+{
+    int i;
+
+    for(i = 0; i < bytes; i++)
+        rx[i] = host_spi_byte(tx[i]);
+    host.spi.burst_due = host.now + bytes * host.spi.byte_ticks;
+}
+
+int hal_spi_burst_done(void)
+{
+    return host.spi.burst_due && host.now >= host.spi.burst_due;
+}
+
+void hal_spi_burst_abort(void)
+{
+    host.spi.burst_due = 0;
+}
+
+/*
+ * HAL UART OPEN - opens a pseudo terminal in raw mode as UART1 and prints
+ *              its name, the baud rate has no meaning on the host
+ */
+unsigned int hal_uart_open(unsigned int baud)
+{
+    const char *link = getenv("FC_HOST_PTY");
+    struct termios raw;
+    int fd;
+
+    if(host.uart.fd >= 0) return baud;
+    fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if(fd < 0 || grantpt(fd) < 0 || unlockpt(fd) < 0)
+    {
+        perror("host: uart");
+        return 0;
+    }
+    host.uart.slave = open(ptsname(fd), O_RDWR | O_NOCTTY);
+    if(host.uart.slave >= 0 && tcgetattr(host.uart.slave, &raw) == 0)
+    {
+        cfmakeraw(&raw);
+        tcsetattr(host.uart.slave, TCSANOW, &raw);
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    host.uart.fd = fd;
+    if(link != NULL)
+    {
+        unlink(link);
+        if(symlink(ptsname(fd), link) < 0) perror("host: uart link");
+    }
+    fprintf(stderr, "host: uart on %s\n", link != NULL ? link : ptsname(fd));
+    return baud;
+}
+
+int hal_uart_rx_ready(void)
+{
+    return host_uart_fill();
+}
+
+uint8_t hal_uart_read(void)
+{
+    host_uart_fill();
+    host.uart.rx_ready = 0;
+    return host.uart.rx;
+}
+
+int hal_uart_tx_ready(void)
+{
+    struct pollfd p = { host.uart.fd, POLLOUT, 0 };
+
+    return host.uart.fd >= 0 && poll(&p, 1, 0) == 1 && (p.revents & POLLOUT);
+}
+
+void hal_uart_write(uint8_t byte)
+{
+    if(write(host.uart.fd, &byte, 1) != 1)
+        fprintf(stderr, "host: uart byte lost\n");
+}
+
+void hal_uart_clear(void)
+{
+}
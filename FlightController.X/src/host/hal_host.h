@@ -0,0 +1,190 @@
+/*
+ * File:   hal_host.h
+ * Author: Kevin Dederer
+ * Comments: Linux backend of the hardware abstraction, @see hal.h. Time is
+ *           simulated: the core timer only moves when the firmware looks at
+ *           it, idles or uses the bus, so the control code itself takes no
+ *           simulated time and the loop runs as fast as the host allows.
+ *           Timer 1 and core timer interrupts are delivered from those same
+ *           points, hal_idle() jumps to the next of them. The
+ *           I2C2 bus carries the devices attached with hal_host_attach_i2c,
+ *           SPI2 those attached with hal_host_attach_spi, by default one fake
+ *           lsm330 per imu on the transport of the build, @see fake_lsm330.h. Tests
+ *           can take a device off it or have a slave hold SDA low. UART1
+ *           is a pseudo terminal, its receive interrupt is delivered when
+ *           the other end has written to it.
+ *
+ *           FC_HOST_SECONDS  - simulated seconds to run before exiting, 10
+ *           FC_HOST_IMU      - signal of the fake lsm330s, level or vibrating
+ *           FC_HOST_REALTIME - if set, simulated time does not run ahead of
+ *                              the wall clock, for talking to the uart
+ *           FC_HOST_PTY      - path of a link made to the uart terminal
+ *           FC_HOST_RECORD   - path of the log a RECORD build writes
+ *           FC_HOST_REPLAY   - path of the log a REPLAY build maps, @see replay.h
+ * Revision history:
+ */
+
+#ifndef HAL_HOST_H
+#define	HAL_HOST_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#if defined(RC_SBUS)
+#error "the host backend has no SBUS receiver, build without RC_SBUS"
+#endif
+
+#define HAL_HOST_I2C_DEVICES (8)    // devices that can be attached to the bus
+#define HAL_HOST_SPI_DEVICES (8)    // devices that can be attached to the spi port
+#define HAL_HOST_READ_TICKS (20)    // core ticks a look at the core timer takes
+#define HAL_HOST_SECONDS (10)       // default simulated run time
+#define HAL_HOST_UART_POLL_US (100) // simulated time between looks at the uart terminal
+#define HAL_HOST_STACK_BYTES (65536) // stack below main() the watermark covers, @see stack.c
+
+// plib basics the firmware uses without the hardware
+#define PRIVATE static
+#define TRUE (1)
+#define FALSE (0)
+typedef uint8_t UINT8;
+#define __longramfunc__             // no flash and ram split on the host
+#define __longcall__
+
+#define BIT_0 (1 << 0)
+#define BIT_1 (1 << 1)
+#define BIT_2 (1 << 2)
+#define BIT_3 (1 << 3)
+#define BIT_4 (1 << 4)
+#define BIT_5 (1 << 5)
+#define BIT_6 (1 << 6)
+#define BIT_7 (1 << 7)
+#define BIT_8 (1 << 8)
+#define BIT_9 (1 << 9)
+#define BIT_10 (1 << 10)
+#define BIT_11 (1 << 11)
+#define BIT_12 (1 << 12)
+#define BIT_13 (1 << 13)
+#define BIT_14 (1 << 14)
+#define BIT_15 (1 << 15)
+
+#define HAL_I2C_START (1 << 3)
+#define HAL_I2C_STOP (1 << 4)
+#define HAL_I2C_ARBITRATION_LOSS (1 << 10)
+#define HAL_I2C_TRANSMITTER_OVERFLOW (1 << 6)
+#define HAL_I2C_BYTE_ACKNOWLEDGED (1 << 15)
+
+// the handler is found through hal_timer1_handler, the name only matters to the target
+#define HAL_TIMER1_ISR(name) \
+    void name(void); \
+    void (*const hal_timer1_handler)(void) = name; \
+    void name(void)
+#define HAL_UART_ISR(name) \
+    void name(void); \
+    void (*const hal_uart_handler)(void) = name; \
+    void name(void)
+#define HAL_CORE_ISR(name) \
+    void name(void); \
+    void (*const hal_core_handler)(void) = name; \
+    void name(void)
+
+/*
+ * hal_i2c_device - a device on the simulated bus. The register pointer is
+ *              set by the first byte written after the address, bit 7 of it
+ *              asks for auto increment as on the lsm330.
+ * @param addr - the 7 bit address
+ * @param read - returns the register value
+ * @param write - stores a register value
+ * @param ctx - passed back to read and write
+ */
+typedef struct
+{
+    uint8_t addr;
+    uint8_t (*read)(void *ctx, uint8_t reg);
+    void (*write)(void *ctx, uint8_t reg, uint8_t value);
+    void *ctx;
+} hal_i2c_device;
+
+void hal_init(void);
+void hal_interrupts_enable(void);
+unsigned int hal_interrupts_disable(void);
+void hal_interrupts_restore(unsigned int state);
+void hal_nop(void);
+void hal_idle(void);
+
+unsigned int hal_core_ticks(void);
+void hal_core_reset(void);
+void hal_core_rewind(unsigned int ticks);
+void hal_core_alarm(unsigned int ticks);
+void hal_core_alarm_clear(void);
+
+void hal_timer1_open(unsigned int period);
+void hal_timer1_clear(void);
+void hal_timer2_open(unsigned int period);
+unsigned int hal_timer2_read(void);
+void hal_timer2_write(unsigned int value);
+
+void hal_porte_output(unsigned int bits);
+unsigned int hal_porte_read(void);
+void hal_porte_write(unsigned int value);
+
+unsigned int hal_i2c_configure(unsigned int freq);
+void hal_i2c_enable(int on);
+int hal_i2c_start(void);
+int hal_i2c_restart(void);
+void hal_i2c_stop(void);
+int hal_i2c_send(uint8_t byte);
+int hal_i2c_receive(void);
+uint8_t hal_i2c_get(void);
+void hal_i2c_ack(int ack);
+int hal_i2c_idle(void);
+int hal_i2c_tx_ready(void);
+int hal_i2c_tx_done(void);
+int hal_i2c_rx_ready(void);
+int hal_i2c_ack_done(void);
+int hal_i2c_acked(void);
+unsigned int hal_i2c_status(void);
+void hal_i2c_pins_claim(void);
+void hal_i2c_scl(int high);
+void hal_i2c_sda(int high);
+void hal_i2c_pins_release(void);
+
+void hal_spi_open(unsigned int freq);
+void hal_spi_cs_open(unsigned int cs);
+void hal_spi_select(unsigned int cs);
+void hal_spi_deselect(unsigned int cs);
+void hal_spi_put(uint8_t byte);
+int hal_spi_rx_ready(void);
+uint8_t hal_spi_get(void);
+void hal_spi_burst(const uint8_t *tx, uint8_t *rx, int bytes);
+int hal_spi_burst_done(void);
+void hal_spi_burst_abort(void);
+
+unsigned int hal_uart_open(unsigned int baud);
+int hal_uart_rx_ready(void);
+uint8_t hal_uart_read(void);
+int hal_uart_tx_ready(void);
+void hal_uart_write(uint8_t byte);
+void hal_uart_clear(void);
+
+// host only
+void hal_host_setup(void);
+int hal_host_attach_i2c(const hal_i2c_device *device);
+int hal_host_attach_spi(unsigned int cs, const hal_i2c_device *device);
+int hal_host_i2c_absent(uint8_t addr, int absent);
+void hal_host_i2c_stuck(int clocks);
+void hal_host_i2c_conditions(unsigned int *starts, unsigned int *stops);
+void hal_host_wait_us(uint32_t us);
+uint64_t hal_host_time_us(void);
+const void *hal_host_replay_map(size_t *bytes);
+int hal_host_record_write(const void *data, size_t bytes);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* HAL_HOST_H */
+
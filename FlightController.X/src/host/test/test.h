@@ -0,0 +1,58 @@
+/*
+ * File:   test.h
+ * Author: Kevin Dederer
+ * Comments: checks for the host tests, @see nbproject/Makefile-host.mk. A
+ *           test is one program with its own main() linked with the firmware
+ *           objects but main.o. It reports every failed check and exits
+ *           nonzero through test_result() if any failed.
+ * Revision history:
+ */
+
+#ifndef TEST_H
+#define	TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+PRIVATE int test_checks;
+PRIVATE int test_failures;
+
+/*
+ * TEST CHECK - counts a check and reports it if it failed
+ * @param ok - the check passed
+ * @param what - the checked expression
+ * @param line - where it is
+ * @return ok
+ */
+__attribute__((unused)) PRIVATE int test_check(int ok, const char *what, int line)
+{
+    test_checks++;
+    if(!ok)
+    {
+        test_failures++;
+        fprintf(stderr, "%s:%d: check failed: %s\n", __BASE_FILE__, line, what);
+    }
+    return ok;
+}
+
+#define TEST_CHECK(cond) test_check((cond) != 0, #cond, __LINE__)
+
+/*
+ * TEST RESULT - prints the count of checks
+ * @return the exit status of the test.
+ */
+PRIVATE int test_result(void)
+{
+    printf("%s: %d checks, %d failed\n", __BASE_FILE__, test_checks, test_failures);
+    return test_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* TEST_H */
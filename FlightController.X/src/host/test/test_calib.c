@@ -0,0 +1,94 @@
+/*
+ * File:   test_calib.c
+ * Author: Kevin Dederer
+ * Comments: host test of the in flight offset tracking. The loop side only
+ *           queues readings, the offsets have to move by CALIB_TRACK_GAIN of
+ *           the difference once the job has taken a whole steady window, and
+ *           not at all for a window broken by an unsteady tick or by a job
+ *           that fell a whole ring behind.
+ * Revision history:
+ */
+
+#include "config.h"
+#include "test.h"
+
+#define TEST_SENSITIVITY (0.000061f)    // g per count
+
+/*
+ * TEST PUSH - queues readings and runs the job after each, as the slack would
+ * @param *lsm330 - the reading and the offsets
+ * @param count - readings to queue
+ * @param steady - the ticks are steady
+ * @param steps - job steps after each reading
+ */
+PRIVATE void test_push(sensor_data *lsm330, int count, int steady, int steps)
+{
+    int i;
+
+    while(count-- > 0)
+    {
+        calib_track_push(lsm330, steady);
+        for(i = 0; i < steps; i++)
+            calib_track_step();
+    }
+}
+
+/*
+ * TEST SAME - whether the offsets are unchanged
+ * @param *lsm330 - the offsets
+ * @param *before - the offsets to compare with
+ * @return nonzero if they are the same.
+ */
+PRIVATE int test_same(const sensor_data *lsm330, const sensor_data *before)
+{
+    return lsm330->zero_x == before->zero_x && lsm330->zero_y == before->zero_y &&
+           lsm330->zero_z == before->zero_z;
+}
+
+int main(void)
+{
+    float scale = (1 << LSM330_ZERO_SHIFT) / TEST_SENSITIVITY;
+    sensor_data lsm330 = { .sensitivity = TEST_SENSITIVITY, .raw_x = 200, .raw_y = -100 };
+    sensor_data before;
+
+    lsm330.raw_z = lroundf(1 / TEST_SENSITIVITY) + 50;
+    TEST_CHECK(calib_track_step() == 0);
+
+    // a window short of one reading changes nothing, the last reading applies it
+    before = lsm330;
+    test_push(&lsm330, CALIB_TRACK_WINDOW - 1, 1, 1);
+    TEST_CHECK(test_same(&lsm330, &before));
+    TEST_CHECK(calib_track_step() == 0);
+    test_push(&lsm330, 1, 1, 1);
+    TEST_CHECK(lsm330.zero_x == lroundf(CALIB_TRACK_GAIN * (-200 * TEST_SENSITIVITY) * scale));
+    TEST_CHECK(lsm330.zero_y == lroundf(CALIB_TRACK_GAIN * (100 * TEST_SENSITIVITY) * scale));
+    TEST_CHECK(labs(lsm330.zero_z - lroundf(CALIB_TRACK_GAIN * (1 - lsm330.raw_z * TEST_SENSITIVITY) * scale)) <= 1);
+
+    // an unsteady tick starts the window over
+    before = lsm330;
+    test_push(&lsm330, CALIB_TRACK_WINDOW - 1, 1, 1);
+    test_push(&lsm330, 1, 0, 1);
+    test_push(&lsm330, CALIB_TRACK_WINDOW - 1, 1, 1);
+    TEST_CHECK(test_same(&lsm330, &before));
+    test_push(&lsm330, 1, 1, 1);
+    TEST_CHECK(!test_same(&lsm330, &before));
+
+    // the queue holds the readings while the job waits
+    before = lsm330;
+    test_push(&lsm330, CALIB_TRACK_WINDOW - CALIB_TRACK_RING, 1, 1);
+    test_push(&lsm330, CALIB_TRACK_RING, 1, 0);
+    TEST_CHECK(test_same(&lsm330, &before));
+    while(calib_track_step());
+    TEST_CHECK(!test_same(&lsm330, &before));
+
+    // a job a whole ring behind loses readings, that window is not used
+    before = lsm330;
+    test_push(&lsm330, CALIB_TRACK_WINDOW - CALIB_TRACK_RING, 1, 1);
+    test_push(&lsm330, CALIB_TRACK_RING + 1, 1, 0);
+    while(calib_track_step());
+    test_push(&lsm330, CALIB_TRACK_WINDOW - 1, 1, 1);
+    TEST_CHECK(test_same(&lsm330, &before));
+    test_push(&lsm330, 1, 1, 1);
+    TEST_CHECK(!test_same(&lsm330, &before));
+    return test_result();
+}
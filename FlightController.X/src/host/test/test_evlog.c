@@ -0,0 +1,125 @@
+/*
+ * File:   test_evlog.c
+ * Author: Kevin Dederer
+ * Comments: host test of the event log under contention. Writer threads
+ *           stand for interrupts at different priorities and log as fast as
+ *           they can while a drainer thread, the main loop, prints into a
+ *           file. The ring fills up all the time, so every event has to be
+ *           either printed once, whole and in the order of its writer, or
+ *           counted as dropped, with nothing lost between the two.
+ * Revision history:
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include "config.h"
+#include "test.h"
+
+#define TEST_WRITERS (4)
+#define TEST_EVENTS (200000)        // per writer
+#define TEST_EVENT (ev_overload_mode)
+#define TEST_YIELD (16)             // events between yields, on a single core the threads only mix so
+
+#define TEST_MESSAGE(id, message, arg) [id] = message,
+PRIVATE const char *test_message[EVLOG_EVENT_COUNT] = { EVLOG_EVENTS(TEST_MESSAGE) };
+#undef TEST_MESSAGE
+
+/*
+ * test_data - state shared by the threads
+ * @param writing - writers not done yet
+ * @param log - the file the drainer prints into
+ */
+typedef struct
+{
+    volatile int writing;
+    FILE *log;
+} test_data;
+
+PRIVATE test_data test = { .writing = TEST_WRITERS };
+
+/*
+ * TEST WRITER - an interrupt, logs TEST_EVENTS numbered events
+ * @param arg - the writer number
+ */
+PRIVATE void *test_writer(void *arg)
+{
+    uint32_t writer = (uintptr_t) arg, n;
+
+    for(n = 0; n < TEST_EVENTS; n++)
+    {
+        evlog_write(TEST_EVENT, writer << 24 | n);
+        if(n % (TEST_YIELD + writer) == 0) sched_yield();
+    }
+    __sync_fetch_and_sub(&test.writing, 1);
+    return NULL;
+}
+
+/*
+ * TEST DRAINER - the main loop, drains into the log file until the writers
+ *              are done and the ring is empty
+ */
+PRIVATE void *test_drainer(void *arg)
+{
+    (void) arg;
+    while(test.writing > 0)
+        evlog_drain();
+    while(evlog_drain());
+    return NULL;
+}
+
+int main(void)
+{
+    pthread_t writer[TEST_WRITERS], drainer;
+    const char *message = test_message[TEST_EVENT];
+    long last[TEST_WRITERS];
+    unsigned long arg, printed = 0, torn = 0, order = 0, total;
+    char line[EVLOG_LINE + 8], *at;
+    FILE *out = stdout;
+    uintptr_t i;
+
+    test.log = tmpfile();
+    if(!TEST_CHECK(test.log != NULL)) return test_result();
+    fflush(stdout);
+    stdout = test.log;
+    TEST_CHECK(pthread_create(&drainer, NULL, test_drainer, NULL) == 0);
+    for(i = 0; i < TEST_WRITERS; i++)
+        TEST_CHECK(pthread_create(&writer[i], NULL, test_writer, (void *) i) == 0);
+    for(i = 0; i < TEST_WRITERS; i++)
+        pthread_join(writer[i], NULL);
+    pthread_join(drainer, NULL);
+    stdout = out;
+
+    // every printed event whole and after the one before it of its writer
+    for(i = 0; i < TEST_WRITERS; i++)
+        last[i] = -1;
+    rewind(test.log);
+    while(fgets(line, sizeof(line), test.log) != NULL)
+    {
+        at = strstr(line, message);
+        if(at == NULL)
+        {
+            torn++;
+            continue;
+        }
+        arg = strtoul(at + strlen(message), NULL, 10);
+        i = arg >> 24;
+        if(i >= TEST_WRITERS || (arg & 0xffffff) >= TEST_EVENTS)
+        {
+            torn++;
+            continue;
+        }
+        if((long) (arg & 0xffffff) <= last[i]) order++;
+        last[i] = arg & 0xffffff;
+        printed++;
+    }
+    fclose(test.log);
+
+    total = (unsigned long) TEST_WRITERS * TEST_EVENTS;
+    printf("evlog: %lu events, %lu printed, %u dropped\n", total, printed, evlog_dropped());
+    TEST_CHECK(torn == 0);
+    TEST_CHECK(order == 0);
+    TEST_CHECK(printed > 0 && evlog_dropped() > 0);
+    TEST_CHECK(printed + evlog_dropped() == total);
+    return test_result();
+}
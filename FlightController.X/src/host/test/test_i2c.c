@@ -0,0 +1,84 @@
+/*
+ * File:   test_i2c.c
+ * Author: Kevin Dederer
+ * Comments: host test of the i2c error paths. An absent slave has to end as
+ *           a nack without a bus recovery and well inside the transaction
+ *           budget, a slave holding SDA low has to be freed by the recovery
+ *           so the next transaction works, and a sensor read has to stay
+ *           inside LSM330_READ_WORST_US whatever the bus does. An spi build
+ *           has the lsm330s off the i2c bus, there is nothing to test then.
+ * Revision history:
+ */
+
+#include "config.h"
+#include "test.h"
+
+#ifndef LSM330_USE_SPI
+#define TEST_WHOAMI (0x0f)
+#define TEST_WHOAMI_ACCEL (0x40)
+
+PRIVATE const lsm330_bus accel = { LSM330_DEV_ACCEL, 0 };
+
+/*
+ * TEST READ - reads the accelerometer whoami and times it
+ * @param *us - receives the simulated time the read took
+ * @return the result of the read.
+ */
+PRIVATE int test_read(uint64_t *us)
+{
+    uint64_t start = hal_host_time_us();
+    uint8_t whoami = 0;
+    int rc = lsm330_read_reg(&accel, TEST_WHOAMI, &whoami);
+
+    *us = hal_host_time_us() - start;
+    if(rc == i2c_ok) TEST_CHECK(whoami == TEST_WHOAMI_ACCEL);
+    return rc;
+}
+
+int main(void)
+{
+    const i2c_status *status = i2c_get_status();
+    lsm330_dev dev = { .accel = accel, .accel_sensitivity = 1 };
+    sensor_data sample;
+    unsigned int recoveries, starts, stops, starts_after, stops_after;
+    uint64_t start, us;
+
+    hal_host_setup();
+    TEST_CHECK(test_read(&us) == i2c_ok);
+
+    // absent, a nack with the bus stopped once after each address try
+    hal_host_i2c_absent(LSM330_DEV_ACCEL, 1);
+    recoveries = status->recoveries;
+    hal_host_i2c_conditions(&starts, &stops);
+    TEST_CHECK(test_read(&us) == i2c_nack);
+    TEST_CHECK(status->recoveries == recoveries);
+    hal_host_i2c_conditions(&starts_after, &stops_after);
+    TEST_CHECK(starts_after - starts > 1);
+    TEST_CHECK(stops_after - stops == starts_after - starts);
+    TEST_CHECK(us < I2C_TRANSACTION_US);
+    start = hal_host_time_us();
+    TEST_CHECK(read_accel(&dev, &sample) < 0);
+    TEST_CHECK(hal_host_time_us() - start <= LSM330_READ_WORST_US);
+    hal_host_i2c_absent(LSM330_DEV_ACCEL, 0);
+    TEST_CHECK(test_read(&us) == i2c_ok);
+
+    // sda held low, the start collides and the recovery clocks it free
+    hal_host_i2c_stuck(5);
+    TEST_CHECK(test_read(&us) == i2c_collision);
+    TEST_CHECK(status->recoveries == recoveries + 1);
+    TEST_CHECK(us < I2C_WORST_CASE_US);
+    TEST_CHECK(test_read(&us) == i2c_ok);
+    start = hal_host_time_us();
+    hal_host_i2c_stuck(9);
+    TEST_CHECK(read_accel(&dev, &sample) < 0);
+    TEST_CHECK(hal_host_time_us() - start <= LSM330_READ_WORST_US);
+    TEST_CHECK(read_accel(&dev, &sample) == 0);
+
+    return test_result();
+}
+#else
+int main(void)
+{
+    return test_result();
+}
+#endif /* LSM330_USE_SPI */
@@ -0,0 +1,98 @@
+/*
+ * File:   test_imu.c
+ * Author: Kevin Dederer
+ * Comments: host test of the imu vote. The fake lsm330s are taken off the bus
+ *           for a while and put back: the last voter must stay in the vote
+ *           through the outage and every imu must vote again after it. With
+ *           two imus a dropped one must come back while the one left voting
+ *           cannot read, there is no vote to compare it with then. An spi
+ *           device cannot be taken off, there is no acknowledge to miss,
+ *           so an spi build only checks that every imu votes.
+ * Revision history:
+ */
+
+#include "config.h"
+#include "test.h"
+
+#define TEST_TICK_US (1000000 / LOOP_RATE_HZ)
+#define TEST_ALL ((1u << IMU_COUNT) - 1)
+
+PRIVATE const uint8_t accel[2] = { LSM330_DEV_ACCEL, LSM330_DEV_ACCEL_ALT };
+PRIVATE const uint8_t gyro[2] = { LSM330_DEV_GYRO, LSM330_DEV_GYRO_ALT };
+
+/*
+ * TEST ABSENT - takes the lsm330 of an imu off the bus or puts it back
+ * @param i - the imu
+ * @param absent - nonzero to take it off
+ */
+PRIVATE void test_absent(int i, int absent)
+{
+    hal_host_i2c_absent(accel[i], absent);
+    hal_host_i2c_absent(gyro[i], absent);
+}
+
+/*
+ * TEST TICKS - runs control ticks of imu reads
+ * @param ticks - how many
+ * @return the ticks a block was produced.
+ */
+PRIVATE int test_ticks(int ticks)
+{
+    sensor_block block;
+    int read = 0;
+
+    while(ticks-- > 0)
+    {
+        hal_host_wait_us(TEST_TICK_US);
+        read += imu_read(&block) == 0;
+    }
+    return read;
+}
+
+int main(void)
+{
+    const imu_status *status = imu_get_status();
+    sensor_data lsm330;
+    int i;
+
+    hal_host_setup();
+    if(!TEST_CHECK(imu_open(&lsm330) == 0)) return test_result();
+    TEST_CHECK(status->voting == TEST_ALL);
+    TEST_CHECK(test_ticks(10) == 10);
+#ifdef LSM330_USE_SPI
+    (void) i;
+    return test_result();
+#endif
+
+    // every imu gone, the last voter stays
+    for(i = 0; i < IMU_COUNT; i++) test_absent(i, 1);
+    TEST_CHECK(test_ticks(IMU_FAULT_TICKS * 3) == 0);
+    TEST_CHECK(status->voting != 0);
+    TEST_CHECK(status->faults[IMU_COUNT - 1] == 0);
+
+    // back, the voter reads at once, the dropped ones after IMU_RECOVER_TICKS
+    for(i = 0; i < IMU_COUNT; i++) test_absent(i, 0);
+    TEST_CHECK(test_ticks(1) == 1);
+    TEST_CHECK(test_ticks(IMU_RECOVER_TICKS + 1) == IMU_RECOVER_TICKS + 1);
+    TEST_CHECK(status->voting == TEST_ALL);
+
+#if IMU_COUNT >= 2
+    // the second one dropped, then the first one fails and the second one
+    // has only its own reads to show it is back
+    test_absent(1, 1);
+    test_ticks(IMU_FAULT_TICKS + 1);
+    TEST_CHECK(status->voting == 1);
+    test_absent(0, 1);
+    test_absent(1, 0);
+    test_ticks(IMU_RECOVER_TICKS + 1);
+    TEST_CHECK(status->voting & 2);
+    test_ticks(IMU_FAULT_TICKS + 1);
+    TEST_CHECK(status->voting == 2);
+    TEST_CHECK(test_ticks(10) == 10);
+    test_absent(0, 0);
+    test_ticks(IMU_RECOVER_TICKS + 1);
+    TEST_CHECK(status->voting == TEST_ALL);
+#endif
+
+    return test_result();
+}
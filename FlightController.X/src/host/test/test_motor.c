@@ -0,0 +1,201 @@
+/*
+ * File:   test_motor.c
+ * Author: Kevin Dederer
+ * Comments: host stress test of the motor command handoff. On the target the
+ *           pwm interrupt preempts the control loop, here a writer thread
+ *           publishes as fast as it can while a reader thread latches on
+ *           another core, which tears far more copies than the target ever
+ *           could. Publish n carries the speeds n, n + 1, n + 2, n + 3, so a
+ *           latched command mixing two publishes is seen at once, and the
+ *           latched publishes must never go backwards. The simulated clock
+ *           behind the stamps is shared by both threads unlocked, the stamps
+ *           are not checked there. A second part runs the aligned pwm on
+ *           the simulated clock alone and publishes at every tick of the
+ *           period, early and late in the tick, checking motor_latch_wait_s()
+ *           against the delay motor_delay_add() measures.
+ * Revision history:
+ */
+
+#include <pthread.h>
+#include "config.h"
+#include "test.h"
+
+#define TEST_PUBLISHES (2000000)
+#define TEST_WAIT_SLACK_US (40)     // a start is seen by the next timer 1 interrupt, 32us apart
+
+/*
+ * test_data - counts shared by the two threads
+ * @param done - the writer has published everything
+ * @param latched - latches that returned a command
+ * @param stale - latches that kept the previous command
+ * @param torn - latched commands mixing two publishes
+ * @param backwards - latched commands older than the one before
+ */
+typedef struct
+{
+    volatile int done;
+    unsigned long latched;
+    unsigned long stale;
+    unsigned long torn;
+    unsigned long backwards;
+} test_data;
+
+PRIVATE test_data test;
+
+/*
+ * TEST WRITER - the control loop, publishes TEST_PUBLISHES command sets
+ */
+PRIVATE void *test_writer(void *arg)
+{
+    engine_data engine;
+    int n;
+
+    (void) arg;
+    for(n = 1; n <= TEST_PUBLISHES; n++)
+    {
+        engine.e1.speed = n;
+        engine.e2.speed = n + 1;
+        engine.e3.speed = n + 2;
+        engine.e4.speed = n + 3;
+        motor_publish(&engine);
+    }
+    __sync_synchronize();
+    test.done = 1;
+    return NULL;
+}
+
+/*
+ * TEST READER - the pwm interrupt, latches until the writer is done
+ */
+PRIVATE void *test_reader(void *arg)
+{
+    motor_command command;
+    int i, last = 0;
+
+    (void) arg;
+    while(!test.done)
+    {
+        if(motor_latch(&command) < 0)
+        {
+            test.stale++;
+            continue;
+        }
+        test.latched++;
+        if(command.speed[0] == 0) continue;     // nothing published yet
+        for(i = 1; i < MOTORS; i++)
+            if(command.speed[i] != command.speed[0] + i) break;
+        if(i < MOTORS) test.torn++;
+        if(command.speed[0] < last) test.backwards++;
+        last = command.speed[0];
+    }
+    return NULL;
+}
+
+/*
+ * __ISR() TestPwmHandler() - the period start and latch of pwm_update(),
+ *                      without the pulses
+ */
+HAL_TIMER1_ISR(TestPwmHandler)
+{
+    static motor_command command;
+
+    hal_timer1_clear();
+    if(motor_period_start(hal_timer2_read() + 5, 0))
+    {
+        motor_latch(&command);
+        hal_timer2_write(0);
+    }
+}
+
+/*
+ * TEST WAIT - lets the simulated clock run to a position in the control tick
+ *              a microsecond at a time, so every timer 1 interrupt comes on time
+ * @param ticks - the core ticks to reach
+ */
+PRIVATE void test_wait(unsigned int ticks)
+{
+    while(hal_core_ticks() < ticks)
+        hal_host_wait_us(1);
+}
+
+/*
+ * TEST TICK - waits for the end of the control tick and starts the next one
+ */
+PRIVATE void test_tick(void)
+{
+    test_wait(LOOP_TICKS);
+    timing_tick();
+}
+
+/*
+ * TEST LATCH WAIT - publishes at a position of the pwm period and compares
+ *              the expected wait with the measured delay
+ * @param tick - the control tick of the period, 0 to MOTOR_PWM_TICKS - 1
+ * @param us - microseconds into that tick
+ * @return nonzero if they agree.
+ */
+PRIVATE int test_latch_wait(uint32_t tick, uint32_t us)
+{
+    engine_data engine = { .e1.speed = MOTOR_ZERO, .e2.speed = MOTOR_ZERO,
+                           .e3.speed = MOTOR_ZERO, .e4.speed = MOTOR_ZERO };
+    const motor_delay *d = motor_get_delay();
+    unsigned int count;
+    uint64_t sum;
+    float expected, measured;
+
+    do
+        test_tick();
+    while(timing_ticks() % MOTOR_PWM_TICKS != tick);
+    test_wait(us * CORE_TICKS_PER_US);
+    count = d->count;
+    sum = d->sum_us;
+    expected = motor_latch_wait_s() * 1e6f;
+    motor_publish(&engine);
+    while(d->count == count)
+        test_tick();
+    measured = d->sum_us - sum;
+    if(fabsf(measured - expected) <= TEST_WAIT_SLACK_US) return 1;
+    printf("motor: tick %u at %uus, expected %.0fus, measured %.0fus\n",
+           (unsigned int) tick, (unsigned int) us, expected, measured);
+    return 0;
+}
+
+int main(void)
+{
+    pthread_t writer, reader;
+    motor_command command;
+
+    TEST_CHECK(pthread_create(&reader, NULL, test_reader, NULL) == 0);
+    TEST_CHECK(pthread_create(&writer, NULL, test_writer, NULL) == 0);
+    pthread_join(writer, NULL);
+    pthread_join(reader, NULL);
+
+    printf("motor: %lu latched, %lu stale\n", test.latched, test.stale);
+    TEST_CHECK(test.latched > 0);
+    TEST_CHECK(test.torn == 0);
+    TEST_CHECK(test.backwards == 0);
+
+    // with the writer gone the newest publish is latched complete
+    TEST_CHECK(motor_latch(&command) == 0);
+    TEST_CHECK(command.speed[0] == TEST_PUBLISHES && command.speed[3] == TEST_PUBLISHES + 3);
+
+    // the aligned pwm on the simulated clock, a few periods to line up first
+    uint32_t tick, us, agree = 0, cases = 0;
+
+    hal_init();
+    hal_timer1_open(40);
+    hal_timer2_open(T2_TICK);
+    hal_interrupts_enable();
+    for(tick = 0; tick < 3 * MOTOR_PWM_TICKS; tick++)
+        test_tick();
+    for(tick = 0; tick < MOTOR_PWM_TICKS; tick++)
+        for(us = 0; us < 1000000 / LOOP_RATE_HZ; us += 1000000 / LOOP_RATE_HZ / 8 + 1)
+        {
+            agree += test_latch_wait(tick, us);
+            cases++;
+        }
+    printf("motor: latch wait within %dus of the measured delay in %u of %u cases\n",
+           TEST_WAIT_SLACK_US, (unsigned int) agree, (unsigned int) cases);
+    TEST_CHECK(agree == cases);
+    return test_result();
+}
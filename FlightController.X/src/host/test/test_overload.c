@@ -0,0 +1,100 @@
+/*
+ * File:   test_overload.c
+ * Author: Kevin Dederer
+ * Comments: host test of the overload monitor. Each test tick restarts the
+ *           core timer and stands for the work of a control tick on the
+ *           simulated clock, a stalled sensor read holds the clock well past
+ *           the budget unless the mode skips the read. The mode has to step
+ *           down after OVERLOAD_STEP_DOWN overruns, back up after
+ *           OVERLOAD_RECOVER good ticks, count each transition, and stay in
+ *           hold while a stall lasts instead of trying every
+ *           OVERLOAD_RECOVER ticks.
+ * Revision history:
+ */
+
+#include "config.h"
+#include "test.h"
+
+#define TEST_WORK_US (1000000 / LOOP_RATE_HZ / 4)       // a normal tick, well in budget
+#define TEST_STALL_US (1000000 / LOOP_RATE_HZ * 3 / 2)  // a read stuck on the bus
+#define TEST_STALL_TICKS (4000)     // a long stall, 40s at 100Hz
+
+/*
+ * TEST TICK - runs the work of one control tick and updates the monitor
+ * @param stalled - the sensor read stalls
+ * @return the mode for the next tick.
+ */
+PRIVATE enum overload_mode test_tick(int stalled)
+{
+    hal_core_reset();
+    hal_host_wait_us(TEST_WORK_US);
+    if(stalled && overload_mode() < mode_hold_attitude)
+        hal_host_wait_us(TEST_STALL_US);
+    return overload_update(hal_core_ticks());
+}
+
+/*
+ * TEST TICKS - runs control ticks
+ * @param ticks - how many
+ * @param stalled - the sensor read stalls
+ * @return the mode for the next tick.
+ */
+PRIVATE enum overload_mode test_ticks(int ticks, int stalled)
+{
+    while(ticks-- > 1)
+        test_tick(stalled);
+    return test_tick(stalled);
+}
+
+int main(void)
+{
+    const overload_data *stats = overload_stats();
+    int i, hold_ticks = 0, probes;
+
+    TEST_CHECK(test_ticks(10, 0) == mode_normal);
+
+    // every OVERLOAD_STEP_DOWN overruns one mode down, to hold
+    TEST_CHECK(test_ticks(OVERLOAD_STEP_DOWN - 1, 1) == mode_normal);
+    TEST_CHECK(test_tick(1) == mode_short_filter);
+    TEST_CHECK(test_ticks(OVERLOAD_STEP_DOWN, 1) == mode_skip_tasks);
+    TEST_CHECK(test_ticks(OVERLOAD_STEP_DOWN, 1) == mode_hold_attitude);
+    TEST_CHECK(stats->overrun_total == 3 * OVERLOAD_STEP_DOWN);
+    TEST_CHECK(stats->max_ticks > TEST_STALL_US * CORE_TICKS_PER_US);
+
+    // the stall ends, every OVERLOAD_RECOVER good ticks one mode up
+    TEST_CHECK(test_ticks(OVERLOAD_RECOVER - 1, 0) == mode_hold_attitude);
+    TEST_CHECK(test_tick(0) == mode_skip_tasks);
+    TEST_CHECK(test_ticks(OVERLOAD_RECOVER, 0) == mode_short_filter);
+    TEST_CHECK(test_ticks(OVERLOAD_RECOVER, 0) == mode_normal);
+    TEST_CHECK(stats->entered[mode_normal] == 1);
+    TEST_CHECK(stats->entered[mode_short_filter] == 2);
+    TEST_CHECK(stats->entered[mode_skip_tasks] == 2);
+    TEST_CHECK(stats->entered[mode_hold_attitude] == 1);
+
+    // an overrun between good ticks only restarts the count, once the step
+    // up held long enough not to count as failed
+    test_ticks(OVERLOAD_RECOVER, 0);
+    test_ticks(OVERLOAD_STEP_DOWN, 1);
+    TEST_CHECK(test_ticks(OVERLOAD_RECOVER - 1, 0) == mode_short_filter);
+    TEST_CHECK(test_tick(1) == mode_short_filter);
+    TEST_CHECK(test_ticks(OVERLOAD_RECOVER - 1, 0) == mode_short_filter);
+    TEST_CHECK(test_tick(0) == mode_normal);
+
+    // a stall that lasts, hold is left only to try again, less and less often
+    probes = stats->entered[mode_skip_tasks];
+    for(i = 0; i < TEST_STALL_TICKS; i++)
+        hold_ticks += test_tick(1) == mode_hold_attitude;
+    probes = stats->entered[mode_skip_tasks] - probes;
+    printf("overload: %d ticks of stall, %d in hold, %d step ups tried\n",
+           TEST_STALL_TICKS, hold_ticks, probes - 1);
+    TEST_CHECK(probes - 1 <= 8);
+    TEST_CHECK(hold_ticks > TEST_STALL_TICKS * 95 / 100);
+
+    // and once it ends the mode recovers at the normal pace again
+    for(i = 0; i < OVERLOAD_RECOVER_MAX && overload_mode() == mode_hold_attitude; i++)
+        test_tick(0);
+    TEST_CHECK(test_ticks(OVERLOAD_RECOVER, 0) == mode_short_filter);
+    TEST_CHECK(test_ticks(OVERLOAD_RECOVER, 0) == mode_normal);
+    TEST_CHECK(stats->mode == mode_normal && stats->recover == OVERLOAD_RECOVER);
+    return test_result();
+}
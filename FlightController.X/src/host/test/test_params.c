@@ -0,0 +1,291 @@
+/*
+ * File:   test_params.c
+ * Author: Kevin Dederer
+ * Comments: host test of the parameter registry and of the link decoder. A
+ *           change has to be refused out of range, on a read only parameter
+ *           or when the committed set is inconsistent, and a committed set
+ *           has to reach the live one whole in a single params_tick(). The
+ *           decoder is private to params_link.c, so the source is included
+ *           with the link built in and its bytes are fed to plink_byte()
+ *           directly, the answers are read back from the transmit ring. Bad
+ *           crcs, noise and cut frames must only cost the frames they hit.
+ * Revision history:
+ */
+
+#ifndef PARAMS_LINK
+#define PARAMS_LINK
+#endif
+#include "params_link.c"
+#include "test.h"
+
+#define TEST_MESSAGE(id, message, arg) [id] = message,
+PRIVATE const char *test_message[EVLOG_EVENT_COUNT] = { EVLOG_EVENTS(TEST_MESSAGE) };
+#undef TEST_MESSAGE
+
+/*
+ * TEST INDEX - finds a parameter by name
+ * @param *name - the name
+ * @return the index, -1 if there is none.
+ */
+PRIVATE int test_index(const char *name)
+{
+    int i;
+
+    for(i = 0; i < params_count(); i++)
+        if(strcmp(params_info(i)->name, name) == 0) return i;
+    return -1;
+}
+
+/*
+ * TEST FLOAT, TEST INT - the 4 value bytes of a value
+ */
+PRIVATE uint32_t test_float(float value)
+{
+    uint32_t raw;
+
+    memcpy(&raw, &value, sizeof(raw));
+    return raw;
+}
+
+PRIVATE uint32_t test_int(int32_t value)
+{
+    return (uint32_t) value;
+}
+
+/*
+ * TEST SWAPS - the ev_params_swapped events logged since the last call
+ * @param *changed - receives the argument of the last one
+ * @return how many there were.
+ */
+PRIVATE int test_swaps(unsigned long *changed)
+{
+    FILE *out = stdout, *f = tmpfile();
+    const char *message = test_message[ev_params_swapped];
+    char line[128], *at;
+    int events = 0;
+
+    if(f == NULL) return -1;
+    fflush(stdout);
+    stdout = f;
+    while(evlog_drain());
+    stdout = out;
+    rewind(f);
+    while(fgets(line, sizeof(line), f) != NULL)
+    {
+        at = strstr(line, message);
+        if(at == NULL) continue;
+        *changed = strtoul(at + strlen(message), NULL, 10);
+        events++;
+    }
+    fclose(f);
+    return events;
+}
+
+/*
+ * TEST SEND - feeds a frame to the decoder a byte at a time
+ * @param command - the command byte
+ * @param *payload - the payload
+ * @param len - payload length
+ * @param corrupt - byte of the frame after the sync to flip a bit in, -1 for none
+ * @return the frames the bytes completed.
+ */
+PRIVATE int test_send(uint8_t command, const uint8_t *payload, int len, int corrupt)
+{
+    uint8_t frame[PARAMS_LINK_PAYLOAD + 3] = { command, len };
+    int i, done = 0;
+
+    if(len > 0) memcpy(frame + 2, payload, len);
+    frame[len + 2] = plink_crc(0, frame, len + 2);
+    if(corrupt >= 0) frame[corrupt] ^= 0x10;
+    done += plink_byte(PARAMS_LINK_SYNC);
+    for(i = 0; i < len + 3; i++)
+        done += plink_byte(frame[i]);
+    return done;
+}
+
+/*
+ * TEST ANSWER - takes the next answer frame off the transmit ring
+ * @param *command - receives the command byte
+ * @param *payload - receives the payload
+ * @return the payload length, -1 if there is no answer or it is malformed.
+ */
+PRIVATE int test_answer(uint8_t *command, uint8_t *payload)
+{
+    uint8_t frame[PARAMS_LINK_PAYLOAD + 3];
+    int i, len;
+
+    if(plink.tx_head - plink.tx_tail < PLINK_OVERHEAD) return -1;
+    if(plink.tx[plink.tx_tail++ & PLINK_MASK] != PARAMS_LINK_SYNC) return -1;
+    frame[0] = plink.tx[plink.tx_tail++ & PLINK_MASK];
+    frame[1] = len = plink.tx[plink.tx_tail++ & PLINK_MASK];
+    for(i = 0; i < len + 1; i++)
+        frame[2 + i] = plink.tx[plink.tx_tail++ & PLINK_MASK];
+    if(plink_crc(0, frame, len + 2) != frame[len + 2]) return -1;
+    *command = frame[0];
+    memcpy(payload, frame + 2, len);
+    return len;
+}
+
+/*
+ * TEST REGISTRY - the checks and the swap of params.c
+ */
+PRIVATE void test_registry(void)
+{
+    const params_set defaults = params;
+    int kp = test_index("kp"), hover = test_index("hover");
+    int motor_min = test_index("motor_min"), motor_max = test_index("motor_max");
+    unsigned long changed = 0;
+
+    TEST_CHECK(kp >= 0 && hover >= 0 && motor_min >= 0 && motor_max >= 0);
+
+    // each value on its own
+    TEST_CHECK(params_set_value(-1, 0) == param_unknown);
+    TEST_CHECK(params_set_value(params_count(), 0) == param_unknown);
+    TEST_CHECK(params_set_value(test_index("loop_rate_hz"), test_int(LOOP_RATE_HZ)) == param_read_only);
+    TEST_CHECK(params_set_value(kp, test_float(25.0)) == param_range);
+    TEST_CHECK(params_set_value(kp, test_float(-0.5)) == param_range);
+    TEST_CHECK(params_set_value(kp, test_float(NAN)) == param_range);
+    TEST_CHECK(params_set_value(hover, test_int(6000)) == param_range);
+    TEST_CHECK(params_set_value(hover, test_int(-3000)) == param_range);
+    TEST_CHECK(params_set_value(kp, test_float(20.0)) == param_ok);  // the limits are in range
+    TEST_CHECK(params_set_value(kp, test_float(4.0)) == param_ok);
+
+    // a change is only in the shadow set until it is committed and ticked
+    TEST_CHECK(params.kp == defaults.kp && params_get(kp) == test_float(defaults.kp));
+    params_tick();
+    TEST_CHECK(params.kp == defaults.kp);
+    TEST_CHECK(params_commit() == param_ok);
+    TEST_CHECK(params.kp == defaults.kp);
+    params_tick();
+    TEST_CHECK(params.kp == 4.0f && params_get(kp) == test_float(4.0));
+    TEST_CHECK(test_swaps(&changed) == 1 && changed == 1);
+
+    // several changes land in the same tick
+    TEST_CHECK(params_set_value(hover, test_int(3000)) == param_ok);
+    TEST_CHECK(params_set_value(motor_min, test_int(2600)) == param_ok);
+    TEST_CHECK(params_set_value(kp, test_float(5.0)) == param_ok);
+    TEST_CHECK(params_commit() == param_ok);
+    TEST_CHECK(params.hover == defaults.hover && params.motor_min == defaults.motor_min);
+    params_tick();
+    TEST_CHECK(params.hover == 3000 && params.motor_min == 2600 && params.kp == 5.0f);
+    params_tick();
+    TEST_CHECK(test_swaps(&changed) == 1 && changed == 3);
+
+    // an inconsistent set is refused whole and the shadow starts over from live
+    TEST_CHECK(params_set_value(kp, test_float(6.0)) == param_ok);
+    TEST_CHECK(params_set_value(motor_min, test_int(3200)) == param_ok);     // above hover
+    TEST_CHECK(params_commit() == param_inconsistent);
+    params_tick();
+    TEST_CHECK(params.kp == 5.0f && params.motor_min == 2600);
+    TEST_CHECK(params_commit() == param_ok);    // the shadow is the live set again
+    params_tick();
+    TEST_CHECK(params.kp == 5.0f && params.motor_min == 2600);
+    TEST_CHECK(test_swaps(&changed) == 1 && changed == 0);
+
+    // or from the staged set while one waits for its tick
+    TEST_CHECK(params_set_value(kp, test_float(7.0)) == param_ok);
+    TEST_CHECK(params_commit() == param_ok);
+    TEST_CHECK(params_set_value(motor_max, test_int(2900)) == param_ok);     // below hover
+    TEST_CHECK(params_commit() == param_inconsistent);
+    params_tick();
+    TEST_CHECK(params.kp == 7.0f && params.motor_max == defaults.motor_max);
+    TEST_CHECK(test_swaps(&changed) == 1 && changed == 1);
+
+    // back to the defaults for the link part
+    TEST_CHECK(params_set_value(kp, test_float(defaults.kp)) == param_ok);
+    TEST_CHECK(params_set_value(hover, test_int(defaults.hover)) == param_ok);
+    TEST_CHECK(params_set_value(motor_min, test_int(defaults.motor_min)) == param_ok);
+    TEST_CHECK(params_commit() == param_ok);
+    params_tick();
+    TEST_CHECK(memcmp(&params, &defaults, sizeof(params)) == 0);
+    test_swaps(&changed);
+}
+
+/*
+ * TEST LINK - frames through plink_byte() and their answers
+ */
+PRIVATE void test_link(void)
+{
+    static const int corrupt[3] = { 0, 2, 3 };      // the command, the payload and the crc
+    uint8_t command, payload[PARAMS_LINK_PAYLOAD], frame[5];
+    int kp = test_index("kp"), i, len, tries;
+    unsigned int frames = plink.status.frames;
+
+    // the commands
+    TEST_CHECK(test_send(plink_ping, NULL, 0, -1) == 1);
+    len = test_answer(&command, payload);
+    TEST_CHECK(len == 2 && command == plink_ping);
+    TEST_CHECK(payload[0] == PARAMS_LINK_VERSION && payload[1] == params_count());
+
+    frame[0] = kp;
+    TEST_CHECK(test_send(plink_info, frame, 1, -1) == 1);
+    len = test_answer(&command, payload);
+    TEST_CHECK(len == 11 + 2 && command == plink_info && payload[0] == kp);
+    TEST_CHECK(payload[1] == param_float && memcmp(payload + 11, "kp", 2) == 0);
+    TEST_CHECK(plink_get32(payload + 7) == test_float(20.0));
+
+    plink_put32(frame + 1, test_float(2.5));
+    TEST_CHECK(test_send(plink_set, frame, 5, -1) == 1);
+    len = test_answer(&command, payload);
+    TEST_CHECK(len == 2 && command == plink_set && payload[0] == kp && payload[1] == param_ok);
+    TEST_CHECK(test_send(plink_commit, NULL, 0, -1) == 1);
+    len = test_answer(&command, payload);
+    TEST_CHECK(len == 1 && command == plink_commit && payload[0] == param_ok);
+    params_tick();
+    TEST_CHECK(test_send(plink_get, frame, 1, -1) == 1);
+    len = test_answer(&command, payload);
+    TEST_CHECK(len == 5 && command == plink_get && plink_get32(payload + 1) == test_float(2.5));
+
+    // refused values come back as a status, bad frames as an error
+    plink_put32(frame + 1, test_float(50.0));
+    TEST_CHECK(test_send(plink_set, frame, 5, -1) == 1);
+    len = test_answer(&command, payload);
+    TEST_CHECK(len == 2 && (int8_t) payload[1] == param_range);
+    frame[0] = params_count();
+    TEST_CHECK(test_send(plink_get, frame, 1, -1) == 1);
+    len = test_answer(&command, payload);
+    TEST_CHECK(len == 1 && command == (plink_get | PLINK_ERROR) && payload[0] == plink_bad_index);
+    TEST_CHECK(test_send(plink_get, frame, 2, -1) == 1);
+    len = test_answer(&command, payload);
+    TEST_CHECK(len == 1 && command == (plink_get | PLINK_ERROR) && payload[0] == plink_bad_length);
+    TEST_CHECK(test_send(PLINK_COMMANDS, NULL, 0, -1) == 1);
+    len = test_answer(&command, payload);
+    TEST_CHECK(len == 1 && command == (PLINK_COMMANDS | PLINK_ERROR) && payload[0] == plink_bad_command);
+    TEST_CHECK(plink.status.frames == frames + 6);     // error answers are not counted
+
+    // a bad crc drops the frame without an answer, the next one is decoded
+    frame[0] = kp;
+    for(i = 0; i < 6; i++)
+    {
+        TEST_CHECK(test_send(plink_get, frame, 1, corrupt[i % 3]) == 0);
+        TEST_CHECK(test_send(plink_ping, NULL, 0, -1) == 1);
+        TEST_CHECK(test_answer(&command, payload) == 2 && command == plink_ping);
+    }
+    TEST_CHECK(test_answer(&command, payload) == -1);
+    TEST_CHECK(plink.status.crc_errors == 6);
+
+    // noise and a length that cannot be a frame are skipped up to the next sync
+    for(i = 0; i < 50; i++)
+        plink_byte(i * 37 == PARAMS_LINK_SYNC ? 0 : i * 37);
+    plink_byte(PARAMS_LINK_SYNC);
+    plink_byte(plink_ping);
+    plink_byte(PARAMS_LINK_PAYLOAD + 1);
+    TEST_CHECK(test_send(plink_ping, NULL, 0, -1) == 1);
+    TEST_CHECK(test_answer(&command, payload) == 2 && command == plink_ping);
+
+    // a cut frame takes the frame after it along at most
+    plink_byte(PARAMS_LINK_SYNC);
+    plink_byte(plink_get);
+    plink_byte(1);
+    for(tries = 1; tries <= 3 && test_send(plink_ping, NULL, 0, -1) == 0; tries++);
+    TEST_CHECK(tries <= 2);
+    TEST_CHECK(test_answer(&command, payload) == 2 && command == plink_ping);
+    TEST_CHECK(test_answer(&command, payload) == -1);
+}
+
+int main(void)
+{
+    test_registry();
+    test_link();
+    return test_result();
+}
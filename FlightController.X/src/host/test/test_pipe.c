@@ -0,0 +1,212 @@
+/*
+ * File:   test_pipe.c
+ * Author: Kevin Dederer
+ * Comments: host test of the sample pipeline against a float reference. The
+ *           reference takes the same raw blocks through the zero offset, the
+ *           notch and the fir in double without any rounding and keeps the
+ *           newest sample of each block, pipe_run() has to stay within a few
+ *           counts of it. The notch is tuned first to a tone in the input and
+ *           then left alone, nothing steps the analyser during the run.
+ *           Blocks of every length up to PIPE_BLOCK are used, and the run
+ *           switches to the 16 tap fir and back, the long set has to be
+ *           right the first block after.
+ * Revision history:
+ */
+
+#include "config.h"
+#include "test.h"
+
+#define TEST_BLOCKS (600)
+#define TEST_SHORT_FROM (200)       // blocks run with the 16 tap set
+#define TEST_SHORT_TO (300)
+#define TEST_TONE_HZ (PIPE_SAMPLE_HZ / 5.0)
+#define TEST_TOLERANCE (3)          // counts
+#define TEST_HISTORY (FIR_TAPS + 8 * PIPE_BLOCK)
+
+/*
+ * test_ref - the float reference
+ * @param in - per axis the fir inputs, newest at index samples - 1
+ * @param samples - fir inputs so far
+ * @param x1, x2, y1, y2 - per axis the notch history
+ * @param b0, b1, b2, a1, a2 - the notch coefficients, b0 0 without a notch
+ * @param zero - per axis the zero offset in counts
+ */
+typedef struct
+{
+    double in[3][TEST_HISTORY];
+    int samples;
+    double x1[3], x2[3], y1[3], y2[3];
+    double b0, b1, b2, a1, a2;
+    double zero[3];
+} test_ref;
+
+PRIVATE test_ref ref;
+PRIVATE const int16_t test_long[FIR_TAPS] = { FIR_COEFFS };
+PRIVATE const int16_t test_short[FIR_SHORT_TAPS] = { FIR_SHORT_COEFFS };
+
+/*
+ * TEST RAW - the raw sample of an axis, gravity, a slow swing, the tone and noise
+ * @param axis - the axis
+ * @param n - the sample index
+ * @return the sample in counts.
+ */
+PRIVATE int16_t test_raw(int axis, int n)
+{
+    static uint32_t seed = 7;
+    static const double level[3] = { 900, -1400, 16000 };
+    double t = n / (double) PIPE_SAMPLE_HZ;
+
+    seed = seed * 1664525 + 1013904223;
+    return lround(level[axis] + 3000 * sin(2 * M_PI * 0.7 * t + axis) +
+                  1500 * sin(2 * M_PI * TEST_TONE_HZ * t) + (int32_t) (seed >> 24) - 128);
+}
+
+/*
+ * TEST PUSH - takes a raw sample through the reference offset and notch into
+ *              the fir input
+ * @param axis - the axis
+ * @param raw - the sample
+ * @param notch - run the notch, prime skips it as pipe_prime() does
+ */
+PRIVATE void test_push(int axis, int16_t raw, int notch)
+{
+    double x = raw + ref.zero[axis], y = x;
+
+    if(notch && ref.b0 != 0)
+    {
+        y = ref.b0 * x + ref.b1 * ref.x1[axis] + ref.b2 * ref.x2[axis] -
+            ref.a1 * ref.y1[axis] - ref.a2 * ref.y2[axis];
+        ref.x2[axis] = ref.x1[axis];
+        ref.x1[axis] = x;
+        ref.y2[axis] = ref.y1[axis];
+        ref.y1[axis] = y;
+    }
+    ref.in[axis][ref.samples] = y;
+}
+
+/*
+ * TEST FIR - the reference fir output at the newest input
+ * @param axis - the axis
+ * @param short_fir - use the 16 tap set on the newest inputs
+ * @return the output in counts.
+ */
+PRIVATE double test_fir(int axis, int short_fir)
+{
+    const double *newest = &ref.in[axis][ref.samples - 1];
+    double sum = 0;
+    int k;
+
+    if(short_fir)
+        for(k = 0; k < FIR_SHORT_TAPS; k++)
+            sum += newest[-k] * test_short[k];
+    else
+        for(k = 0; k < FIR_TAPS; k++)
+            sum += newest[k - (FIR_TAPS - 1)] * test_long[k];
+    return sum / (1 << FIR_SHIFT);
+}
+
+/*
+ * TEST BLOCK - fills a block with raw samples and takes them into the reference
+ * @param *block - the block
+ * @param count - samples in it
+ * @param *n - the sample index, advanced
+ * @param notch - run the reference notch
+ */
+PRIVATE void test_block(sensor_block *block, int count, int *n, int notch)
+{
+    int axis, i;
+
+    if(ref.samples + count > TEST_HISTORY)
+    {
+        for(axis = 0; axis < 3; axis++)
+            for(i = 0; i < FIR_TAPS; i++)
+                ref.in[axis][i] = ref.in[axis][ref.samples - FIR_TAPS + i];
+        ref.samples = FIR_TAPS;
+    }
+    block->count = count;
+    for(i = 0; i < count; i++, (*n)++, ref.samples++)
+        for(axis = 0; axis < 3; axis++)
+        {
+            block->axis[axis][i] = test_raw(axis, *n);
+            test_push(axis, block->axis[axis][i], notch);
+        }
+}
+
+/*
+ * TEST TUNE - runs the analyser on the tone until the notch sits on it, and
+ *              takes its coefficients into the reference in double
+ */
+PRIVATE void test_tune(void)
+{
+    double w0, alpha;
+    int n;
+
+    for(n = 0; n < 40 * FFT_MAX_POINTS; n++)
+    {
+        vibe_push_sample(lround(1500 * sin(2 * M_PI * TEST_TONE_HZ * n / PIPE_SAMPLE_HZ)));
+        while(vibe_step());
+    }
+    if(vibe_peak_hz() == 0) return;     // below VIBE_MIN_SAMPLE_HZ, no notch
+    w0 = 2 * M_PI * vibe_peak_hz() / PIPE_SAMPLE_HZ;
+    alpha = sin(w0) / (2 * VIBE_NOTCH_Q);
+    ref.b0 = 1 / (1 + alpha);
+    ref.b1 = -2 * cos(w0) / (1 + alpha);
+    ref.b2 = ref.b0;
+    ref.a1 = ref.b1;
+    ref.a2 = (1 - alpha) / (1 + alpha);
+}
+
+int main(void)
+{
+    static pipe_state pipe;
+    static sensor_block block;
+    static location_data location;
+    sensor_data lsm330 = { 0 };
+    double expected, error, worst = 0, worst_switch = 0;
+    const int16_t *out[3] = { &lsm330.out_x, &lsm330.out_y, &lsm330.out_z };
+    int axis, b, n = 0, short_fir, first_long;
+
+    lsm330.zero_x = -(37 << LSM330_ZERO_SHIFT) - 77;
+    lsm330.zero_y = (120 << LSM330_ZERO_SHIFT) + 200;
+    lsm330.zero_z = -(400 << LSM330_ZERO_SHIFT) + 31;
+    lsm330.sensitivity = 0.000061f;
+    ref.zero[0] = lsm330.zero_x / (double) (1 << LSM330_ZERO_SHIFT);
+    ref.zero[1] = lsm330.zero_y / (double) (1 << LSM330_ZERO_SHIFT);
+    ref.zero[2] = lsm330.zero_z / (double) (1 << LSM330_ZERO_SHIFT);
+    test_tune();
+    TEST_CHECK(PIPE_SAMPLE_HZ < 400 || fabs(vibe_peak_hz() - TEST_TONE_HZ) < PIPE_SAMPLE_HZ / 64.0);
+
+    // prime as main() does, offset and fir only
+    while(ref.samples < FIR_TAPS)
+    {
+        test_block(&block, PIPE_DECIMATE, &n, 0);
+        pipe_prime(&pipe, &block, &lsm330);
+    }
+
+    for(b = 0; b < TEST_BLOCKS; b++)
+    {
+        short_fir = b >= TEST_SHORT_FROM && b < TEST_SHORT_TO;
+        first_long = b == TEST_SHORT_TO;
+        test_block(&block, 1 + b % PIPE_BLOCK, &n, 1);
+        pipe_run(&pipe, &block, &lsm330, &location, short_fir);
+        TEST_CHECK(block.count == 1);
+        for(axis = 0; axis < 3; axis++)
+        {
+            // only the newest sample is kept, the fir output at the end of the block
+            expected = test_fir(axis, short_fir);
+            error = fabs(*out[axis] - expected);
+            if(error > worst) worst = error;
+            if(first_long && error > worst_switch) worst_switch = error;
+            TEST_CHECK(block.axis[axis][0] == *out[axis]);
+        }
+    }
+    printf("pipe: largest error %.2f counts, %.2f after the switch back\n", worst, worst_switch);
+    TEST_CHECK(worst <= TEST_TOLERANCE);
+    TEST_CHECK(worst_switch <= TEST_TOLERANCE);
+
+    // the attitude of the last sample
+    TEST_CHECK(lsm330.accel_z == lsm330.out_z * lsm330.sensitivity);
+    TEST_CHECK(fabs(location.actual.pitch - atan2(lsm330.out_x, lsm330.out_z)) < 1e-5);
+    TEST_CHECK(fabs(location.actual.roll - atan2(lsm330.out_y, lsm330.out_z)) < 1e-5);
+    return test_result();
+}
@@ -0,0 +1,118 @@
+/*
+ * File:   test_power.c
+ * Author: Kevin Dederer
+ * Comments: host test of the battery monitor and of the thrust scaling it
+ *           feeds. Sums for a pack voltage are passed to power_scan() as the
+ *           adc interrupt would, the first reading is taken as it is and the
+ *           later ones smoothed. The scale has to be nominal over the voltage,
+ *           held at POWER_VBAT_MIN below it and 1 without a pack. With the
+ *           attitude at rest the pid output is zero, so the published speed is
+ *           the hover throttle scaled about MOTOR_ZERO and then limited.
+ * Revision history:
+ */
+
+#include "config.h"
+#include "test.h"
+
+#define TEST_SCANS (200)            // enough for the smoothed reading to settle
+
+/*
+ * TEST SCAN - one interrupt worth of conversions of a pack voltage and current
+ * @param volts - the pack voltage
+ * @param amps - the pack current
+ */
+PRIVATE void test_scan(double volts, double amps)
+{
+    power_scan(lround(volts / (POWER_VOLTS_PER_COUNT * POWER_VBAT_DIVIDER)),
+               lround((amps / POWER_AMPS_PER_VOLT + POWER_CURRENT_ZERO) / POWER_VOLTS_PER_COUNT));
+}
+
+/*
+ * TEST SETTLE - scans one pack voltage until the smoothed reading follows it
+ * @param volts - the pack voltage
+ * @return how far the reading is off, V.
+ */
+PRIVATE double test_settle(double volts)
+{
+    int i;
+
+    for(i = 0; i < TEST_SCANS; i++)
+        test_scan(volts, 5.0);
+    return fabs(power_get_status()->vbat - volts);
+}
+
+/*
+ * TEST SPEED - runs the controller at rest and checks the published speed
+ * @param scale - the thrust scale expected
+ * @return the speed, -1 unless every engine got the hover throttle scaled
+ *              and limited.
+ */
+PRIVATE int test_speed(double scale)
+{
+    static engine_data engine = {{0,0,0,0.0,1,1},{0,0,0,0.0,1,-1},
+                                 {0,0,0,0.0,-1,-1},{0,0,0,0.0,-1,1}};
+    location_data location = {{0,0,0,0},{0,0,0,0},{0,0,0,0},{0,0,0,0}};
+    double expected = MOTOR_ZERO + (params.hover - MOTOR_ZERO) * scale;
+    int ok = 1;
+
+    if(expected > params.motor_max) expected = params.motor_max;
+    if(expected < params.motor_min) expected = params.motor_min;
+    pid_control_function(&location, &engine, timing_now(), 0);
+    ok &= fabs(engine.e1.pid_out) < 1e-6;
+    ok &= abs(engine.e1.speed - (int) expected) <= 1;
+    ok &= engine.e2.speed == engine.e1.speed && engine.e3.speed == engine.e1.speed;
+    ok &= engine.e4.speed == engine.e1.speed;
+    return ok ? engine.e1.speed : -1;
+}
+
+int main(void)
+{
+    const power_status *s = power_get_status();
+    const params_set defaults = params;
+    float vbat;
+
+    // before the first reading nothing is scaled
+    TEST_CHECK(s->scans == 0 && power_thrust_scale() == 1.0f);
+    TEST_CHECK(test_speed(1.0) > 0);
+
+    // the first reading is taken as it is, later ones move by POWER_SMOOTH
+    test_scan(12.0, 10.0);
+    TEST_CHECK(s->scans == 1);
+    TEST_CHECK(fabs(s->vbat - 12.0) < 0.02);
+    TEST_CHECK(fabs(s->current - 10.0) < 0.1);
+    TEST_CHECK(fabs(power_thrust_scale() - POWER_VBAT_NOMINAL / s->vbat) < 1e-5);
+    vbat = s->vbat;
+    test_scan(10.0, 10.0);
+    TEST_CHECK(fabs(s->vbat - (vbat + POWER_SMOOTH * (10.0 - vbat))) < 0.02);
+
+    // a sagging pack gets more throttle above zero
+    TEST_CHECK(test_settle(10.0) < 0.02);
+    TEST_CHECK(fabs(power_thrust_scale() - POWER_VBAT_NOMINAL / s->vbat) < 1e-5);
+    TEST_CHECK(test_speed(power_thrust_scale()) > 0);
+    TEST_CHECK(test_settle(POWER_VBAT_NOMINAL) < 0.02);
+    TEST_CHECK(fabs(power_thrust_scale() - 1.0) < 0.002);
+
+    // below POWER_VBAT_MIN the scale stops growing
+    TEST_CHECK(test_settle(POWER_VBAT_MIN - 1.0) < 0.02);
+    TEST_CHECK(power_thrust_scale() == (float) (POWER_VBAT_NOMINAL / POWER_VBAT_MIN));
+    TEST_CHECK(test_speed(POWER_VBAT_NOMINAL / POWER_VBAT_MIN) > 0);
+
+    // and a scaled hover near the top is held at motor_max
+    params.hover = params.motor_max - 100;
+    TEST_CHECK(test_speed(POWER_VBAT_NOMINAL / POWER_VBAT_MIN) == params.motor_max);
+
+    // the scale is about MOTOR_ZERO, zero throttle stays zero and below it
+    // the throttle is scaled down as well, with the limits out of the way
+    params.motor_min = MOTOR_ZERO - 500;
+    params.hover = MOTOR_ZERO;
+    TEST_CHECK(test_speed(POWER_VBAT_NOMINAL / POWER_VBAT_MIN) == MOTOR_ZERO);
+    params.hover = MOTOR_ZERO - 200;
+    TEST_CHECK(test_speed(POWER_VBAT_NOMINAL / POWER_VBAT_MIN) < MOTOR_ZERO - 200);
+    params = defaults;
+
+    // without a pack, on the bench, nothing is scaled
+    TEST_CHECK(test_settle(POWER_VBAT_PRESENT - 2.0) < 0.02);
+    TEST_CHECK(power_thrust_scale() == 1.0f);
+    TEST_CHECK(test_speed(1.0) > 0);
+    return test_result();
+}
@@ -0,0 +1,216 @@
+/*
+ * File:   test_rc.c
+ * Author: Kevin Dederer
+ * Comments: host test of the rc receiver decoding. A PPM stream of an 8
+ *           channel receiver is fed as input capture values across the timer
+ *           3 wrap, with glitches in an unused channel that must not matter
+ *           and one in the sticks that must drop the frame. An SBUS stream
+ *           joined in the middle of a frame is fed through rc_sbus_received()
+ *           the way the dma moves it. It must line up with the frames, decode
+ *           every one after that and leave out the failsafe frame. The
+ *           sticks must come out of rc_update_user() scaled by the
+ *           parameters and the craft must level once the frames stop.
+ * Revision history:
+ */
+
+#include <string.h>
+#include "config.h"
+#include "test.h"
+
+#define TEST_PPM_CHANNELS (8)
+#define TEST_PPM_COUNTS(us) ((us) * (GetPeripheralClock() / 1000000) / 8)
+#define TEST_SBUS_STICK(value) (((value) - 992) / 819.5)
+#define TEST_SBUS_FRAMES (2 * RC_SBUS_FRAME)    // good frames after the join
+#define TEST_TOLERANCE (1e-3)
+
+// widths in us of ppm frames, the sync gap ends each frame
+PRIVATE const unsigned int test_ppm_us[][TEST_PPM_CHANNELS + 1] =
+{
+    { 1000, 2000, 1500, 1252, 1500, 1500, 1500, 1500, 9000 },
+    { 1500, 1500, 1500, 1500, 300, 1500, 1500, 1500, 9000 },    // glitch in channel 5
+    { 1504, 1248, 2000, 1752, 1500, 2600, 1500, 1500, 9000 },   // and in channel 6
+    { 1500, 300, 1500, 1500, 1500, 1500, 1500, 1500, 9000 },    // glitch in pitch
+};
+
+// an sbus frame as the receiver sends it, roll 172 pitch 1811 throttle 992
+// yaw 1400 and the rest 992, and the same frame with the failsafe bit. The
+// centred channels put a false header at bytes 10 and 21.
+PRIVATE const uint8_t test_sbus_frame[RC_SBUS_FRAME] =
+{
+    0x0F, 0xAC, 0x98, 0x38, 0xF8, 0xF0, 0x0A, 0x3E, 0xF0, 0x81, 0x0F, 0x7C, 0xE0,
+    0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x0F, 0x7C, 0x00, 0x00,
+};
+PRIVATE const uint8_t test_sbus_failsafe[RC_SBUS_FRAME] =
+{
+    0x0F, 0xAC, 0x98, 0x38, 0xF8, 0xF0, 0x0A, 0x3E, 0xF0, 0x81, 0x0F, 0x7C, 0xE0,
+    0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x0F, 0x7C, 0x0C, 0x00,
+};
+#define TEST_SBUS_JOIN (RC_SBUS_FRAME - 7)     // the stream starts with the last 7 bytes
+
+/*
+ * test_sbus_data - the sbus stream and the simulated dma
+ * @param stream - the bytes on the wire
+ * @param bytes - length of the stream
+ * @param at - the next byte the uart receives
+ * @param frame - the dma frame buffer
+ */
+typedef struct
+{
+    uint8_t stream[TEST_SBUS_FRAMES * RC_SBUS_FRAME * 2];
+    int bytes;
+    int at;
+    uint8_t frame[RC_SBUS_FRAME];
+} test_sbus_data;
+
+PRIVATE test_sbus_data sbus;
+
+/*
+ * TEST NEAR - compares a setpoint
+ * @param value - the decoded value
+ * @param expected - the value it must be
+ * @return nonzero if it is within TEST_TOLERANCE.
+ */
+PRIVATE int test_near(double value, double expected)
+{
+    return fabs(value - expected) < TEST_TOLERANCE;
+}
+
+/*
+ * TEST USER - runs a control tick and checks the user orientation
+ * @param roll, pitch, yaw - the stick positions, -1..1
+ * @param throttle - the throttle position, 0..1
+ */
+PRIVATE void test_user(double roll, double pitch, double throttle, double yaw)
+{
+    struct data user = { 0 };
+
+    rc_update_user(&user);
+    TEST_CHECK(test_near(user.roll, roll * params.rc_max_angle));
+    TEST_CHECK(test_near(user.pitch, pitch * params.rc_max_angle));
+    TEST_CHECK(test_near(user.yaw_rate, yaw * params.rc_max_yaw_rate));
+    TEST_CHECK(test_near(user.accel_z, 1.0 + (throttle - 0.5) * 2 * params.rc_max_accel));
+}
+
+/*
+ * TEST FRAMES - the frames published so far
+ * @return the frames count of the setpoints.
+ */
+PRIVATE uint32_t test_frames(void)
+{
+    rc_setpoint setpoint = { 0 };
+
+    TEST_CHECK(rc_read(&setpoint) == 0);
+    return setpoint.frames;
+}
+
+/*
+ * TEST PPM - feeds a ppm frame as captures
+ * @param frame - the frame of test_ppm_us
+ * @param *capture - the timer 3 value, advanced over the frame
+ * @return the sum of what rc_ppm_edge() returned.
+ */
+PRIVATE int test_ppm(int frame, uint16_t *capture)
+{
+    int c, sum = 0;
+
+    for(c = 0; c <= TEST_PPM_CHANNELS; c++)
+    {
+        *capture += TEST_PPM_COUNTS(test_ppm_us[frame][c]);
+        sum += rc_ppm_edge(*capture);
+    }
+    return sum;
+}
+
+/*
+ * TEST SBUS APPEND - adds bytes to the stream
+ * @param *bytes - the bytes
+ * @param count - how many
+ */
+PRIVATE void test_sbus_append(const uint8_t *bytes, int count)
+{
+    memcpy(&sbus.stream[sbus.bytes], bytes, count);
+    sbus.bytes += count;
+}
+
+/*
+ * TEST SBUS TRANSFER - moves bytes of the stream into the frame buffer and
+ *              hands them to the interrupt handling, as the dma does
+ * @param offset - where the transfer starts in the buffer
+ * @param *count - how many bytes it moves
+ * @return what the next transfer is, its offset, with its count in *count,
+ *              -1 at the end of the stream.
+ */
+PRIVATE int test_sbus_transfer(int offset, int *count)
+{
+    if(sbus.at + *count > sbus.bytes) return -1;
+    memcpy(&sbus.frame[offset], &sbus.stream[sbus.at], *count);
+    sbus.at += *count;
+    return rc_sbus_received(sbus.frame, count);
+}
+
+/*
+ * TEST SBUS - receives the stream from its join until the frames line up,
+ *              then the rest frame by frame
+ */
+PRIVATE void test_sbus(void)
+{
+    uint32_t frames = test_frames();
+    int i, offset = 0, count = 1;
+
+    test_sbus_append(&test_sbus_frame[TEST_SBUS_JOIN], RC_SBUS_FRAME - TEST_SBUS_JOIN);
+    for(i = 0; i < TEST_SBUS_FRAMES; i++)
+        test_sbus_append(test_sbus_frame, RC_SBUS_FRAME);
+    test_sbus_append(test_sbus_failsafe, RC_SBUS_FRAME);
+    test_sbus_append(test_sbus_frame, RC_SBUS_FRAME);
+
+    // a false header may hold the start, every retry moves a byte
+    while(test_frames() == frames && offset >= 0)
+        offset = test_sbus_transfer(offset, &count);
+    TEST_CHECK(offset == 0 && count == RC_SBUS_FRAME);
+    TEST_CHECK(sbus.at <= (RC_SBUS_FRAME + 1) * RC_SBUS_FRAME);
+    test_user(TEST_SBUS_STICK(172), TEST_SBUS_STICK(1811), 0.5, TEST_SBUS_STICK(1400));
+
+    // in line every frame is decoded, the failsafe one is left out
+    frames = test_frames();
+    i = (sbus.bytes - sbus.at) / RC_SBUS_FRAME;
+    while(offset >= 0)
+        offset = test_sbus_transfer(offset, &count);
+    TEST_CHECK(sbus.at == sbus.bytes);
+    TEST_CHECK(test_frames() == frames + i - 1);
+}
+
+int main(void)
+{
+    uint16_t capture = 0;
+    int i;
+
+    rc_open();
+    TEST_CHECK(test_frames() == 0);
+    test_user(0, 0, 0.5, 0);
+
+    // no sync before the first frame, it only starts the decoding
+    TEST_CHECK(test_ppm(0, &capture) == 0);
+    TEST_CHECK(test_ppm(0, &capture) == 1);
+    TEST_CHECK(test_frames() == 1);
+    test_user(-1, 1, 0.5, -0.496);
+
+    // the frames wrap timer 3, the channels after the sticks are not checked
+    TEST_CHECK(test_ppm(1, &capture) == 1);
+    TEST_CHECK(test_ppm(2, &capture) == 1);
+    TEST_CHECK(test_frames() == 3);
+    test_user(0.008, -0.504, 1, 0.504);
+
+    // a glitch in the sticks drops the frame until the next sync
+    TEST_CHECK(test_ppm(3, &capture) == -1);
+    TEST_CHECK(test_frames() == 3);
+    TEST_CHECK(test_ppm(0, &capture) == 1);
+    TEST_CHECK(test_frames() == 4);
+
+    test_sbus();
+
+    // no frames for RC_TIMEOUT_TICKS levels the craft
+    for(i = 0; i < RC_TIMEOUT_TICKS; i++)
+        test_user(TEST_SBUS_STICK(172), TEST_SBUS_STICK(1811), 0.5, TEST_SBUS_STICK(1400));
+    test_user(0, 0, 0.5, 0);
+    return test_result();
+}
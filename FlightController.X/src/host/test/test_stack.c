@@ -0,0 +1,56 @@
+/*
+ * File:   test_stack.c
+ * Author: Kevin Dederer
+ * Comments: host test of the stack watermark. After stack_paint() calls
+ *           nested to a known depth must raise the mark by at least the
+ *           stack they took, and the mark must keep the deepest use once
+ *           they returned.
+ * Revision history:
+ */
+
+#include "config.h"
+#include "test.h"
+
+#define TEST_FRAME_BYTES (1024)     // stack each nested call takes at least
+#define TEST_DEPTH (16)             // nested calls
+
+/*
+ * TEST NEST - takes TEST_FRAME_BYTES of stack per call, depth calls deep
+ * @param depth - calls still to nest
+ * @return a value of the frames, so they are not optimised away.
+ */
+PRIVATE int test_nest(int depth)
+{
+    volatile uint8_t frame[TEST_FRAME_BYTES];
+    int i, sum = 0;
+
+    for(i = 0; i < TEST_FRAME_BYTES; i++)
+        frame[i] = depth + i;
+    if(depth > 1) sum = test_nest(depth - 1);
+    for(i = 0; i < TEST_FRAME_BYTES; i += 64)
+        sum += frame[i];
+    return sum;
+}
+
+int main(void)
+{
+    const stack_status *s = stack_get_status();
+    unsigned int before, deep;
+
+    TEST_CHECK(stack_high_water() == 0);    // nothing painted yet
+    stack_paint();
+    TEST_CHECK(s->size == HAL_HOST_STACK_BYTES);
+    before = stack_high_water();
+    TEST_CHECK(before >= STACK_GUARD && before < s->size / 4);
+
+    TEST_CHECK(test_nest(TEST_DEPTH) != 0);
+    deep = stack_high_water();
+    if(!TEST_CHECK(deep >= TEST_DEPTH * TEST_FRAME_BYTES && deep < s->size))
+        fprintf(stderr, "stack used %u before, %u after %d nested calls\n", before, deep, TEST_DEPTH);
+    TEST_CHECK(s->used == deep && s->free == s->size - deep);
+
+    // a shallower call leaves the mark where it was
+    TEST_CHECK(test_nest(1) != 0);
+    TEST_CHECK(stack_high_water() == deep);
+    return test_result();
+}
@@ -0,0 +1,144 @@
+/*
+ * File:   test_timing.c
+ * Author: Kevin Dederer
+ * Comments: host test of the interval measurement. Stamps with jitter, late
+ *           samples and gaps, across the wrap of the 32 bit clock, are fed to
+ *           timing_interval_dt(). Every interval has to come back clamped to
+ *           TIMING_DT_MIN..TIMING_DT_MAX with one ev_timing_clamped per
+ *           clamp, and the running mean and variance have to match the ones
+ *           computed in double from the same intervals.
+ * Revision history:
+ */
+
+#include <string.h>
+#include "config.h"
+#include "test.h"
+
+#define TEST_INTERVALS (20000)
+#define TEST_JITTER (0.2)           // of DT either way
+#define TEST_DT_TICKS (DT * CORE_TICKS_PER_US * 1e6)
+
+#define TEST_MESSAGE(id, message, arg) [id] = message,
+PRIVATE const char *test_message[EVLOG_EVENT_COUNT] = { EVLOG_EVENTS(TEST_MESSAGE) };
+#undef TEST_MESSAGE
+
+/*
+ * test_data - the reference statistics
+ * @param count - intervals fed
+ * @param sum, sum_sq - sum of the intervals and of their squares, us
+ * @param late, clamped - intervals expected to be counted so
+ * @param wrong - intervals that came back with another dt
+ * @param clamped_us - the clamped intervals in us, in order
+ */
+typedef struct
+{
+    unsigned int count;
+    double sum;
+    double sum_sq;
+    unsigned int late;
+    unsigned int clamped;
+    unsigned int wrong;
+    uint32_t clamped_us[8];
+} test_data;
+
+PRIVATE test_data test;
+
+/*
+ * TEST FEED - feeds the stamp that ends an interval and checks the dt
+ * @param *interval - the interval
+ * @param *stamp - the previous stamp, receives the new one
+ * @param ticks - the interval in core ticks
+ */
+PRIVATE void test_feed(timing_interval *interval, uint32_t *stamp, uint32_t ticks)
+{
+    double us = ticks / (double) CORE_TICKS_PER_US, dt = us * 1e-6;
+    float got;
+
+    *stamp += ticks;
+    got = timing_interval_dt(interval, *stamp);
+    test.count++;
+    test.sum += us;
+    test.sum_sq += us * us;
+    test.late += dt > TIMING_LATE_DT;
+    if(dt < TIMING_DT_MIN || dt > TIMING_DT_MAX)
+    {
+        if(test.clamped < sizeof(test.clamped_us) / sizeof(test.clamped_us[0]))
+            test.clamped_us[test.clamped] = (uint32_t) (float) us;
+        test.clamped++;
+        test.wrong += got != (float) (dt < TIMING_DT_MIN ? TIMING_DT_MIN : TIMING_DT_MAX);
+    }
+    else
+        test.wrong += fabs(got - dt) > dt * 1e-6;
+}
+
+/*
+ * TEST DRAIN - prints the logged events into a file
+ * @return the file, at its start.
+ */
+PRIVATE FILE *test_drain(void)
+{
+    FILE *out = stdout, *f = tmpfile();
+
+    if(f == NULL) return NULL;
+    fflush(stdout);
+    stdout = f;
+    while(evlog_drain());
+    stdout = out;
+    rewind(f);
+    return f;
+}
+
+int main(void)
+{
+    timing_interval interval = { 0 };
+    uint32_t stamp = 0xffffffff - 50 * (uint32_t) TEST_DT_TICKS;    // wraps early on
+    uint32_t seed = 1, ticks;
+    double mean, var;
+    char line[128], *message;
+    unsigned int i, events = 0;
+    FILE *log;
+
+    TEST_CHECK(timing_interval_dt(&interval, stamp) == (float) DT);
+    TEST_CHECK(interval.stats.count == 0);
+
+    for(i = 0; i < TEST_INTERVALS; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        ticks = TEST_DT_TICKS * (1 + TEST_JITTER * ((seed >> 8) / 8388608.0 - 1));
+        if(i % 1000 == 500) ticks = TEST_DT_TICKS * 2;      // a late sample
+        if(i == 3000) ticks = TEST_DT_TICKS * 4;            // at the limit, not clamped
+        if(i == 5000) ticks = TEST_DT_TICKS * 10;           // a gap
+        if(i == 7000) ticks = TEST_DT_TICKS / 8;            // a double sample
+        if(i == 9000) ticks = TEST_DT_TICKS * 1000;         // a long stall
+        test_feed(&interval, &stamp, ticks);
+    }
+
+    mean = test.sum / test.count;
+    var = (test.sum_sq - test.sum * mean) / (test.count - 1);
+    printf("timing: mean %.3f us against %.3f, jitter %.3f us against %.3f\n",
+           interval.stats.mean_us, mean, timing_jitter_us(&interval.stats), sqrt(var));
+    TEST_CHECK(test.wrong == 0);
+    TEST_CHECK(interval.stats.count == test.count);
+    TEST_CHECK(fabs(interval.stats.mean_us - mean) < mean * 1e-4);
+    TEST_CHECK(fabs(timing_jitter_us(&interval.stats) - sqrt(var)) < sqrt(var) * 1e-3);
+    TEST_CHECK(interval.stats.late == test.late);
+    TEST_CHECK(interval.stats.clamped == 3 && test.clamped == 3);
+    TEST_CHECK(interval.stats.max_us == (float) (TEST_DT_TICKS * 1000 / CORE_TICKS_PER_US));
+    TEST_CHECK(interval.stats.min_us == (float) (TEST_DT_TICKS / 8 / CORE_TICKS_PER_US));
+
+    // one event per clamp, with the measured us in order
+    log = test_drain();
+    if(!TEST_CHECK(log != NULL)) return test_result();
+    while(fgets(line, sizeof(line), log) != NULL)
+    {
+        message = strstr(line, test_message[ev_timing_clamped]);
+        if(message == NULL) continue;
+        if(events < test.clamped)
+            TEST_CHECK(strtoul(message + strlen(test_message[ev_timing_clamped]), NULL, 10) ==
+                       test.clamped_us[events]);
+        events++;
+    }
+    fclose(log);
+    TEST_CHECK(events == test.clamped);
+    return test_result();
+}
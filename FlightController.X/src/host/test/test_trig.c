@@ -0,0 +1,137 @@
+/*
+ * File:   test_trig.c
+ * Author: Kevin Dederer
+ * Comments: host test of the fixed point trigonometry against libm double.
+ *           Random inputs over the full range and the edges, the axes, +-pi
+ *           and the most negative integers, must stay within the errors
+ *           trig.c states. The test is built with trig.c under UBSan that
+ *           aborts, @see nbproject/Makefile-host.mk, so an overflow of the
+ *           binary angle arithmetic fails it in every build.
+ * Revision history:
+ */
+
+#include "config.h"
+#include "test.h"
+
+#define TEST_SAMPLES (1000000)
+#define TEST_ATAN2_RAD (1.4e-7)
+#define TEST_ATAN2F_RAD (8.8e-7)
+#define TEST_ASIN_RAD (3.1e-5)
+#define TEST_SINCOS (3.1e-5)
+
+/*
+ * test_data - the largest errors seen
+ * @param random - state of the random inputs
+ * @param atan2, atan2f, asin, sincos - largest error of each function
+ */
+typedef struct
+{
+    uint32_t random;
+    double atan2;
+    double atan2f;
+    double asin;
+    double sincos;
+} test_data;
+
+PRIVATE test_data test = { 12345, 0, 0, 0, 0 };
+
+/*
+ * TEST RANDOM - the next random integer, xorshift32
+ * @return any 32 bit value.
+ */
+PRIVATE uint32_t test_random(void)
+{
+    test.random ^= test.random << 13;
+    test.random ^= test.random >> 17;
+    test.random ^= test.random << 5;
+    return test.random;
+}
+
+/*
+ * TEST ANGLE ERROR - the difference of two angles around the circle
+ * @param a, b - the angles in radians
+ * @return |a - b| wrapped to 0..pi.
+ */
+PRIVATE double test_angle_error(double a, double b)
+{
+    return fabs(remainder(a - b, 2 * M_PI));
+}
+
+/*
+ * TEST ATAN2 - one input of trig_atan2
+ * @param y, x - the components
+ */
+PRIVATE void test_atan2(int32_t y, int32_t x)
+{
+    double e;
+
+    if(x == 0 && y == 0)
+        e = trig_atan2(y, x) == 0 ? 0 : M_PI;
+    else
+        e = test_angle_error(trig_atan2(y, x) * TRIG_RAD_PER_UNIT, atan2(y, x));
+    if(e > test.atan2) test.atan2 = e;
+}
+
+/*
+ * TEST SINCOS - one input of trig_sincos
+ * @param angle - the binary angle
+ */
+PRIVATE void test_sincos(int32_t angle)
+{
+    double rad = angle * TRIG_RAD_PER_UNIT, e;
+    int16_t s, c;
+
+    trig_sincos(angle, &s, &c);
+    e = fmax(fabs(s / 32768.0 - fmin(sin(rad), 32767 / 32768.0)),
+             fabs(c / 32768.0 - fmin(cos(rad), 32767 / 32768.0)));
+    if(e > test.sincos) test.sincos = e;
+}
+
+int main(void)
+{
+    static const int32_t edge[] = { 0, 1, -1, 2, 255, -256, 32767, -32768, 0x10000000,
+                                    -0x10000000, INT32_MAX - 1, INT32_MAX, INT32_MIN + 1, INT32_MIN };
+    const int edges = sizeof(edge) / sizeof(edge[0]);
+    float y, x;
+    double e;
+    int i, j;
+
+    for(i = 0; i < edges; i++)
+    {
+        for(j = 0; j < edges; j++)
+            test_atan2(edge[i], edge[j]);
+        test_sincos(edge[i]);
+        test_sincos((uint32_t) edge[i] + TRIG_PI_2);
+        test_sincos((uint32_t) edge[i] - TRIG_PI_2);
+    }
+    for(i = 0; i < TEST_SAMPLES; i++)
+    {
+        // a random scale so small vectors are as likely as large ones
+        j = test_random() % 32;
+        test_atan2((int32_t) test_random() >> j, (int32_t) test_random() >> j);
+        // just either side of the negative x axis, where the angle wraps
+        test_atan2((int32_t) (test_random() % 2048) - 1024, -(int32_t) (test_random() >> 1));
+        test_sincos(test_random());
+
+        // components from 1mg to 8g of either sign
+        y = ldexpf(1 + (test_random() & 0xffff) / 65536.0f, (int) (test_random() % 13) - 10);
+        x = ldexpf(1 + (test_random() & 0xffff) / 65536.0f, (int) (test_random() % 13) - 10);
+        if(test_random() & 1) y = -y;
+        if(test_random() & 1) x = -x;
+        e = test_angle_error(trig_atan2f(y, x), atan2(y, x));
+        if(e > test.atan2f) test.atan2f = e;
+    }
+    for(i = -32768; i <= 32767; i++)
+    {
+        e = fabs(trig_asin(i) * TRIG_RAD_PER_UNIT - asin(i / 32768.0));
+        if(e > test.asin) test.asin = e;
+    }
+
+    printf("trig: largest errors atan2 %.3g, atan2f %.3g, asin %.3g, sincos %.3g\n",
+           test.atan2, test.atan2f, test.asin, test.sincos);
+    TEST_CHECK(test.atan2 <= TEST_ATAN2_RAD);
+    TEST_CHECK(test.atan2f <= TEST_ATAN2F_RAD);
+    TEST_CHECK(test.asin <= TEST_ASIN_RAD);
+    TEST_CHECK(test.sincos <= TEST_SINCOS);
+    return test_result();
+}
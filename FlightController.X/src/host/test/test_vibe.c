@@ -0,0 +1,109 @@
+/*
+ * File:   test_vibe.c
+ * Author: Kevin Dederer
+ * Comments: host test of the vibration analyser and the dynamic notch. A full
+ *           scale tone must come out of the fft as the largest bin by far. A
+ *           vibration swept across the band must tune the notch onto it and
+ *           be removed by it while the attitude band passes. Below
+ *           VIBE_MIN_SAMPLE_HZ the notch must stay off.
+ * Revision history:
+ */
+
+#include "config.h"
+#include "test.h"
+
+#define TEST_POINTS (1 << VIBE_FFT_LOG2)
+#define TEST_AMPLITUDE (4000)           // counts, about 0.25g at 2g full scale
+#define TEST_SETTLE (PIPE_SAMPLE_HZ)    // samples for the notch history to settle
+#define TEST_TRACK_SAMPLES (40 * TEST_POINTS)   // analyses for the centre to converge
+#define TEST_PEAK_HZ (PIPE_SAMPLE_HZ / (double) TEST_POINTS / 2)    // half a bin
+
+/*
+ * TEST TONE - a sample of a sine
+ * @param hz - its frequency
+ * @param n - the sample index at PIPE_SAMPLE_HZ
+ * @param amplitude - its amplitude in counts
+ * @return the sample.
+ */
+PRIVATE int16_t test_tone(double hz, int n, double amplitude)
+{
+    return lround(amplitude * sin(2 * M_PI * hz * n / PIPE_SAMPLE_HZ));
+}
+
+/*
+ * TEST NOTCH GAIN - runs a tone through the notch and measures what is left
+ * @param hz - the tone
+ * @return the output peak over the input peak, after settling.
+ */
+PRIVATE double test_notch_gain(double hz)
+{
+    notch_state state = { 0, 0, 0, 0 };
+    int16_t x;
+    int n, in = 0, out = 0;
+
+    for(n = 0; n < 2 * TEST_SETTLE; n++)
+    {
+        x = test_tone(hz, n, TEST_AMPLITUDE);
+        if(n >= TEST_SETTLE && abs(x) > in) in = abs(x);
+        vibe_notch(&x, 1, &state);
+        if(n >= TEST_SETTLE && abs(x) > out) out = abs(x);
+    }
+    return out / (double) in;
+}
+
+/*
+ * TEST FFT FULL SCALE - a full scale tone on bin k must give the largest bin
+ */
+PRIVATE void test_fft_full_scale(void)
+{
+    int16_t re[TEST_POINTS / 2], im[TEST_POINTS / 2];
+    uint32_t power[TEST_POINTS / 2];
+    int n, k, bin = TEST_POINTS / 8;
+
+    for(n = 0; n < TEST_POINTS / 2; n++)
+    {
+        re[n] = lround(32767 * cos(2 * M_PI * bin * (2 * n) / TEST_POINTS));
+        im[n] = lround(32767 * cos(2 * M_PI * bin * (2 * n + 1) / TEST_POINTS));
+    }
+    fft_complex_q15(re, im, VIBE_FFT_LOG2 - 1);
+    fft_real_power(re, im, VIBE_FFT_LOG2 - 1, power);
+    for(k = 0; k < TEST_POINTS / 2; k++)
+        if(k != bin) TEST_CHECK(power[k] < power[bin] / 100);
+}
+
+int main(void)
+{
+    static const double sweep[] = { 0.08, 0.15, 0.25, 0.35, 0.42 };   // of PIPE_SAMPLE_HZ
+    double hz;
+    int i, n = 0, end;
+
+    test_fft_full_scale();
+
+    if(PIPE_SAMPLE_HZ < 400)
+    {
+        for(n = 0; n < TEST_TRACK_SAMPLES; n++)
+        {
+            vibe_push_sample(test_tone(0.3 * PIPE_SAMPLE_HZ, n, TEST_AMPLITUDE));
+            while(vibe_step());
+        }
+        TEST_CHECK(vibe_peak_hz() == 0);
+        TEST_CHECK(test_notch_gain(0.3 * PIPE_SAMPLE_HZ) == 1);
+        return test_result();
+    }
+
+    for(i = 0; i < (int) (sizeof(sweep) / sizeof(sweep[0])); i++)
+    {
+        // the tone rides on gravity and a slow attitude swing, as in flight
+        hz = sweep[i] * PIPE_SAMPLE_HZ;
+        for(end = n + TEST_TRACK_SAMPLES; n < end; n++)
+        {
+            vibe_push_sample(16384 + test_tone(1, n, 2000) + test_tone(hz, n, TEST_AMPLITUDE));
+            while(vibe_step());
+        }
+        if(!TEST_CHECK(fabs(vibe_peak_hz() - hz) < TEST_PEAK_HZ))
+            fprintf(stderr, "tone %.1fhz, notch at %.1fhz\n", hz, vibe_peak_hz());
+        TEST_CHECK(test_notch_gain(hz) < 0.1);
+        TEST_CHECK(test_notch_gain(2) > 0.95);
+    }
+    return test_result();
+}
@@ -1,339 +1,525 @@
-/* 
- * File:   i2c.c
- * Author: tbriggs, Kevin Dederer
- * Comments: main logic file for the i2c bus operation
- * Revision history: 
- */
-
-#include "config.h"
-
-#define I2C_I2C_BUS (I2C2)
-#define I2C_DELAY (32)
-
-int i2c_wait_timeout = 0;
-
-#define I2C_WAIT_USDELAY(x,y) \
-{ i2c_wait_timeout = 0; \
-  unsigned int __end = ReadCoreTimer() + (GetInstructionClock() / 4000000L) * y; \
-  while((x(I2C_I2C_BUS) == 0) && (ReadCoreTimer() < __end)); \
-  i2c_wait_timeout = (ReadCoreTimer() >= __end)  ? 1 : 0; } \
-
-#define I2C_WAIT(x) \
-{ while((x(I2C_I2C_BUS) == 0)); } \
-
-#define I2C_TRY(x) \
-{ int _rc; rc = x; if (rc != 0) goto error; } \
-
-#ifndef EOK
-#define EOK 0
-#endif
-
-#ifndef EDATA
-#define EDATA 13
-#endif
-
-/**
- * I2C DELAY - delay for given number of microseconds.
- * @param usecs
- */
-void i2c_delay(int usecs) 
-{
-    unsigned int start = ReadCoreTimer();
-    unsigned int dtime = (GetSystemClock() / 4000000L) * usecs;
-    while ((ReadCoreTimer() - start) < dtime);
-}
-
-/**
- * I2C START - Start an I2C bus transaction (required at the start of every I2C transaction
- * @param restart - whether this is a second start without a stop in between
- * @return EOK if no error, -EBADF if start was not successfully sent
- */
-int i2c_start(int restart) 
-{
-    I2C_STATUS status;
-
-    int rc;
-    if (restart) 
-    {
-        rc =I2CRepeatStart(I2C_I2C_BUS);
-    }
-    else 
-    {
-        I2C_WAIT(I2CBusIsIdle);
-
-        rc = I2CStart(I2C_I2C_BUS);
-    }
-    if (rc != I2C_SUCCESS)
-        return -EBADF;
-
-    I2C_WAIT(I2CTransmissionHasCompleted);
-
-    do 
-    {
-        status = I2CGetStatus(I2C_I2C_BUS);
-    } while (!(status & I2C_START));
-
-    i2c_delay(10);
-    return EOK;
-}
-
-/**
- * I2C STOP - Stop transmission.
- */
-void i2c_stop() 
-{
-    I2C_STATUS status;
-
-    I2C_WAIT(I2CTransmitterIsReady);
-
-    I2CStop(I2C_I2C_BUS);
-
-    do 
-    {
-        status = I2CGetStatus(I2C_I2C_BUS);
-    } while (!(status & (I2C_STOP)));
-}
-
-/**
- * I2C XMIT BYTE - Transmit one byte (internal use)
- * @param data Byte to transfer
- * @return EOK or -EDATA
- */
-int i2c_xmit_byte(UINT8 data) 
-{
-    I2C_STATUS status;
-
-    I2C_WAIT_USDELAY(I2CTransmitterIsReady, I2C_DELAY);
-    if (i2c_wait_timeout) 
-    {
-        printf("ERROR: XMIT timed out waiting for transmitter\n");
-        return -EDATA;
-    }
-
-    if (I2CSendByte(I2C_I2C_BUS, data) != I2C_SUCCESS) 
-    {
-        printf("ERROR: XMIT master bus collision (%x)\n", I2CGetStatus(I2C_I2C_BUS));
-        return -EDATA;
-    }
-
-    I2C_WAIT(I2CTransmissionHasCompleted);
-
-    if (I2CByteWasAcknowledged(I2C_I2C_BUS))
-        return EOK;
-
-    status = I2CGetStatus(I2C_I2C_BUS);
-    if (status & I2C_ARBITRATION_LOSS)
-    {
-        printf("ERROR: ARBITRATION LOSS\n");
-        return -EDATA;
-    }
-    else if (status & I2C_TRANSMITTER_OVERFLOW)
-    {
-        printf("ERROR: XMIT Overflow ");
-        return -EDATA;
-    }
-    else if (status & I2C_BYTE_ACKNOWLEDGED)
-    {
-        return EOK;
-    }
-    else 
-    {
-        printf("ERROR: XMIT Unspecified error %x\n", status);
-        return -EDATA;
-    }
-}
-
-/**
- * I2C RCV BYTE Receive one byte from I2C bus - internal transaction
- * @param byte byte that was received
- * @param ack whether to acknowledge
- * @return EOK or -EDATA
- */
-int i2c_rcv_byte(UINT8 ack, UINT8 *byte)
-{
-    UINT8 inp;
-    int rc;
-
-    rc = I2CReceiverEnable(I2C_I2C_BUS, TRUE);
-    if (rc == I2C_RECEIVE_OVERFLOW)
-        return -EDATA;
-
-    while (!I2CReceivedDataIsAvailable(I2C_I2C_BUS));
-
-    inp = I2CGetByte(I2C_I2C_BUS);
-
-    I2CAcknowledgeByte(I2C_I2C_BUS, ack);
-    I2C_WAIT(I2CAcknowledgeHasCompleted);
-
-    *byte = inp;
-    
-    return EOK;
-}
-
-/**
- * I2C OPEN - Open I2C controller.
- * @return EOK if controller opened, or -EBADF if bus clock cannot be achieved.
- */
-int i2c_open() 
-{
-    unsigned int actualClock;
-
-    I2CConfigure(I2C_I2C_BUS, I2C_ENABLE_SLAVE_CLOCK_STRETCHING);
-    actualClock = I2CSetFrequency(I2C_I2C_BUS, GetSystemClock(), I2C_CLOCK_FREQ);
-    if (abs(actualClock - I2C_CLOCK_FREQ) > I2C_CLOCK_FREQ / 10) 
-    {
-        printf("Error: I2C Bus Clock Frequency error exceeds 10%%\n");
-        return -EBADF;
-    }
-
-    I2CEnable(I2C_I2C_BUS, TRUE);
-    
-    return EOK;
-}
-
-/**
- * I2C CLOSE - Close I2C controller
- */
-void i2c_close() {
-    I2CEnable(I2C_I2C_BUS, FALSE);
-}
-
-/*
- * I2C WRITE DEV ADDRESS - sends a write signal to the slave
- * @param dev_address the 7 bit address of the slave
- * @return EOK or -EDATA 
- */
-int i2c_write_dev_address(uint8_t dev_address)
-{
-    I2C_7_BIT_ADDRESS i2c_ctrl;
-    
-    I2C_FORMAT_7_BIT_ADDRESS(i2c_ctrl, dev_address, I2C_WRITE);
-
-    I2C_WAIT(I2CTransmissionHasCompleted);
-
-    // next, we send another "write" command, and wait for it to ack
-    // that we know the command is done - this write ack polling
-    int count = 100;
-    while (--count > 0) {
-        I2C_WAIT(I2CTransmitterIsReady);
-        i2c_start(0);
-
-        I2C_WAIT(I2CTransmitterIsReady);
-        I2CSendByte(I2C_I2C_BUS,i2c_ctrl.byte);
-
-        I2C_WAIT(I2CTransmissionHasCompleted);
-
-        if (I2CByteWasAcknowledged(I2C_I2C_BUS))
-            break;
-
-        i2c_stop();
-        i2c_delay(I2C_DELAY);
-    }
-    
-    if (count == 0) return -1;
-    return 0;
-}
-
-/*
- * I2C READ DEV ADDRESS - sends a read command to the slave
- * @param dev_address - the 7 bit address of the slave
- * @return EOK or -EDATA
- */
-int i2c_read_dev_address(uint8_t dev_address)
-{
-    I2C_7_BIT_ADDRESS i2c_ctrl;
-    
-    I2C_FORMAT_7_BIT_ADDRESS(i2c_ctrl, dev_address, I2C_READ);
-
-    I2C_WAIT(I2CTransmissionHasCompleted);
-
-    i2c_start(1);
-    I2C_WAIT(I2CTransmitterIsReady);
-    
-    I2CSendByte(I2C_I2C_BUS,i2c_ctrl.byte);
-
-    I2C_WAIT(I2CTransmissionHasCompleted);
-
-    if (I2CByteWasAcknowledged(I2C_I2C_BUS))
-        return 0;
-    else
-        return -1;
-}
-    
-/*
- * LSM330 READ REG - reads the byte transmitted by the slave
- * @param dev - the device address of the slave
- * @param reg - the register address in the slave to be accessed
- * @param data - the byte to be read
- * @return EOK or -EDATA
- */
-int lsm330_read_reg(uint8_t dev, uint8_t reg, uint8_t *data)
-{
-    if (i2c_open() <0) return -1;
-    
-    if (i2c_write_dev_address(dev) < 0) return -1;
-    
-    if (i2c_xmit_byte(reg) < 0) return -1;
-    
-    if (i2c_read_dev_address(dev)< 0) return -1;
-    
-    if(i2c_rcv_byte(0, data) < 0) return -1;
-
-    i2c_stop();
-
-    return 0;
-}
-
-/*
- * LSM330 WRITE REG - writes a byte to the slave
- * @param dev - the device address of the slave
- * @param reg - the register address in the slave to be written to
- * @param data - the byte to be written
- * @return EOK or -EDATA
- */
-int lsm330_write_reg(uint8_t dev, uint8_t reg, uint8_t data)
-{
-    if (i2c_open() <0) return -1;
-    
-    if (i2c_write_dev_address(dev) < 0) return -1;
-    
-    if (i2c_xmit_byte(reg) < 0) return -1;
-    
-    if (i2c_xmit_byte(data) < 0) return -1;
-    
-    i2c_stop();
-    
-    return 0;
-}
-
-/*
- * LSM330 READ MULTIPLE REG - completes a multi-register read from the slave
- * @param dev - the 7 bit address of the slave
- * @param reg - one byte of data including the 7 bit address of the register in the
- *              slave to be read from and 1 bit indicating that it is a multiple 
- *              register read
- * @param data - pointer to an array to store the read bytes
- * @return EOK or -EDATA
- */
-int lsm330_read_multiple_reg(uint8_t dev, uint8_t reg, UINT8 data[6])
-{
-    int ack, i, err;
-    
-    if (i2c_open() <0) return -1;
-
-    if (i2c_write_dev_address(dev) < 0) return -1;
-
-    if (i2c_xmit_byte(reg) < 0) return -1;
-
-    if (i2c_read_dev_address(dev) < 0) return -1;
-
-    for(i = 0; i < 6; i++)
-    {
-        ack = (i == 5) ? 0 : 1;
-        if(i2c_rcv_byte(ack,&data[i]) < 0) return -1;
-    }
-       
-    i2c_stop();
-
-    return 0;
-}
\ No newline at end of file
+/* 
+ * File:   i2c.c
+ * Author: tbriggs, Kevin Dederer
+ * Comments: main logic file for the i2c bus operation. Every wait on the bus
+ *           is bounded by I2C_TIMEOUT_US and by the I2C_TRANSACTION_US budget
+ *           of the transaction it belongs to. A transaction that fails with
+ *           the bus in an unknown state recovers the bus before returning.
+ * Revision history: 
+ */
+
+#include <string.h>
+#include "config.h"
+
+#define I2C_DELAY (32)
+#define I2C_READ_BIT (1)            // r/w bit after the 7 bit address
+#define I2C_RECOVERY_HALF_US (5)    // half period of the recovery clock, 100khz
+#define I2C_ADDRESS_TRIES (3)       // address bytes sent before a slave counts as absent
+
+PRIVATE unsigned int i2c_transaction_start;
+PRIVATE i2c_status driver_status;
+
+#ifdef I2C_PROFILE
+PRIVATE i2c_traffic traffic[I2C_OPS];
+PRIVATE i2c_traffic *i2c_current = &traffic[op_read_reg];
+PRIVATE uint32_t traffic_since;     // timestamp of the last reset
+PRIVATE const char *traffic_name[I2C_OPS] = { "read_reg", "write_reg", "read_multiple" };
+#define I2C_COUNT(field) (i2c_current->field++)
+#else
+#define I2C_COUNT(field)
+#endif
+
+/*
+ * I2C WAIT - waits until the given bus function reports true, returns
+ *          i2c_timeout from the calling function if it does not in time.
+ */
+#define I2C_WAIT(x) \
+{ unsigned int __start = hal_core_ticks(); \
+  while((x() == 0)) \
+      if (i2c_expired(__start)) return i2c_fail(i2c_timeout); } \
+
+/*
+ * I2C WAIT STATUS - waits until the given bit is set in the bus status,
+ *          returns i2c_timeout from the calling function if it is not in time.
+ */
+#define I2C_WAIT_STATUS(x) \
+{ unsigned int __start = hal_core_ticks(); \
+  while(!(hal_i2c_status() & (x))) \
+      if (i2c_expired(__start)) return i2c_fail(i2c_timeout); } \
+
+#define I2C_TRY(x) \
+{ rc = x; if (rc != 0) goto error; } \
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*
+ * I2C EXPIRED - checks a wait against its own limit and the transaction budget
+ * @param start - core timer value when the wait started
+ * @return 1 if the wait has to give up, 0 otherwise.
+ */
+PRIVATE int i2c_expired(unsigned int start)
+{
+    unsigned int now = hal_core_ticks();
+
+    return (now - start) > I2C_TIMEOUT_US * CORE_TICKS_PER_US ||
+           (now - i2c_transaction_start) > I2C_TRANSACTION_US * CORE_TICKS_PER_US;
+}
+
+/*
+ * I2C FAIL - records an error
+ * @param error - the error code
+ * @return the error code, so it can be returned directly.
+ */
+PRIVATE int i2c_fail(enum i2c_error error)
+{
+    driver_status.last_error = error;
+    driver_status.errors[-error]++;
+    return error;
+}
+
+/**
+ * I2C DELAY - delay for given number of microseconds.
+ * @param usecs
+ */
+void i2c_delay(int usecs) 
+{
+    unsigned int start = hal_core_ticks();
+    unsigned int dtime = CORE_TICKS_PER_US * usecs;
+    while ((hal_core_ticks() - start) < dtime);
+}
+
+/**
+ * I2C START - Start an I2C bus transaction (required at the start of every I2C transaction
+ * @param restart - whether this is a second start without a stop in between
+ * @return EOK if no error, i2c_collision if start was not successfully sent,
+ *          i2c_timeout if the bus did not respond in time
+ */
+int i2c_start(int restart) 
+{
+    int rc;
+    if (restart) 
+    {
+        rc = hal_i2c_restart();
+    }
+    else 
+    {
+        I2C_WAIT(hal_i2c_idle);
+
+        rc = hal_i2c_start();
+    }
+    if (rc != 0)
+        return i2c_fail(i2c_collision);
+    I2C_COUNT(starts);
+
+    I2C_WAIT(hal_i2c_tx_done);
+
+    I2C_WAIT_STATUS(HAL_I2C_START);
+
+    i2c_delay(10);
+    return EOK;
+}
+
+/**
+ * I2C STOP - Stop transmission.
+ * @return EOK or i2c_timeout
+ */
+int i2c_stop()
+{
+    I2C_WAIT(hal_i2c_tx_ready);
+
+    hal_i2c_stop();
+
+    I2C_WAIT_STATUS(HAL_I2C_STOP);
+
+    return EOK;
+}
+
+/**
+ * I2C XMIT BYTE - Transmit one byte (internal use)
+ * @param data Byte to transfer
+ * @return EOK or a negative i2c_error
+ */
+int i2c_xmit_byte(UINT8 data) 
+{
+    unsigned int status;
+
+    I2C_WAIT(hal_i2c_tx_ready);
+
+    if (hal_i2c_send(data) != 0) 
+    {
+        evlog_write(ev_i2c_collision, hal_i2c_status());
+        return i2c_fail(i2c_collision);
+    }
+    I2C_COUNT(data_bytes);
+
+    I2C_WAIT(hal_i2c_tx_done);
+
+    if (hal_i2c_acked())
+        return EOK;
+
+    status = hal_i2c_status();
+    if (status & HAL_I2C_ARBITRATION_LOSS)
+    {
+        evlog_write(ev_i2c_arbitration, status);
+        return i2c_fail(i2c_arbitration);
+    }
+    else if (status & HAL_I2C_TRANSMITTER_OVERFLOW)
+    {
+        evlog_write(ev_i2c_overflow, status);
+        return i2c_fail(i2c_overflow);
+    }
+    else 
+    {
+        // HAL_I2C_BYTE_ACKNOWLEDGED is the ACKSTAT bit, set when the slave did not acknowledge
+        evlog_write(ev_i2c_unspecified, status);
+        return i2c_fail(i2c_nack);
+    }
+}
+
+/**
+ * I2C RCV BYTE Receive one byte from I2C bus - internal transaction
+ * @param byte byte that was received
+ * @param ack whether to acknowledge
+ * @return EOK, i2c_overflow or i2c_timeout
+ */
+int i2c_rcv_byte(UINT8 ack, UINT8 *byte)
+{
+    UINT8 inp;
+    if (hal_i2c_receive() != 0)
+        return i2c_fail(i2c_overflow);
+    I2C_COUNT(data_bytes);
+
+    I2C_WAIT(hal_i2c_rx_ready);
+
+    inp = hal_i2c_get();
+
+    hal_i2c_ack(ack);
+    I2C_WAIT(hal_i2c_ack_done);
+
+    *byte = inp;
+    
+    return EOK;
+}
+
+/**
+ * I2C OPEN - Open I2C controller.
+ * @return EOK if controller opened, or i2c_clock if bus clock cannot be achieved.
+ */
+int i2c_open() 
+{
+    unsigned int actualClock;
+
+    actualClock = hal_i2c_configure(I2C_CLOCK_FREQ);
+    if (abs((int) actualClock - I2C_CLOCK_FREQ) > I2C_CLOCK_FREQ / 10) 
+    {
+        evlog_write(ev_i2c_clock, actualClock);
+        return i2c_fail(i2c_clock);
+    }
+
+    hal_i2c_enable(TRUE);
+    
+    return EOK;
+}
+
+/**
+ * I2C CLOSE - Close I2C controller
+ */
+void i2c_close() {
+    hal_i2c_enable(FALSE);
+}
+
+/*
+ * I2C RECOVER - frees a bus held by a slave that is part way through a byte.
+ *          The controller is released, SCL is clocked 9 times so the slave
+ *          can finish, a STOP is sent by hand and the controller is opened again.
+ */
+void i2c_recover()
+{
+    int i;
+
+    i2c_close();
+    hal_i2c_pins_claim();
+
+    for (i = 0; i < 9; i++)
+    {
+        hal_i2c_scl(FALSE);
+        i2c_delay(I2C_RECOVERY_HALF_US);
+        hal_i2c_scl(TRUE);
+        i2c_delay(I2C_RECOVERY_HALF_US);
+    }
+
+    // STOP, SDA rising while SCL is high
+    hal_i2c_scl(FALSE);
+    hal_i2c_sda(FALSE);
+    i2c_delay(I2C_RECOVERY_HALF_US);
+    hal_i2c_scl(TRUE);
+    i2c_delay(I2C_RECOVERY_HALF_US);
+    hal_i2c_sda(TRUE);
+    i2c_delay(I2C_RECOVERY_HALF_US);
+
+    hal_i2c_pins_release();
+    driver_status.recoveries++;
+    i2c_open();
+}
+
+/*
+ * I2C WRITE DEV ADDRESS - sends a write signal to the slave. A slave that
+ *          is busy may not acknowledge, the address is tried
+ *          I2C_ADDRESS_TRIES times before it counts as absent, well within
+ *          the transaction budget so an absent slave ends as a nack.
+ * @param dev_address the 7 bit address of the slave
+ * @return EOK or a negative i2c_error, i2c_nack still holding the bus like
+ *          every other nack, i2c_end() stops it
+ */
+int i2c_write_dev_address(uint8_t dev_address)
+{
+    uint8_t i2c_ctrl = dev_address << 1;
+    int rc, tries;
+    
+    I2C_WAIT(hal_i2c_tx_done);
+
+    for (tries = 1; ; tries++) {
+        I2C_WAIT(hal_i2c_tx_ready);
+        if ((rc = i2c_start(0)) != EOK) return rc;
+
+        I2C_WAIT(hal_i2c_tx_ready);
+        hal_i2c_send(i2c_ctrl);
+        I2C_COUNT(address_bytes);
+
+        I2C_WAIT(hal_i2c_tx_done);
+
+        if (hal_i2c_acked())
+            return EOK;
+        I2C_COUNT(nack_retries);
+
+        if (tries == I2C_ADDRESS_TRIES) return i2c_fail(i2c_nack);   // i2c_end() stops it
+        if ((rc = i2c_stop()) != EOK) return rc;
+        i2c_delay(I2C_DELAY);
+    }
+}
+
+/*
+ * I2C READ DEV ADDRESS - sends a read command to the slave
+ * @param dev_address - the 7 bit address of the slave
+ * @return EOK or a negative i2c_error
+ */
+int i2c_read_dev_address(uint8_t dev_address)
+{
+    uint8_t i2c_ctrl = (dev_address << 1) | I2C_READ_BIT;
+    int rc;
+    
+    I2C_WAIT(hal_i2c_tx_done);
+
+    if ((rc = i2c_start(1)) != EOK) return rc;
+    I2C_WAIT(hal_i2c_tx_ready);
+    
+    hal_i2c_send(i2c_ctrl);
+    I2C_COUNT(address_bytes);
+
+    I2C_WAIT(hal_i2c_tx_done);
+
+    if (hal_i2c_acked())
+        return EOK;
+    I2C_COUNT(nack_retries);
+    return i2c_fail(i2c_nack);
+}
+    
+#ifndef LSM330_USE_SPI
+
+/*
+ * I2C BEGIN - starts the time budget of a new transaction
+ * @param op - the logical operation, for the traffic profiler
+ */
+PRIVATE void i2c_begin(enum i2c_op op)
+{
+#ifdef I2C_PROFILE
+    i2c_current = &traffic[op];
+    i2c_current->calls++;
+#else
+    (void) op;
+#endif
+    i2c_transaction_start = hal_core_ticks();
+}
+
+/*
+ * I2C END - finishes a transaction, recovering the bus if it failed part way
+ * @param rc - the result of the transaction
+ * @return rc
+ */
+PRIVATE int i2c_end(int rc)
+{
+    unsigned int ticks = hal_core_ticks() - i2c_transaction_start;
+    unsigned int us = ticks / CORE_TICKS_PER_US;
+
+    // a slave that did not acknowledge has left the bus in a known state
+    if (rc != EOK && !(rc == i2c_nack && i2c_stop() == EOK))
+    {
+        i2c_recover();
+        evlog_write(ev_i2c_recover, rc);
+    }
+
+    if (us > driver_status.max_us) driver_status.max_us = us;
+#ifdef I2C_PROFILE
+    ticks = hal_core_ticks() - i2c_transaction_start;    // including the recovery
+    i2c_current->ticks += ticks;
+    if (ticks > i2c_current->max_ticks) i2c_current->max_ticks = ticks;
+    if (rc != EOK) i2c_current->failed++;
+#endif
+    return rc;
+}
+
+/*
+ * LSM330 READ REG - reads the byte transmitted by the slave
+ * @param *bus - the device, @see lsm330_bus
+ * @param reg - the register address in the slave to be accessed
+ * @param data - the byte to be read
+ * @return EOK or a negative i2c_error
+ */
+int lsm330_read_reg(const lsm330_bus *bus, uint8_t reg, uint8_t *data)
+{
+    int rc;
+    
+    i2c_begin(op_read_reg);
+    
+    I2C_TRY(i2c_open());
+    
+    I2C_TRY(i2c_write_dev_address(bus->addr));
+    
+    I2C_TRY(i2c_xmit_byte(reg));
+
+    I2C_TRY(i2c_read_dev_address(bus->addr));
+
+    I2C_TRY(i2c_rcv_byte(0, data));
+
+    I2C_TRY(i2c_stop());
+
+error:
+    return i2c_end(rc);
+}
+
+/*
+ * LSM330 WRITE REG - writes a byte to the slave
+ * @param *bus - the device, @see lsm330_bus
+ * @param reg - the register address in the slave to be written to
+ * @param data - the byte to be written
+ * @return EOK or a negative i2c_error
+ */
+int lsm330_write_reg(const lsm330_bus *bus, uint8_t reg, uint8_t data)
+{
+    int rc;
+    
+    i2c_begin(op_write_reg);
+    
+    I2C_TRY(i2c_open());
+    
+    I2C_TRY(i2c_write_dev_address(bus->addr));
+    
+    I2C_TRY(i2c_xmit_byte(reg));
+    
+    I2C_TRY(i2c_xmit_byte(data));
+
+    I2C_TRY(i2c_stop());
+
+error:
+    return i2c_end(rc);
+}
+
+/*
+ * LSM330 READ MULTIPLE REG - completes a multi-register read from the slave
+ * @param *bus - the device, @see lsm330_bus
+ * @param reg - one byte of data including the 7 bit address of the register in the
+ *              slave to be read from and 1 bit indicating that it is a multiple 
+ *              register read
+ * @param data - pointer to an array to store the read bytes
+ * @param len - the number of bytes to read
+ * @return EOK or a negative i2c_error
+ */
+int lsm330_read_multiple_reg(const lsm330_bus *bus, uint8_t reg, UINT8 *data, int len)
+{
+    int ack, i, rc;
+    
+    i2c_begin(op_read_multiple);
+
+    I2C_TRY(i2c_open());
+
+    I2C_TRY(i2c_write_dev_address(bus->addr));
+
+    I2C_TRY(i2c_xmit_byte(reg));
+
+    I2C_TRY(i2c_read_dev_address(bus->addr));
+
+    for(i = 0; i < len; i++)
+    {
+        ack = (i == len - 1) ? 0 : 1;
+        I2C_TRY(i2c_rcv_byte(ack,&data[i]));
+    }
+       
+    I2C_TRY(i2c_stop());
+
+error:
+    return i2c_end(rc);
+}
+
+#endif /* LSM330_USE_SPI */
+
+/*
+ * I2C GET STATUS - read only access to the driver error counters
+ * @return pointer to the driver status.
+ */
+const i2c_status *i2c_get_status(void)
+{
+    return &driver_status;
+}
+
+#ifdef I2C_PROFILE
+
+/*
+ * I2C PROFILE RESET - clears the traffic counters and starts a new window
+ */
+void i2c_profile_reset(void)
+{
+    memset(traffic, 0, sizeof(traffic));
+    traffic_since = timing_now();
+}
+
+/*
+ * I2C PROFILE GET - read only access to the traffic of one operation
+ * @param op - the operation
+ * @return the counters since the last reset.
+ */
+const i2c_traffic *i2c_profile_get(enum i2c_op op)
+{
+    return &traffic[op];
+}
+
+/*
+ * I2C PROFILE REPORT - prints the traffic since the last reset as one JSON
+ *              line, busy_pct is the share of the window spent in operations
+ */
+void i2c_profile_report(void)
+{
+    float window = (timing_now() - traffic_since) / (float) CORE_TICKS_PER_US;
+    uint64_t busy = 0;
+    int i;
+
+    for (i = 0; i < I2C_OPS; i++)
+        busy += traffic[i].ticks;
+    printf("{\"i2c\":{\"window_us\":%.0f,\"clock_hz\":%u,\"busy_pct\":%.2f,\"ops\":[",
+           window, I2C_CLOCK_FREQ, window > 0 ? 100 * (busy / (float) CORE_TICKS_PER_US) / window : 0.0);
+    for (i = 0; i < I2C_OPS; i++)
+    {
+        const i2c_traffic *t = &traffic[i];
+
+        printf("%s{\"name\":\"%s\",\"calls\":%u,\"failed\":%u,\"starts\":%u,\"address_bytes\":%u,"
+               "\"data_bytes\":%u,\"nack_retries\":%u,\"mean_us\":%.1f,\"max_us\":%.1f}",
+               i ? "," : "", traffic_name[i], t->calls, t->failed, t->starts, t->address_bytes,
+               t->data_bytes, t->nack_retries,
+               t->calls ? t->ticks / (float) CORE_TICKS_PER_US / t->calls : 0.0,
+               t->max_ticks / (float) CORE_TICKS_PER_US);
+    }
+    printf("]}}\n");
+}
+
+#endif /* I2C_PROFILE */
@@ -1,24 +1,107 @@
-/* 
- * File:   i2c.h
- * Author: tbriggs, Kevin Dederer
- * Comments: Header file for the i2c bus
- * Revision history: 
- */
-
-#ifndef I2C_H
-#define	I2C_H
-
-#ifdef	__cplusplus
-extern "C" {
-#endif
-
-int lsm330_read_reg(uint8_t dev, uint8_t reg, uint8_t *data);
-int lsm330_write_reg(uint8_t dev, uint8_t reg, uint8_t data);
-int lsm330_read_multiple_reg(uint8_t dev, uint8_t reg, uint8_t *data);
-
-#ifdef	__cplusplus
-}
-#endif
-
-#endif	/* I2C_H */
-
+/* 
+ * File:   i2c.h
+ * Author: tbriggs, Kevin Dederer
+ * Comments: Header file for the i2c bus. Define I2C_PROFILE in config.h to
+ *           count the traffic of each logical operation, otherwise the
+ *           counting compiles away. tools/i2c_model.py predicts the same
+ *           numbers from the bus clock and compares them with a report.
+ * Revision history: 
+ */
+
+#ifndef I2C_H
+#define	I2C_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define I2C_TIMEOUT_US (100)        // longest wait for a single bus condition
+#define I2C_TRANSACTION_US (1000)   // hard limit for one register read or write
+#define I2C_RECOVERY_US (150)       // 9 clock pulses, stop and re-initialisation
+#define I2C_WORST_CASE_US (I2C_TRANSACTION_US + I2C_RECOVERY_US + 50)  // incl. fixed delays
+
+#if defined(I2C_PROFILE) && defined(LSM330_USE_SPI)
+#error "I2C_PROFILE counts the lsm330 traffic on I2C2, build without LSM330_USE_SPI"
+#endif
+
+/*
+ * i2c_error - error codes returned by the bus functions, always negative
+ * i2c_timeout - a bus wait or the transaction ran over its time limit
+ * i2c_nack - the slave did not acknowledge
+ * i2c_collision - master bus collision when sending
+ * i2c_arbitration - arbitration was lost
+ * i2c_overflow - transmit or receive overflow
+ * i2c_clock - the bus clock could not be configured
+ */
+enum i2c_error
+{
+    i2c_ok = 0,
+    i2c_timeout = -1,
+    i2c_nack = -2,
+    i2c_collision = -3,
+    i2c_arbitration = -4,
+    i2c_overflow = -5,
+    i2c_clock = -6,
+    I2C_ERRORS = 7
+};
+
+/*
+ * i2c_status - error counters of the driver
+ * @param last_error - the most recent error code
+ * @param errors - count of each error code, indexed by -code
+ * @param recoveries - number of times the bus was recovered
+ * @param max_us - the longest transaction seen, in microseconds
+ */
+typedef struct
+{
+    enum i2c_error last_error;
+    unsigned int errors[I2C_ERRORS];
+    unsigned int recoveries;
+    unsigned int max_us;
+} i2c_status;
+
+/*
+ * i2c_op - the logical operations counted by the traffic profiler
+ */
+enum i2c_op
+{
+    op_read_reg, op_write_reg, op_read_multiple,
+    I2C_OPS
+};
+
+/*
+ * i2c_traffic - bus traffic of one logical operation since the last reset
+ * @param calls - operations started
+ * @param failed - operations that returned an error
+ * @param starts - start and repeated start conditions
+ * @param address_bytes - address bytes sent, including ack poll retries
+ * @param data_bytes - register and data bytes sent or received
+ * @param nack_retries - address bytes the slave did not acknowledge
+ * @param ticks - core ticks from the start to the end of the operations
+ * @param max_ticks - the longest operation in core ticks
+ */
+typedef struct
+{
+    unsigned int calls;
+    unsigned int failed;
+    unsigned int starts;
+    unsigned int address_bytes;
+    unsigned int data_bytes;
+    unsigned int nack_retries;
+    uint64_t ticks;
+    unsigned int max_ticks;
+} i2c_traffic;
+
+const i2c_status *i2c_get_status(void);
+#ifdef I2C_PROFILE
+void i2c_profile_reset(void);
+const i2c_traffic *i2c_profile_get(enum i2c_op op);
+void i2c_profile_report(void);
+#endif
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* I2C_H */
+
@@ -0,0 +1,153 @@
+/*
+ * File:   idle.c
+ * Author: Kevin Dederer
+ * Comments: background executor, @see idle.h. After each job step the jobs
+ *           are polled again from the top, so a higher priority job that got
+ *           work goes first. The core waits only after a pass found no work,
+ *           any interrupt wakes it for another pass. The time is looked at
+ *           again right before the wait, if the alarm still goes off between
+ *           that check and the wait the next timer 1 interrupt ends the wait,
+ *           one pwm step late.
+ * Revision history:
+ */
+
+#include "config.h"
+
+/*
+ * idle_job - one entry of the job table
+ * @param name - name in the report
+ * @param step - does one bounded piece of work, nonzero if there was any
+ * @param budget - worst case core ticks of one step
+ */
+typedef struct
+{
+    const char *name;
+    int (*step)(void);
+    unsigned int budget;
+} idle_job;
+
+PRIVATE const idle_job jobs[IDLE_JOBS] =
+{
+    [job_evlog] = { "evlog", evlog_drain, EVLOG_DRAIN_TICKS },
+#ifdef PARAMS_LINK
+    [job_params_link] = { "params_link", params_link_step, PARAMS_LINK_STEP_TICKS },
+#endif
+#ifdef RECORD
+    [job_replay] = { "replay", replay_record_step, REPLAY_STEP_TICKS },
+#endif
+    [job_calib] = { "calib", calib_track_step, CALIB_TRACK_STEP_TICKS },
+    [job_vibe] = { "vibe", vibe_step, VIBE_STEP_TICKS },
+};
+
+PRIVATE idle_stats stats;
+
+/*
+ * __ISR() IdleWakeHandler() - the core timer reached LOOP_TICKS, only there
+ *                      to end the wait
+ */
+HAL_CORE_ISR(IdleWakeHandler)
+{
+    hal_core_alarm_clear();
+}
+
+/*
+ * IDLE OPEN - arms the core timer alarm at the end of the control tick
+ */
+void idle_open(void)
+{
+    hal_core_alarm(LOOP_TICKS);
+}
+
+/*
+ * IDLE STEP - runs the first job with work whose budget fits before the end
+ *              of the tick
+ * @return 1 if a job did work, 0 otherwise.
+ */
+PRIVATE int idle_step(void)
+{
+    unsigned int start, ticks;
+    int i, busy;
+
+    for(i = 0; i < IDLE_JOBS; i++)
+    {
+        start = hal_core_ticks();
+        if(start >= LOOP_TICKS - jobs[i].budget) continue;
+        busy = jobs[i].step();
+        ticks = hal_core_ticks() - start;
+        stats.background += ticks;
+        stats.job[i].steps++;
+        if(ticks > stats.job[i].max_ticks) stats.job[i].max_ticks = ticks;
+        if(ticks > jobs[i].budget)
+        {
+            stats.job[i].overruns++;
+            evlog_write(ev_idle_overrun, i);
+        }
+        if(busy) return 1;
+    }
+    return 0;
+}
+
+/*
+ * IDLE RUN - fills the rest of the control tick with background jobs and
+ *              waits when there are none, returns at LOOP_TICKS
+ * @param control - core ticks the control work took
+ * @param skip_jobs - nonzero to only wait, while the loop is overloaded
+ */
+void idle_run(unsigned int control, int skip_jobs)
+{
+    unsigned int now;
+
+    while((now = hal_core_ticks()) < LOOP_TICKS)
+    {
+        if(!skip_jobs && idle_step()) continue;
+        now = hal_core_ticks();
+        if(now >= LOOP_TICKS) break;    // the alarm went off during the pass
+        hal_idle();
+        stats.idle += hal_core_ticks() - now;
+    }
+    stats.ticks++;
+    stats.control += control;
+    stats.total += now;
+}
+
+/*
+ * IDLE DELAY MS - waits for interrupts, for the start up delays before the
+ *              loop runs. Needs the timer 1 interrupt running.
+ * @param ms - milliseconds to wait
+ */
+void idle_delay_ms(unsigned int ms)
+{
+    uint32_t start = timing_now();
+
+    while(timing_now() - start < ms * 1000 * CORE_TICKS_PER_US)
+        hal_idle();
+}
+
+/*
+ * IDLE GET STATUS - read only access to the executor counters
+ * @return the counters.
+ */
+const idle_stats *idle_get_status(void)
+{
+    return &stats;
+}
+
+/*
+ * IDLE REPORT - prints the cpu use as one JSON line, utilisation is control
+ *              and background work, the rest of idle is loop overhead
+ */
+void idle_report(void)
+{
+    float total = stats.total ? stats.total : 1;
+    int i;
+
+    printf("{\"cpu\":{\"ticks\":%u,\"utilisation_pct\":%.1f,\"control_pct\":%.1f,"
+           "\"background_pct\":%.1f,\"idle_pct\":%.1f,\"jobs\":[",
+           stats.ticks, 100 * (stats.control + stats.background) / total,
+           100 * stats.control / total, 100 * stats.background / total, 100 * stats.idle / total);
+    for(i = 0; i < IDLE_JOBS; i++)
+        printf("%s{\"name\":\"%s\",\"steps\":%u,\"budget\":%u,\"max_ticks\":%u,\"overruns\":%u}",
+               i ? "," : "", jobs[i].name, stats.job[i].steps, jobs[i].budget,
+               stats.job[i].max_ticks, stats.job[i].overruns);
+    printf("]}}\n");
+}
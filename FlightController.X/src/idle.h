@@ -0,0 +1,80 @@
+/*
+ * File:   idle.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the background executor. The jobs are split into
+ *           steps that finish within a declared budget of core ticks, a step
+ *           is only started if its budget still fits before the end of the
+ *           control tick. When no job has work the core waits for the next
+ *           interrupt instead of spinning on the core timer, the core timer
+ *           alarm at LOOP_TICKS makes sure it wakes for the next tick.
+ * Revision history:
+ */
+
+#ifndef IDLE_H
+#define	IDLE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * idle_job_id - the background jobs, in priority order
+ */
+enum idle_job_id
+{
+    job_evlog,          // format the event log
+#ifdef PARAMS_LINK
+    job_params_link,    // answer the parameter link
+#endif
+#ifdef RECORD
+    job_replay,         // send the control input log
+#endif
+    job_calib,          // in flight zero offset tracking
+    job_vibe,           // vibration spectrum analysis
+    IDLE_JOBS
+};
+
+/*
+ * idle_job_stats - counters of one job
+ * @param steps - steps run, including those that found nothing to do
+ * @param max_ticks - the longest step in core ticks
+ * @param overruns - steps that took longer than the budget
+ */
+typedef struct
+{
+    unsigned int steps;
+    unsigned int max_ticks;
+    unsigned int overruns;
+} idle_job_stats;
+
+/*
+ * idle_stats - where the core ticks went since boot
+ * @param ticks - control ticks measured
+ * @param total - core ticks of all measured control ticks
+ * @param control - core ticks of control work before the slack
+ * @param background - core ticks spent in job steps
+ * @param idle - core ticks spent waiting for an interrupt
+ * @param job - per job counters
+ */
+typedef struct
+{
+    unsigned int ticks;
+    uint64_t total;
+    uint64_t control;
+    uint64_t background;
+    uint64_t idle;
+    idle_job_stats job[IDLE_JOBS];
+} idle_stats;
+
+void idle_open(void);
+void idle_run(unsigned int control, int skip_jobs);
+void idle_delay_ms(unsigned int ms);
+const idle_stats *idle_get_status(void);
+void idle_report(void);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* IDLE_H */
+
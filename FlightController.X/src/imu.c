@@ -0,0 +1,276 @@
+/*
+ * File:   imu.c
+ * Author: Kevin Dederer
+ * Comments: imu manager. Each lsm330 has its own device handle, zero offsets
+ *           and health. Every tick all of them are read back to back, moved
+ *           into the frame of the first one and voted into one block sample
+ *           by sample: the median with three, the weighted mean with two.
+ *           The blocks are lined up at their newest sample. An imu that keeps
+ *           failing its reads or keeps disagreeing with the other two is
+ *           dropped from the vote until it agrees again, the last one in the
+ *           vote stays in it.
+ * Revision history:
+ */
+
+#include "config.h"
+
+/*
+ * imu_wiring - where each lsm330 sits and how much its vote counts. The second
+ *              one has its SA0 pins pulled low, the third shares the addresses
+ *              of the first and is only reachable over spi. The chip selects
+ *              are set in imu.h.
+ */
+PRIVATE const struct
+{
+    lsm330_bus accel;
+    lsm330_bus gyro;
+    int weight;
+} imu_wiring[3] = {
+    {{LSM330_DEV_ACCEL, IMU1_CS_ACCEL}, {LSM330_DEV_GYRO, IMU1_CS_GYRO}, 1},
+    {{LSM330_DEV_ACCEL_ALT, IMU2_CS_ACCEL}, {LSM330_DEV_GYRO_ALT, IMU2_CS_GYRO}, 1},
+    {{LSM330_DEV_ACCEL, IMU3_CS_ACCEL}, {LSM330_DEV_GYRO, IMU3_CS_GYRO}, 1},
+};
+
+/*
+ * imu_unit - one lsm330
+ * @param dev - the driver handle
+ * @param sample - the boot zero offsets
+ * @param align - offsets into the frame of the reference imu, in counts with
+ *              LSM330_ZERO_SHIFT fraction bits
+ * @param block - the aligned readings of this tick
+ * @param open - the sensor was configured
+ * @param valid - the read of this tick succeeded
+ * @param voting - the sample is used in the vote
+ * @param run - ticks in a row faulty while voting, or good while dropped
+ */
+typedef struct
+{
+    lsm330_dev dev;
+    sensor_data sample;
+    int32_t align[3];
+    sensor_block block;
+    int open;
+    int valid;
+    int voting;
+    int run;
+} imu_unit;
+
+/*
+ * imu_data - manager state
+ * @param unit - the sensors
+ * @param fault_counts - IMU_FAULT_G in counts
+ * @param status - counters
+ */
+typedef struct
+{
+    imu_unit unit[IMU_COUNT];
+    int fault_counts;
+    imu_status status;
+} imu_data;
+
+PRIVATE imu_data imu;
+
+/*
+ * IMU OPEN - configures and calibrates every sensor and sets the zero offsets
+ *              and scale of the voted reading to those of the first one
+ * @param *lsm330 - the struct the voted readings will be written to
+ * @return 0 if at least one sensor is working, -1 otherwise.
+ */
+int imu_open(sensor_data *lsm330)
+{
+    imu_unit *u, *ref = NULL;
+    int i;
+
+    for(i = 0; i < IMU_COUNT; i++)
+    {
+        u = &imu.unit[i];
+        u->dev.accel = imu_wiring[i].accel;
+        u->dev.gyro = imu_wiring[i].gyro;
+        if(configure_lsm330tr(&u->dev, &u->sample) < 0) continue;
+        // the vote works on counts, all sensors need the same full scale
+        if(ref != NULL && u->dev.accel_sensitivity != ref->dev.accel_sensitivity) continue;
+        if(ref == NULL) ref = u;
+        u->open = u->voting = 1;
+        imu.status.voting |= 1 << i;
+    }
+    if(ref == NULL) return -1;
+
+    for(i = 0; i < IMU_COUNT; i++)
+    {
+        u = &imu.unit[i];
+        u->align[0] = u->sample.zero_x - ref->sample.zero_x;
+        u->align[1] = u->sample.zero_y - ref->sample.zero_y;
+        u->align[2] = u->sample.zero_z - ref->sample.zero_z;
+    }
+    lsm330->zero_x = ref->sample.zero_x;
+    lsm330->zero_y = ref->sample.zero_y;
+    lsm330->zero_z = ref->sample.zero_z;
+    lsm330->sensitivity = ref->dev.accel_sensitivity;
+    imu.fault_counts = IMU_FAULT_G / lsm330->sensitivity;
+    return 0;
+}
+
+/*
+ * MEDIAN3 - the middle one of three values
+ */
+PRIVATE int16_t median3(int16_t a, int16_t b, int16_t c)
+{
+    int16_t lo = (a < b) ? a : b;
+    int16_t hi = (a < b) ? b : a;
+
+    return (c < lo) ? lo : (c > hi) ? hi : c;
+}
+
+/*
+ * IMU SAMPLE - one aligned sample of a sensor, counted back from the newest
+ * @param u - the sensor
+ * @param a - the axis, 0 to 2 for x y z
+ * @param age - 0 for the newest sample of the block
+ */
+#define IMU_SAMPLE(u, a, age) ((u)->block.axis[a][(u)->block.count - 1 - (age)])
+
+/*
+ * IMU VOTE - combines the aligned blocks of the voting sensors. The blocks may
+ *              differ by a sample when the sensor clocks drift, the vote is
+ *              as long as the shortest one.
+ * @param *vote - the combined block
+ * @return the number of sensors in the vote.
+ */
+PRIVATE int imu_vote(sensor_block *vote)
+{
+    imu_unit *v[3];
+    int32_t w0 = 1, w1 = 1;
+    int i, axis, age, n = 0;
+
+    vote->count = PIPE_BLOCK;
+    for(i = 0; i < IMU_COUNT; i++)
+    {
+        if(!imu.unit[i].voting || !imu.unit[i].valid) continue;
+        v[n++] = &imu.unit[i];
+        if(imu.unit[i].block.count < vote->count) vote->count = imu.unit[i].block.count;
+    }
+    if(n == 2)
+    {
+        w0 = imu_wiring[v[0] - imu.unit].weight;
+        w1 = imu_wiring[v[1] - imu.unit].weight;
+    }
+
+    for(axis = 0; axis < 3 && n > 0; axis++)
+    {
+        for(age = 0; age < vote->count; age++)
+        {
+            int16_t *out = &vote->axis[axis][vote->count - 1 - age];
+
+            if(n == 1)
+                *out = IMU_SAMPLE(v[0], axis, age);
+            else if(n == 2)
+                *out = (w0 * IMU_SAMPLE(v[0], axis, age) + w1 * IMU_SAMPLE(v[1], axis, age)) / (w0 + w1);
+            else
+                *out = median3(IMU_SAMPLE(v[0], axis, age), IMU_SAMPLE(v[1], axis, age),
+                               IMU_SAMPLE(v[2], axis, age));
+        }
+        // counted once per tick, on the newest sample
+        if(n == 2 && abs(IMU_SAMPLE(v[0], axis, 0) - IMU_SAMPLE(v[1], axis, 0)) > imu.fault_counts)
+            imu.status.disagree++;
+    }
+    return n;
+}
+
+/*
+ * IMU CHECK - updates the health of every sensor against the vote. A voting
+ *              sensor is faulty on a tick its read failed or, with three in
+ *              the vote, its reading was more than IMU_FAULT_G away from the
+ *              median. The last voting sensor is never dropped, without it
+ *              nothing would be left to vote. A dropped sensor votes again
+ *              once it has read close to the vote for IMU_RECOVER_TICKS, or
+ *              has just read at all while there is no vote to compare with.
+ *              Only the newest sample of each block is compared.
+ * @param *vote - the combined block
+ * @param n - the number of sensors in the vote, 0 if there is no reading
+ */
+PRIVATE void imu_check(const sensor_block *vote, int n)
+{
+    imu_unit *u;
+    int i, axis, far;
+
+    for(i = 0; i < IMU_COUNT; i++)
+    {
+        u = &imu.unit[i];
+        if(!u->open) continue;
+
+        far = !u->valid;
+        for(axis = 0; axis < 3 && !far && n > 0; axis++)
+            far = abs(IMU_SAMPLE(u, axis, 0) - vote->axis[axis][vote->count - 1]) > imu.fault_counts;
+
+        if(u->voting)
+        {
+            u->run = (!u->valid || (far && n >= 3)) ? u->run + 1 : 0;
+            if(u->run < IMU_FAULT_TICKS) continue;
+            if(imu.status.voting == 1u << i)
+            {
+                u->run = IMU_FAULT_TICKS;   // the last voter, dropped once another one is back
+                continue;
+            }
+            u->voting = 0;
+            imu.status.faults[i]++;
+        }
+        else
+        {
+            u->run = far ? 0 : u->run + 1;
+            if(u->run < IMU_RECOVER_TICKS) continue;
+            u->voting = 1;
+        }
+        u->run = 0;
+        imu.status.voting ^= 1 << i;
+    }
+}
+
+/*
+ * IMU READ - reads every sensor back to back and writes the voted block.
+ *              The cost is one status poll and one burst per sensor.
+ * @param *block - receives the raw counts, oldest first.
+ * @return 0 if a block was produced, -1 if no sensor could vote this tick.
+ */
+int imu_read(sensor_block *block)
+{
+    PROFILE_START(prof_imu);
+    imu_unit *u;
+    int i, j, axis, n;
+
+    for(i = 0; i < IMU_COUNT; i++)
+    {
+        u = &imu.unit[i];
+        u->valid = u->open && read_accel_block(&u->dev, &u->block) == 0;
+        if(!u->valid)
+        {
+            if(u->open) imu.status.read_errors[i]++;
+            continue;
+        }
+        for(axis = 0; axis < 3; axis++)
+            for(j = 0; j < u->block.count; j++)
+                u->block.axis[axis][j] = lsm330_add_zero(u->block.axis[axis][j], u->align[axis]);
+    }
+
+    n = imu_vote(block);
+    imu_check(block, n);
+    PROFILE_STOP(prof_imu);
+
+    if(n == 0)
+    {
+        imu.status.no_sample++;
+        return -1;
+    }
+    for(i = 0; !imu.unit[i].valid; i++);
+    block->time = imu.unit[i].block.time;    // the first imu read, they are read back to back
+    imu.status.reads++;
+    return 0;
+}
+
+/*
+ * IMU GET STATUS - read only access to the manager counters
+ * @return pointer to the manager status.
+ */
+const imu_status *imu_get_status(void)
+{
+    return &imu.status;
+}
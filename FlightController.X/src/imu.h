@@ -0,0 +1,80 @@
+/*
+ * File:   imu.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the imu manager. It owns one lsm330_dev per
+ *           sensor on the board, reads them back to back every tick and votes
+ *           their samples into the one block the pipeline sees.
+ * Revision history:
+ */
+
+#ifndef IMU_H
+#define	IMU_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#ifndef IMU_COUNT
+#define IMU_COUNT (1)               // lsm330s on the board, 1 to 3, may be set on the command line
+#endif
+#define IMU_FAULT_G (0.25)          // distance from the vote that makes a sample faulty, g
+#define IMU_FAULT_TICKS (LOOP_RATE_HZ / 10)     // faulty ticks in a row before an imu is dropped
+#define IMU_RECOVER_TICKS (LOOP_RATE_HZ)        // good ticks in a row before it votes again
+
+#if IMU_COUNT < 1 || IMU_COUNT > 3
+#error "IMU_COUNT must be 1, 2 or 3"
+#endif
+#if !defined(LSM330_USE_SPI) && IMU_COUNT > 2
+#error "only two lsm330 addresses exist on I2C, define LSM330_USE_SPI"
+#endif
+
+// port G chip selects of the accelerometer and gyro of each lsm330, only used
+// with LSM330_USE_SPI. The board has pins for the first one, the others have
+// to be set to their wiring, on the command line, before spi builds with them.
+#define IMU1_CS_ACCEL (BIT_9)
+#define IMU1_CS_GYRO (BIT_12)
+#if defined(LSM330_USE_SPI) && IMU_COUNT >= 2 && (!defined(IMU2_CS_ACCEL) || !defined(IMU2_CS_GYRO))
+#error "the second lsm330 has no chip selects, define IMU2_CS_ACCEL and IMU2_CS_GYRO"
+#endif
+#if defined(LSM330_USE_SPI) && IMU_COUNT >= 3 && (!defined(IMU3_CS_ACCEL) || !defined(IMU3_CS_GYRO))
+#error "the third lsm330 has no chip selects, define IMU3_CS_ACCEL and IMU3_CS_GYRO"
+#endif
+#ifndef IMU2_CS_ACCEL
+#define IMU2_CS_ACCEL (0)
+#define IMU2_CS_GYRO (0)
+#endif
+#ifndef IMU3_CS_ACCEL
+#define IMU3_CS_ACCEL (0)
+#define IMU3_CS_GYRO (0)
+#endif
+
+/*
+ * imu_status - counters of the manager
+ * @param reads - ticks imu_read produced a sample
+ * @param no_sample - ticks no imu was left to vote
+ * @param disagree - ticks two imus were further apart than IMU_FAULT_G with
+ *              no third one to tell which is wrong
+ * @param read_errors - failed reads of each imu
+ * @param faults - times each imu was dropped from the vote
+ * @param voting - bit mask of the imus currently in the vote
+ */
+typedef struct
+{
+    unsigned int reads;
+    unsigned int no_sample;
+    unsigned int disagree;
+    unsigned int read_errors[IMU_COUNT];
+    unsigned int faults[IMU_COUNT];
+    unsigned int voting;
+} imu_status;
+
+int imu_open(sensor_data *lsm330);
+int imu_read(sensor_block *block);
+const imu_status *imu_get_status(void);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* IMU_H */
+
@@ -1,42 +1,126 @@
-/* 
- * File:   lsm330tr.h
- * Author: Kevin Dederer
- * Comments: Header file for the lsm330tr sensor, callable function definitions
- * Revision history: 
- */
- 
-#ifndef LSM330TR_H
-#define	LSM330TR_H
-
-#ifdef	__cplusplus
-extern "C" {
-#endif /* __cplusplus */
-
-/*
- * sensor_data - struct containing the variables for the sensor output
- * @param accel_x - the acceleration in the x direction read from the sensor.
- * @param accel_y - the acceleration in the y direction read from the sensor.
- * @param accel_z - the acceleration in the z direction read from the sensor.
- * @param pitch - the pitch read from the sensor.
- * @param roll - the roll read from the sensor.
- * @param yaw - the yaw read from the sensor.
- */
-typedef struct
-{
-    float accel_x;
-    float accel_x_zero;
-    float accel_y;
-    float accel_y_zero;
-    float accel_z;
-    float accel_z_zero;
-} sensor_data;
-    
-int read_accel(sensor_data *lsm330);
-int configure_lsm330tr(sensor_data *lsm330);
-     
-#ifdef	__cplusplus
-}
-#endif /* __cplusplus */
-
-#endif	/* XC_HEADER_TEMPLATE_H */
-
+/* 
+ * File:   lsm330tr.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the lsm330tr sensor, callable function definitions
+ * Revision history: 
+ */
+ 
+#ifndef LSM330TR_H
+#define	LSM330TR_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define LSM330_ZERO_SHIFT (8)     // fraction bits of the zero offsets
+#define LSM330_FIFO_DEPTH (32)    // samples the accelerometer fifo holds
+
+// a read waits for a new sample by polling the status, no poll starts after
+// LSM330_POLL_US. At worst the last poll then takes a whole transaction and
+// the burst fails after its own, that is what one read costs the tick. An
+// overrun fifo is emptied with a write before and after the burst.
+#define LSM330_POLL_US (200)
+#define LSM330_BOOT_POLL_US (2000000 / PIPE_SAMPLE_HZ)     // two sample periods, while calibrating
+#if PIPE_DECIMATE == 1
+#define LSM330_READ_WORST_US (LSM330_POLL_US + I2C_TRANSACTION_US + I2C_WORST_CASE_US)
+#else
+#define LSM330_READ_WORST_US (LSM330_POLL_US + 3 * I2C_TRANSACTION_US + I2C_WORST_CASE_US)
+#endif
+
+/*
+ * sensor_data - struct containing the variables for the sensor output. The
+ *              acquisition and filters work on counts, the accelerations are
+ *              converted to g only for the controller.
+ * @param raw_x, raw_y, raw_z - the accelerations read from the sensor, in counts.
+ * @param zero_x, zero_y, zero_z - the zero offsets added to the counts, in
+ *              counts with LSM330_ZERO_SHIFT fraction bits.
+ * @param out_x, out_y, out_z - the filtered accelerations, in counts.
+ * @param sensitivity - g per count of the counts above.
+ * @param time - timing_now() when the sample was acquired.
+ * @param accel_x, accel_y, accel_z - the filtered accelerations, in g.
+ */
+typedef struct
+{
+    int16_t raw_x;
+    int16_t raw_y;
+    int16_t raw_z;
+    int32_t zero_x;
+    int32_t zero_y;
+    int32_t zero_z;
+    int16_t out_x;
+    int16_t out_y;
+    int16_t out_z;
+    float sensitivity;
+    uint32_t time;
+    float accel_x;
+    float accel_y;
+    float accel_z;
+} sensor_data;
+
+/*
+ * sensor_block - the accelerometer samples that arrived during one control
+ *              tick, oldest first. Each axis is a separate array so the
+ *              pipeline stages run a tight loop per axis, @see pipe.h
+ * @param axis - x, y and z samples in counts, processed in place
+ * @param count - samples in the block, 1 to PIPE_BLOCK
+ * @param time - timing_now() when the block was read.
+ */
+typedef struct
+{
+    int16_t axis[3][PIPE_BLOCK];
+    int count;
+    uint32_t time;
+} sensor_block;
+    
+// Device Addresses, the _ALT ones with the SA0 pins pulled low
+#define LSM330_DEV_ACCEL (0b0011110)
+#define LSM330_DEV_GYRO  (0b1101010)
+#define LSM330_DEV_ACCEL_ALT (0b0011101)
+#define LSM330_DEV_GYRO_ALT  (0b1101011)
+
+/*
+ * lsm330_bus - where one of the two devices in the package sits on the transport
+ * @param addr - the 7 bit i2c address
+ * @param cs - the chip select bit on port G, only used with LSM330_USE_SPI
+ */
+typedef struct
+{
+    uint8_t addr;
+    unsigned int cs;
+} lsm330_bus;
+
+/*
+ * lsm330_dev - one lsm330, the driver keeps all its state here
+ * @param accel, gyro - the accelerometer and gyro on the transport
+ * @param accel_scale - the accelerometer full scale in g
+ * @param accel_sensitivity - g per accelerometer count
+ * @param gyro_sensitivity - dps per gyro count
+ */
+typedef struct
+{
+    lsm330_bus accel;
+    lsm330_bus gyro;
+    uint8_t accel_scale;
+    float accel_sensitivity;
+    float gyro_sensitivity;
+} lsm330_dev;
+
+// register access, implemented by the transport selected at build time,
+// i2c.c by default or spi.c with LSM330_USE_SPI
+int lsm330_read_reg(const lsm330_bus *bus, uint8_t reg, uint8_t *data);
+int lsm330_write_reg(const lsm330_bus *bus, uint8_t reg, uint8_t data);
+int lsm330_read_multiple_reg(const lsm330_bus *bus, uint8_t reg, uint8_t *data, int len);
+
+void set_accel_sensitivity(lsm330_dev *dev, uint8_t sensitivity);
+HOT_PATH int16_t lsm330_add_zero(int32_t counts, int32_t zero);
+HOT_PATH void convert_accel(const uint8_t buff[6], sensor_data *lsm330);
+int read_accel(const lsm330_dev *dev, sensor_data *lsm330);
+int read_accel_block(const lsm330_dev *dev, sensor_block *block);
+int configure_lsm330tr(lsm330_dev *dev, sensor_data *lsm330);
+     
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* XC_HEADER_TEMPLATE_H */
+
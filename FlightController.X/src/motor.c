@@ -0,0 +1,252 @@
+/*
+ * File:   motor.c
+ * Author: Kevin Dederer
+ * Comments: tear free motor command handoff. The control loop writes a full
+ *           command set into the slot the pwm interrupt is not using and then
+ *           flips the front index, the interrupt copies the front slot once at
+ *           the start of each pwm period. Each slot carries a sequence number
+ *           that is odd while it is written, so a torn copy is detected and
+ *           the previous command is kept instead of blocking or disabling
+ *           interrupts. Every new command is timed from publish to its first
+ *           pulse, the report compares the aligned period with the free
+ *           running one of MOTOR_PWM_FREE_RUN.
+ * Revision history:
+ */
+
+#include "config.h"
+
+/*
+ * motor_slot - one buffer of the double buffered command
+ * @param seq - odd while the slot is being written
+ * @param command - the motor commands
+ */
+typedef struct
+{
+    volatile uint32_t seq;
+    volatile motor_command command;
+} motor_slot;
+
+/*
+ * motor_data - the two slots and the handoff state
+ * @param slot - the double buffer
+ * @param front - index of the newest complete slot, written by the control loop
+ * @param stale - latches that kept the previous command because of a torn copy
+ * @param started - the control tick the last aligned period started in
+ * @param latched - stamp of the last latched command, a new stamp is a new command
+ * @param reset - clear the delay statistics on the next latch
+ * @param delay - the command delay statistics, written by the pwm interrupt
+ */
+typedef struct
+{
+    motor_slot slot[2];
+    volatile uint32_t front;
+    volatile unsigned int stale;
+    uint32_t started;
+    uint32_t latched;
+    volatile int reset;
+    motor_delay delay;
+} motor_data;
+
+PRIVATE motor_data motor;
+
+/*
+ * MOTOR PUBLISH - hands a complete set of engine speeds to the pwm interrupt,
+ *              called by the control loop only
+ * @param *engine - the engine data holding the new speeds
+ */
+void motor_publish(const engine_data *engine)
+{
+    motor_slot *s = &motor.slot[motor.front ^ 1];
+
+    s->seq++;
+    __sync_synchronize();
+    s->command.speed[0] = engine->e1.speed;
+    s->command.speed[1] = engine->e2.speed;
+    s->command.speed[2] = engine->e3.speed;
+    s->command.speed[3] = engine->e4.speed;
+    s->command.stamp = timing_now();
+    __sync_synchronize();
+    s->seq++;
+    __sync_synchronize();
+    motor.front ^= 1;
+}
+
+/*
+ * MOTOR DELAY ADD - records the delay of a command reaching its first pulse
+ * @param stamp - when the command was published
+ */
+HOT_PATH PRIVATE void motor_delay_add(uint32_t stamp)
+{
+    motor_delay *d = &motor.delay;
+    uint32_t ticks = timing_now() - stamp;
+    uint32_t us = ticks / CORE_TICKS_PER_US;
+    uint32_t bin = us / 1000;
+
+    if(ticks > hal_core_ticks()) d->late++;
+    if(d->count == 0 || us < d->min_us) d->min_us = us;
+    if(us > d->max_us) d->max_us = us;
+    d->count++;
+    d->sum_us += us;
+    d->sum_sq += (uint64_t) us * us;
+    d->hist[bin < MOTOR_DELAY_BINS ? bin : MOTOR_DELAY_BINS - 1]++;
+}
+
+/*
+ * MOTOR LATCH - copies the newest complete command set, called from the pwm
+ *              interrupt at the start of a period. The writer never touches
+ *              the front slot, so on this core the first copy always succeeds,
+ *              the retry covers a writer that published twice during the copy.
+ *              A reader that can be preempted may find the back slot complete
+ *              before front flips to it, front must not change during the copy
+ *              either or a later latch could go back to the older slot.
+ * @param *command - the command used for the period, left unchanged on failure
+ * @return 0 on success, -1 if the previous command was kept.
+ */
+HOT_PATH int motor_latch(motor_command *command)
+{
+    motor_slot *s;
+    motor_command copy;
+    uint32_t seq, front;
+    int attempt, i;
+
+    if(motor.reset)
+    {
+        motor.delay = (motor_delay) { 0 };
+        motor.reset = 0;
+    }
+    for(attempt = 0; attempt < 2; attempt++)
+    {
+        front = motor.front;
+        s = &motor.slot[front];
+        seq = s->seq;
+        if(seq & 1) continue;
+        __sync_synchronize();
+        for(i = 0; i < MOTORS; i++)
+            copy.speed[i] = s->command.speed[i];
+        copy.stamp = s->command.stamp;
+        __sync_synchronize();
+        if(s->seq == seq && motor.front == front)
+        {
+            *command = copy;
+            motor.delay.periods++;
+            if(copy.stamp != motor.latched) motor_delay_add(copy.stamp);
+            motor.latched = copy.stamp;
+            return 0;
+        }
+    }
+    motor.delay.periods++;
+    motor.stale++;
+    return -1;
+}
+
+/*
+ * MOTOR PERIOD START - decides in the pwm interrupt whether a new period
+ *              starts. An aligned period starts MOTOR_PWM_PHASE_US into every
+ *              MOTOR_PWM_TICKS-th control tick, once the pulses of the last
+ *              one are off and at least half a period has gone. Without
+ *              control ticks, before the loop runs or while a tick overruns,
+ *              the period starts on its own MOTOR_PWM_SLIP_COUNTS late and
+ *              lines up again at the next aligned start.
+ * @param counter - timer 2 counts since the period started
+ * @param pulsing - a pulse of the current period is still on
+ * @return nonzero if the period starts now.
+ */
+HOT_PATH int motor_period_start(int counter, int pulsing)
+{
+#ifdef MOTOR_PWM_FREE_RUN
+    (void) pulsing;
+    return counter >= MOTOR_PWM_COUNTS;
+#else
+    uint32_t tick;
+
+    if(counter >= MOTOR_PWM_COUNTS + MOTOR_PWM_SLIP_COUNTS) return 1;
+    if(pulsing || counter < MOTOR_PWM_COUNTS / 2) return 0;
+    tick = timing_ticks();
+    if(tick == motor.started || tick % MOTOR_PWM_TICKS != 0) return 0;
+    if(hal_core_ticks() < MOTOR_PWM_PHASE_TICKS) return 0;
+    motor.started = tick;
+    return 1;
+#endif
+}
+
+/*
+ * MOTOR LATCH WAIT S - the expected time until a command published now is
+ *              latched, for the latency estimate. The next aligned start is
+ *              in the next tick that is a multiple of MOTOR_PWM_TICKS, or
+ *              in this one if it is one and its start has not gone yet.
+ * @return the wait in seconds.
+ */
+HOT_PATH float motor_latch_wait_s(void)
+{
+#ifdef MOTOR_PWM_FREE_RUN
+    return MOTOR_PWM_PERIOD_S / 2;      // the period runs past the tick, half a period on average
+#else
+    uint32_t tick = timing_ticks();
+    uint32_t ahead = (MOTOR_PWM_TICKS - tick % MOTOR_PWM_TICKS) % MOTOR_PWM_TICKS;
+    int32_t wait = (int32_t) (ahead * LOOP_TICKS + MOTOR_PWM_PHASE_TICKS) - (int32_t) hal_core_ticks();
+
+    if(wait < 0)
+    {
+        if(tick != motor.started) return 0;             // past the phase, the next interrupt starts it
+        wait += MOTOR_PWM_TICKS * LOOP_TICKS;           // gone, the next aligned start
+    }
+    return wait / (CORE_TICKS_PER_US * 1e6f);
+#endif
+}
+
+/*
+ * MOTOR STALE - the number of pwm periods that kept the previous command
+ * @return the stale latch count.
+ */
+unsigned int motor_stale(void)
+{
+    return motor.stale;
+}
+
+/*
+ * MOTOR GET DELAY - read only access to the command delay statistics
+ * @return the statistics.
+ */
+const motor_delay *motor_get_delay(void)
+{
+    return &motor.delay;
+}
+
+/*
+ * MOTOR DELAY RESET - starts the delay statistics over at the next latch, so
+ *              the start up commands are left out
+ */
+void motor_delay_reset(void)
+{
+    motor.reset = 1;
+}
+
+/*
+ * MOTOR REPORT - prints the pwm period and the command delay distribution as
+ *              one JSON line
+ */
+void motor_report(void)
+{
+    const motor_delay *d = &motor.delay;
+    float mean = 0, jitter = 0;
+    int i;
+
+    if(d->count)
+        mean = (float) d->sum_us / d->count;
+    if(d->count > 1)
+        jitter = sqrt(((double) d->sum_sq - (double) d->sum_us * d->sum_us / d->count) / (d->count - 1));
+    printf("{\"pwm\":{\"period_us\":%.0f,\"free_run\":%s,\"phase_us\":%d,\"periods\":%u,"
+           "\"stale\":%u,\"delay\":{\"count\":%u,\"late\":%u,\"min_us\":%u,\"mean_us\":%.1f,"
+           "\"jitter_us\":%.1f,\"max_us\":%u,\"hist_ms\":[",
+           MOTOR_PWM_PERIOD_S * 1e6,
+#ifdef MOTOR_PWM_FREE_RUN
+           "true",
+#else
+           "false",
+#endif
+           MOTOR_PWM_PHASE_US, d->periods, motor.stale, d->count, d->late,
+           (unsigned int) d->min_us, mean, jitter, (unsigned int) d->max_us);
+    for(i = 0; i < MOTOR_DELAY_BINS; i++)
+        printf("%s%u", i ? "," : "", d->hist[i]);
+    printf("]}}}\n");
+}
@@ -0,0 +1,91 @@
+/*
+ * File:   motor.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the motor command handoff between the control
+ *           loop and the pwm interrupt. The pwm period is a whole number of
+ *           control ticks and starts MOTOR_PWM_PHASE_US into a tick, both are
+ *           timed by the core timer, so the command of that tick is latched
+ *           a fixed time after it was published instead of anywhere up to a
+ *           period later.
+ * Revision history:
+ */
+
+#ifndef MOTOR_H
+#define	MOTOR_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define MOTORS (4)
+#define MOTOR_ZERO (2450)          // compare value of zero throttle, the low end the escs are calibrated to
+#define MOTOR_PWM_HZ (50)           // pwm frequency, a whole number of control ticks per period
+#define MOTOR_PWM_TICKS (LOOP_RATE_HZ / MOTOR_PWM_HZ)   // control ticks per pwm period
+#ifndef MOTOR_PWM_PHASE_US
+#define MOTOR_PWM_PHASE_US (250000 / LOOP_RATE_HZ)  // period start after the start of its tick, past the control work
+#endif
+#define MOTOR_PWM_PHASE_TICKS (MOTOR_PWM_PHASE_US * CORE_TICKS_PER_US)
+#ifdef MOTOR_PWM_FREE_RUN
+#define MOTOR_PWM_COUNTS (5000)     // pwm period in timer 2 counts, 32 pb clocks each, 16ms
+#else
+#define MOTOR_PWM_COUNTS (SYS_FREQ / PB_DIV / 32 / MOTOR_PWM_HZ)   // pwm period in timer 2 counts, 32 pb clocks each
+#endif
+#define MOTOR_PWM_SLIP_COUNTS (MOTOR_PWM_COUNTS / 8)    // how late a period starts on its own without a tick
+#define MOTOR_PWM_PERIOD_S (MOTOR_PWM_COUNTS * 32.0 * PB_DIV / SYS_FREQ)
+#define MOTOR_DELAY_BINS (24)       // 1ms bins of the command delay histogram, the last one open ended
+
+#if LOOP_RATE_HZ % MOTOR_PWM_HZ != 0
+#error "MOTOR_PWM_HZ must divide LOOP_RATE_HZ"
+#endif
+#if MOTOR_PWM_PHASE_US >= 1000000 / LOOP_RATE_HZ
+#error "MOTOR_PWM_PHASE_US must be shorter than a control tick"
+#endif
+
+/*
+ * motor_command - one complete set of motor commands
+ * @param speed - the pwm compare value for each engine, e1 to e4
+ * @param stamp - timing_now() when the command was published
+ */
+typedef struct
+{
+    int speed[MOTORS];
+    uint32_t stamp;
+} motor_command;
+
+/*
+ * motor_delay - the time from publishing a command to its first pulse
+ * @param periods - pwm periods started
+ * @param count - commands that reached a pulse
+ * @param late - of those, commands published before the tick of the pulse
+ * @param min_us, max_us - the shortest and longest delay
+ * @param sum_us, sum_sq - sums of the delays and of their squares, for the mean
+ *              and the deviation
+ * @param hist - delays in 1ms bins
+ */
+typedef struct
+{
+    unsigned int periods;
+    unsigned int count;
+    unsigned int late;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint64_t sum_sq;
+    unsigned int hist[MOTOR_DELAY_BINS];
+} motor_delay;
+
+void motor_publish(const engine_data *engine);
+HOT_PATH int motor_latch(motor_command *command);
+HOT_PATH int motor_period_start(int counter, int pulsing);
+HOT_PATH float motor_latch_wait_s(void);
+unsigned int motor_stale(void);
+const motor_delay *motor_get_delay(void);
+void motor_delay_reset(void);
+void motor_report(void);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* MOTOR_H */
+
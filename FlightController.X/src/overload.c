@@ -0,0 +1,80 @@
+/*
+ * File:   overload.c
+ * Author: Kevin Dederer
+ * Comments: control tick overload monitor. The time each tick takes is
+ *           checked against the budget, repeated overruns step the loop down
+ *           through cheaper modes and a run of good ticks steps it back up.
+ *           A cheaper mode can hide the cause, hold does not read the
+ *           sensor, so its ticks are good while a bus stall lasts. Each step
+ *           up that falls straight back doubles the good ticks the next one
+ *           waits for, up to OVERLOAD_RECOVER_MAX.
+ * Revision history:
+ */
+
+#include "config.h"
+
+PRIVATE overload_data overload = { .recover = OVERLOAD_RECOVER };
+
+/*
+ * SET MODE - moves to a new mode and counts the transition
+ * @param mode - the mode to enter
+ */
+PRIVATE void set_mode(enum overload_mode mode)
+{
+    if(mode > overload.mode && overload.probing && overload.recover < OVERLOAD_RECOVER_MAX)
+        overload.recover *= 2;      // the step up failed
+    overload.probing = mode < overload.mode;
+    overload.mode = mode;
+    overload.entered[mode]++;
+    evlog_write(ev_overload_mode, mode);
+    overload.overruns = 0;
+    overload.good = 0;
+}
+
+/*
+ * OVERLOAD UPDATE - called once per tick with the time the tick's work took
+ * @param ticks - core timer ticks from the start of the tick to the end of the work
+ * @return the mode to use for the next tick.
+ */
+enum overload_mode overload_update(unsigned int ticks)
+{
+    if(ticks > overload.max_ticks) overload.max_ticks = ticks;
+
+    if(ticks > OVERLOAD_BUDGET_TICKS)
+    {
+        overload.overrun_total++;
+        overload.good = 0;
+        if(++overload.overruns >= OVERLOAD_STEP_DOWN && overload.mode < mode_hold_attitude)
+            set_mode(overload.mode + 1);
+    }
+    else
+    {
+        overload.overruns = 0;
+        if(++overload.good >= OVERLOAD_RECOVER && overload.probing)
+        {
+            overload.probing = 0;   // the step up held
+            overload.recover = OVERLOAD_RECOVER;
+        }
+        if(overload.good >= overload.recover && overload.mode > mode_normal)
+            set_mode(overload.mode - 1);
+    }
+    return overload.mode;
+}
+
+/*
+ * OVERLOAD MODE - the mode the loop should run in
+ * @return the current mode.
+ */
+enum overload_mode overload_mode(void)
+{
+    return overload.mode;
+}
+
+/*
+ * OVERLOAD STATS - read only access to the counters for telemetry
+ * @return pointer to the overload state.
+ */
+const overload_data *overload_stats(void)
+{
+    return &overload;
+}
@@ -0,0 +1,66 @@
+/*
+ * File:   overload.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the control tick overload monitor
+ * Revision history:
+ */
+
+#ifndef OVERLOAD_H
+#define	OVERLOAD_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define OVERLOAD_BUDGET_TICKS (LOOP_TICKS / 10 * 9)  // core ticks of work allowed per tick, 90%
+#define OVERLOAD_STEP_DOWN (2)          // consecutive overruns before dropping a mode
+#define OVERLOAD_RECOVER (50)           // consecutive good ticks before stepping back up
+#define OVERLOAD_RECOVER_MAX (OVERLOAD_RECOVER * 32)    // the longest wait after failed step ups
+
+/*
+ * overload_mode - the degraded modes, each one cheaper than the one before
+ * mode_normal - full processing
+ * mode_short_filter - the 16 tap filter replaces the 52 tap filter
+ * mode_skip_tasks - background work in the loop slack is skipped as well
+ * mode_hold_attitude - the sensor is not read, the pid runs on the last good attitude
+ */
+enum overload_mode
+{
+    mode_normal, mode_short_filter, mode_skip_tasks, mode_hold_attitude, OVERLOAD_MODES
+};
+
+/*
+ * overload_data - overload monitor state and counters
+ * @param mode - the current mode
+ * @param overruns - consecutive ticks over budget
+ * @param good - consecutive ticks within budget
+ * @param recover - good ticks needed to step up, doubled by each step up that
+ *              fails, so a stall that lasts does not flap out of hold
+ * @param probing - the last transition was a step up that has not yet lasted
+ *              OVERLOAD_RECOVER good ticks
+ * @param overrun_total - all ticks over budget since reset
+ * @param max_ticks - the longest tick seen in core ticks
+ * @param entered - number of transitions into each mode
+ */
+typedef struct
+{
+    enum overload_mode mode;
+    int overruns;
+    int good;
+    int recover;
+    int probing;
+    unsigned int overrun_total;
+    unsigned int max_ticks;
+    unsigned int entered[OVERLOAD_MODES];
+} overload_data;
+
+enum overload_mode overload_update(unsigned int ticks);
+enum overload_mode overload_mode(void);
+const overload_data *overload_stats(void);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* OVERLOAD_H */
+
@@ -0,0 +1,131 @@
+/*
+ * File:   params.c
+ * Author: Kevin Dederer
+ * Comments: tunable parameter registry, @see params.h. Changes are made to
+ *           the shadow set, params_commit() checks the shadow as a whole and
+ *           stages a copy, params_tick() copies the staged set over the live
+ *           one. All three run in the main loop, the interrupts read no
+ *           parameters, so the copy needs no locking.
+ * Revision history:
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "config.h"
+
+#define PARAM_DEFAULT(name, type, def, min, max, flags) .name = def,
+params_set params = { PARAMS(PARAM_DEFAULT) };
+
+#define PARAM_INFO(name, type, def, min, max, flags) { #name, type, flags, min, max, offsetof(params_set, name) },
+PRIVATE const param_info info[] = { PARAMS(PARAM_INFO) };
+#undef PARAM_INFO
+
+#define PARAMS_COUNT ((int) (sizeof(info) / sizeof(info[0])))
+
+/*
+ * params_data - the sets being edited and waiting for a tick
+ * @param shadow - the set changes are made to
+ * @param staged - the last committed shadow
+ * @param pending - staged is waiting to be copied to the live set
+ */
+typedef struct
+{
+    params_set shadow;
+    params_set staged;
+    int pending;
+} params_data;
+
+PRIVATE params_data edit = { .shadow = { PARAMS(PARAM_DEFAULT) } };
+#undef PARAM_DEFAULT
+
+/*
+ * PARAMS COUNT - the number of registered parameters
+ * @return the count, indexes run from 0.
+ */
+int params_count(void)
+{
+    return PARAMS_COUNT;
+}
+
+/*
+ * PARAMS INFO - describes a parameter
+ * @param index - the parameter
+ * @return the description, NULL if index is out of range.
+ */
+const param_info *params_info(int index)
+{
+    if(index < 0 || index >= PARAMS_COUNT) return NULL;
+    return &info[index];
+}
+
+/*
+ * PARAMS GET - the live value of a parameter
+ * @param index - the parameter, must be valid
+ * @return the 4 value bytes, a float or an int32_t by the param_type.
+ */
+uint32_t params_get(int index)
+{
+    uint32_t raw;
+
+    memcpy(&raw, (const uint8_t *) &params + info[index].offset, sizeof(raw));
+    return raw;
+}
+
+/*
+ * PARAMS SET VALUE - changes a parameter in the shadow set
+ * @param index - the parameter
+ * @param raw - the 4 value bytes, a float or an int32_t by the param_type
+ * @return param_ok or a negative param_error.
+ */
+int params_set_value(int index, uint32_t raw)
+{
+    const param_info *p = params_info(index);
+    float value;
+
+    if(p == NULL) return param_unknown;
+    if(p->flags & param_ro) return param_read_only;
+    if(p->type == param_float)
+        memcpy(&value, &raw, sizeof(value));
+    else
+        value = (int32_t) raw;
+    if(!(value >= p->min && value <= p->max)) return param_range;   // also refuses nan
+
+    memcpy((uint8_t *) &edit.shadow + p->offset, &raw, sizeof(raw));
+    return param_ok;
+}
+
+/*
+ * PARAMS COMMIT - stages the shadow set for the next control tick
+ * @return param_ok, or param_inconsistent if the set is refused, the shadow
+ *              then starts over from the live set.
+ */
+int params_commit(void)
+{
+    const params_set *set = &edit.shadow;
+
+    if(set->motor_min > set->hover || set->hover > set->motor_max)
+    {
+        edit.shadow = edit.pending ? edit.staged : params;
+        return param_inconsistent;
+    }
+    edit.staged = *set;
+    edit.pending = 1;
+    return param_ok;
+}
+
+/*
+ * PARAMS TICK - makes a committed set live, called at the start of each
+ *              control tick before anything reads a parameter
+ */
+void params_tick(void)
+{
+    int i, changed = 0;
+
+    if(!edit.pending) return;
+    for(i = 0; i < PARAMS_COUNT; i++)
+        if(memcmp((uint8_t *) &params + info[i].offset, (uint8_t *) &edit.staged + info[i].offset, 4) != 0)
+            changed++;
+    params = edit.staged;
+    edit.pending = 0;
+    evlog_write(ev_params_swapped, changed);
+}
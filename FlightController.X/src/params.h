@@ -0,0 +1,121 @@
+/*
+ * File:   params.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the tunable parameter registry. The control code
+ *           reads the live set through the params global directly. Changes,
+ *           from the serial link or the debugger, go into a shadow copy and
+ *           are copied over the live set by params_tick() at the start of a
+ *           control tick, so a tick never sees half of an update.
+ * Revision history:
+ */
+
+#ifndef PARAMS_H
+#define	PARAMS_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * param_type - how the 4 bytes of a value are read
+ */
+enum param_type
+{
+    param_float, param_int
+};
+
+/*
+ * param_flags - what may be done with a value
+ */
+enum param_flags
+{
+    param_rw = 0, param_ro = 1
+};
+
+/*
+ * param_filter - fir filter selection
+ * fir_auto - the overload monitor picks the filter
+ * fir_long - always the 52 tap filter
+ * fir_short - always the 16 tap filter
+ */
+enum param_filter
+{
+    fir_auto, fir_long, fir_short
+};
+
+// name, type, default, min, max, flags
+#define PARAMS(X) \
+    X(kp,              param_float, 3.15,            0.0,   20.0,         param_rw) \
+    X(ki,              param_float, 1.85,            0.0,   20.0,         param_rw) \
+    X(kd,              param_float, 0.90,            0.0,   20.0,         param_rw) \
+    X(kff,             param_float, 0.0,             0.0,   5.0,          param_rw) \
+    X(pid_factor,      param_float, 12.0,            0.0,   100.0,        param_rw) \
+    X(hover,           param_int,   3400,            2500,  5000,         param_rw) \
+    X(motor_min,       param_int,   2650,            2500,  5000,         param_rw) \
+    X(motor_max,       param_int,   4650,            2500,  5000,         param_rw) \
+    X(filter,          param_int,   fir_auto,        0,     fir_short,    param_rw) \
+    X(predict_gain,    param_float, PREDICT_GAIN,    0.0,   1.0,          param_rw) \
+    X(predict_max_ms,  param_float, PREDICT_MAX_MS,  0.0,   300.0,        param_rw) \
+    X(rc_max_angle,    param_float, RC_MAX_ANGLE,    0.0,   M_PI / 4,     param_rw) \
+    X(rc_max_yaw_rate, param_float, RC_MAX_YAW_RATE, 0.0,   2 * M_PI,     param_rw) \
+    X(rc_max_accel,    param_float, RC_MAX_ACCEL,    0.0,   2.0,          param_rw) \
+    X(loop_rate_hz,    param_int,   LOOP_RATE_HZ,    100,   800,          param_ro) \
+
+#define PARAM_CTYPE_param_float float
+#define PARAM_CTYPE_param_int int32_t
+
+/*
+ * params_set - one complete set of values, a field per PARAMS entry
+ */
+#define PARAM_FIELD(name, type, def, min, max, flags) PARAM_CTYPE_##type name;
+typedef struct
+{
+    PARAMS(PARAM_FIELD)
+} params_set;
+#undef PARAM_FIELD
+
+/*
+ * param_info - describes one entry for the serial link
+ * @param name - the field name
+ * @param type - the param_type
+ * @param flags - the param_flags
+ * @param min, max - the accepted range
+ * @param offset - byte offset of the value in params_set
+ */
+typedef struct
+{
+    const char *name;
+    uint8_t type;
+    uint8_t flags;
+    float min;
+    float max;
+    uint16_t offset;
+} param_info;
+
+/*
+ * param_error - why a change was refused
+ */
+enum param_error
+{
+    param_ok = 0,
+    param_unknown = -1,     // no parameter with that index
+    param_read_only = -2,
+    param_range = -3,       // value outside min..max
+    param_inconsistent = -4 // the set as a whole is invalid, e.g. motor_min above hover
+};
+
+extern params_set params;
+
+int params_count(void);
+const param_info *params_info(int index);
+uint32_t params_get(int index);
+int params_set_value(int index, uint32_t raw);
+int params_commit(void);
+void params_tick(void);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* PARAMS_H */
+
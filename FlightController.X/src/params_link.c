@@ -0,0 +1,282 @@
+/*
+ * File:   params_link.c
+ * Author: Kevin Dederer
+ * Comments: parameter link on UART1, @see params_link.h. The receive ring is
+ *           written by the interrupt and read by the loop, the transmit ring
+ *           is only touched by the loop, which feeds the uart from it.
+ * Revision history:
+ */
+
+#include <string.h>
+#include "config.h"
+
+#ifdef PARAMS_LINK
+
+#if (PARAMS_LINK_RING & (PARAMS_LINK_RING - 1)) != 0
+#error "PARAMS_LINK_RING must be a power of 2"
+#endif
+
+#define PLINK_MASK (PARAMS_LINK_RING - 1)
+#define PLINK_OVERHEAD (4)          // sync, command, length and crc
+
+/*
+ * plink_data - link state
+ * @param rx, rx_head, rx_tail - receive ring, head written by the interrupt
+ * @param tx, tx_head, tx_tail - transmit ring
+ * @param frame - the frame being received, from the command byte on
+ * @param got - bytes of frame received, -1 while hunting for the sync byte
+ * @param status - counters
+ */
+typedef struct
+{
+    volatile uint8_t rx[PARAMS_LINK_RING];
+    volatile uint32_t rx_head;
+    volatile uint32_t rx_tail;
+    uint8_t tx[PARAMS_LINK_RING];
+    uint32_t tx_head;
+    uint32_t tx_tail;
+    uint8_t frame[PARAMS_LINK_PAYLOAD + 3];
+    int got;
+    volatile params_link_status status;
+} plink_data;
+
+PRIVATE plink_data plink = { .got = -1 };
+
+/*
+ * __ISR() ParamsLinkHandler() - moves received bytes into the receive ring
+ */
+HAL_UART_ISR(ParamsLinkHandler)
+{
+    uint8_t byte;
+
+    while(hal_uart_rx_ready())
+    {
+        byte = hal_uart_read();
+        if(plink.rx_head - plink.rx_tail >= PARAMS_LINK_RING)
+        {
+            plink.status.rx_overruns++;
+            continue;
+        }
+        plink.rx[plink.rx_head & PLINK_MASK] = byte;
+        plink.rx_head++;
+    }
+    hal_uart_clear();
+}
+
+/*
+ * PLINK CRC - crc8 with polynomial 0x07
+ * @param crc - 0, or the crc of the bytes before data
+ * @param *data - the bytes
+ * @param len - number of bytes
+ * @return the crc.
+ */
+PRIVATE uint8_t plink_crc(uint8_t crc, const uint8_t *data, int len)
+{
+    int i;
+
+    while(len-- > 0)
+    {
+        crc ^= *data++;
+        for(i = 0; i < 8; i++)
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+
+/*
+ * PLINK PUT32 - stores a value little endian
+ * @param *p - the 4 bytes
+ * @param value - the value
+ */
+PRIVATE void plink_put32(uint8_t *p, uint32_t value)
+{
+    p[0] = value;
+    p[1] = value >> 8;
+    p[2] = value >> 16;
+    p[3] = value >> 24;
+}
+
+/*
+ * PLINK GET32 - reads a little endian value
+ * @param *p - the 4 bytes
+ * @return the value.
+ */
+PRIVATE uint32_t plink_get32(const uint8_t *p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+/*
+ * PLINK REPLY - queues an answer frame
+ * @param command - the command byte
+ * @param *payload - the payload
+ * @param len - payload length
+ */
+PRIVATE void plink_reply(uint8_t command, const uint8_t *payload, int len)
+{
+    uint8_t head[3] = { PARAMS_LINK_SYNC, command, len };
+    int i;
+
+    if(PARAMS_LINK_RING - (plink.tx_head - plink.tx_tail) < (uint32_t) len + PLINK_OVERHEAD)
+    {
+        plink.status.tx_dropped++;
+        return;
+    }
+    for(i = 0; i < 3; i++)
+        plink.tx[plink.tx_head++ & PLINK_MASK] = head[i];
+    for(i = 0; i < len; i++)
+        plink.tx[plink.tx_head++ & PLINK_MASK] = payload[i];
+    plink.tx[plink.tx_head++ & PLINK_MASK] = plink_crc(plink_crc(0, head + 1, 2), payload, len);
+}
+
+/*
+ * PLINK ERROR - queues an error answer
+ * @param command - the command that failed
+ * @param error - the params_link_error
+ */
+PRIVATE void plink_error(uint8_t command, uint8_t error)
+{
+    plink_reply(command | PLINK_ERROR, &error, 1);
+}
+
+/*
+ * PLINK HANDLE - answers a complete frame
+ * @param command - the command byte
+ * @param *payload - the payload
+ * @param len - payload length
+ */
+PRIVATE void plink_handle(uint8_t command, const uint8_t *payload, int len)
+{
+    static const int expect[PLINK_COMMANDS] = { 0, 1, 1, 5, 0 };
+    uint8_t out[PARAMS_LINK_PAYLOAD];
+    const param_info *p = NULL;
+    uint32_t raw;
+    float limit;
+    int n;
+
+    if(command >= PLINK_COMMANDS) { plink_error(command, plink_bad_command); return; }
+    if(len != expect[command]) { plink_error(command, plink_bad_length); return; }
+    if(len > 0)
+    {
+        p = params_info(payload[0]);
+        if(p == NULL) { plink_error(command, plink_bad_index); return; }
+    }
+
+    switch(command)
+    {
+        case plink_ping:
+            out[0] = PARAMS_LINK_VERSION;
+            out[1] = params_count();
+            plink_reply(command, out, 2);
+            break;
+        case plink_info:
+            out[0] = payload[0];
+            out[1] = p->type;
+            out[2] = p->flags;
+            limit = p->min;
+            memcpy(&raw, &limit, 4);
+            plink_put32(out + 3, raw);
+            limit = p->max;
+            memcpy(&raw, &limit, 4);
+            plink_put32(out + 7, raw);
+            n = strlen(p->name);
+            n = (n > PARAMS_LINK_PAYLOAD - 11) ? PARAMS_LINK_PAYLOAD - 11 : n;
+            memcpy(out + 11, p->name, n);
+            plink_reply(command, out, 11 + n);
+            break;
+        case plink_get:
+            out[0] = payload[0];
+            plink_put32(out + 1, params_get(payload[0]));
+            plink_reply(command, out, 5);
+            break;
+        case plink_set:
+            out[0] = payload[0];
+            out[1] = params_set_value(payload[0], plink_get32(payload + 1));
+            plink_reply(command, out, 2);
+            break;
+        case plink_commit:
+            out[0] = params_commit();
+            plink_reply(command, out, 1);
+            break;
+    }
+    plink.status.frames++;
+}
+
+/*
+ * PLINK BYTE - adds a received byte to the frame
+ * @param byte - the byte
+ * @return 1 if it completed a frame, 0 otherwise.
+ */
+PRIVATE int plink_byte(uint8_t byte)
+{
+    int len;
+
+    if(plink.got < 0)
+    {
+        if(byte == PARAMS_LINK_SYNC) plink.got = 0;
+        return 0;
+    }
+    plink.frame[plink.got++] = byte;
+    if(plink.got < 2) return 0;
+    len = plink.frame[1];
+    if(len > PARAMS_LINK_PAYLOAD)
+    {
+        plink.got = -1;     // not a frame, hunt for the next sync byte
+        return 0;
+    }
+    if(plink.got < len + 3) return 0;
+
+    plink.got = -1;
+    if(plink_crc(0, plink.frame, len + 2) != plink.frame[len + 2])
+    {
+        plink.status.crc_errors++;
+        return 0;
+    }
+    plink_handle(plink.frame[0], plink.frame + 2, len);
+    return 1;
+}
+
+/*
+ * PARAMS LINK OPEN - starts the uart
+ */
+void params_link_open(void)
+{
+    unsigned int rate = hal_uart_open(PARAMS_LINK_BAUD);
+
+    if(abs((int) rate - PARAMS_LINK_BAUD) > PARAMS_LINK_BAUD / 50)
+        evlog_write(ev_params_link_baud, rate);
+}
+
+/*
+ * PARAMS LINK STEP - sends what the uart takes and decodes received bytes up
+ *              to the end of one frame, called from the loop slack. Bounded by
+ *              PARAMS_LINK_STEP_TICKS.
+ * @return 1 if there was anything to do, 0 otherwise.
+ */
+int params_link_step(void)
+{
+    int busy = 0;
+
+    while(plink.tx_tail != plink.tx_head && hal_uart_tx_ready())
+    {
+        hal_uart_write(plink.tx[plink.tx_tail++ & PLINK_MASK]);
+        busy = 1;
+    }
+    while(plink.rx_tail != plink.rx_head)
+    {
+        busy = 1;
+        if(plink_byte(plink.rx[plink.rx_tail++ & PLINK_MASK])) break;
+    }
+    return busy;
+}
+
+/*
+ * PARAMS LINK GET STATUS - read only access to the link counters
+ * @return the counters.
+ */
+const params_link_status *params_link_get_status(void)
+{
+    return (const params_link_status *) &plink.status;
+}
+
+#endif /* PARAMS_LINK */
@@ -0,0 +1,86 @@
+/*
+ * File:   params_link.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the parameter link on UART1. Define PARAMS_LINK in
+ *           config.h to build it. The receive interrupt only queues bytes,
+ *           frames are decoded and answered by params_link_step() in the loop
+ *           slack. tools/params_cli.py is the other end.
+ *
+ *           frame   0xA5, command, length, payload[length], crc8
+ *                   crc8 is polynomial 0x07 over command, length and payload,
+ *                   multi byte values are little endian, values are the 4
+ *                   bytes of a float or an int32 by the parameter type
+ *           ping    00 -                       -> 00 version count
+ *           info    01 index                   -> 01 index type flags min:f32 max:f32 name
+ *           get     02 index                   -> 02 index value
+ *           set     03 index value             -> 03 index status
+ *           commit  04 -                       -> 04 status
+ *           error   -                          -> command|80 error
+ *           status is a param_error, set only changes the shadow set and
+ *           commit stages it for the next control tick, @see params.h
+ * Revision history:
+ */
+
+#ifndef PARAMS_LINK_H
+#define	PARAMS_LINK_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#if defined(PARAMS_LINK) && defined(RC_SBUS)
+#error "the parameter link and the sbus receiver both need UART1"
+#endif
+
+#define PARAMS_LINK_BAUD (57600)
+#define PARAMS_LINK_VERSION (1)
+#define PARAMS_LINK_SYNC (0xA5)
+#define PARAMS_LINK_PAYLOAD (32)        // longest payload either way
+#define PARAMS_LINK_RING (64)           // bytes queued each way, must be a power of 2
+#define PARAMS_LINK_STEP_TICKS (4000)   // worst case core ticks of one params_link_step() (100us)
+
+/*
+ * params_link_command - the frame commands
+ */
+enum params_link_command
+{
+    plink_ping, plink_info, plink_get, plink_set, plink_commit,
+    PLINK_COMMANDS,
+    PLINK_ERROR = 0x80
+};
+
+/*
+ * params_link_error - payload of an error frame
+ */
+enum params_link_error
+{
+    plink_bad_command = 1,      // unknown command
+    plink_bad_length = 2,       // payload too short or too long for the command
+    plink_bad_index = 3         // no parameter with that index
+};
+
+/*
+ * params_link_status - link counters
+ * @param frames - frames answered
+ * @param crc_errors - frames dropped for a bad crc
+ * @param rx_overruns - bytes lost because the receive ring was full
+ * @param tx_dropped - answers lost because the transmit ring was full
+ */
+typedef struct
+{
+    unsigned int frames;
+    unsigned int crc_errors;
+    unsigned int rx_overruns;
+    unsigned int tx_dropped;
+} params_link_status;
+
+void params_link_open(void);
+int params_link_step(void);
+const params_link_status *params_link_get_status(void);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* PARAMS_LINK_H */
+
@@ -1,66 +1,95 @@
-/* 
- * File:   pid.c
- * Author: Kevin Dederer
- * Comments: controlling logic for the pid loops
- * Revision history: 
- */
-
-#include "config.h"
-
-#define MAX (4650)       // max output value for functions
-#define MIN (2650)        // min output value for functions
-#define HOVER (3400)      // speed at which craft will hover (approx.))
-#define PID_DT (.01) // the frequency at which the pid loops are executed
-#define PID_FACTOR (12)
-/*
- * PID - controls the engine speed for the front left engine.
- * @param location - struct with all of the location data. (user and actual)
- * @param engine - pointer to struct with all of the pid necessary engine values
- * @param p_data - struct containing the pid parameters.
- */
-void pid(location_data *location, struct e_data *engine, pid_data *p_data)
-{
-    float error, pitch_error, roll_error, yaw_error, p, i, d;
-    
-    pitch_error = (location->user.pitch - location->actual.pitch) * engine->pitch_sign;
-    roll_error = (location->user.roll - location->actual.roll) * engine->roll_sign;
-    yaw_error = (location->user.accel_z - location->actual.accel_z);
-    error = (pitch_error + roll_error + yaw_error);
-    p = p_data->kp * error;
-    engine->total += error * PID_DT;
-    i = engine->total * p_data->ki;
-    d = p_data->kd * (error - engine->last) / PID_DT;
-    engine->last = error;
-    engine->pid_out = (p + i + d);
-}
-
-/* translation - manipulates the engine speed data to be within the desired range
- * @param *engine - pointer to the struct of the engine being modified.
- */
-void translation(struct e_data *engine)
-{
-    float sgn = (engine->pid_out < 0) ? -1 : 1;
-    float temp = sgn * pow(abs(engine->pid_out),2.4) * PID_FACTOR + HOVER;
-    temp = (temp > MAX) ? MAX : temp;
-    temp = (temp < MIN) ? MIN : temp;
-    engine->speed = temp;
-}
-
-/*
- * PID CONTROL FUNCTION - callable by main to run the 4 pid functions with a single call
- * @param location - struct with all of the location data. (user and actual)
- * @param engine - struct with all of the pid necessary engine values
- */
-void pid_control_function(location_data *location, engine_data *engine)
-{
-    pid_data p_data = {3.15, 1.85, 0.90};
-
-    pid(location, &engine->e1, &p_data);
-    pid(location, &engine->e2, &p_data);
-    pid(location, &engine->e3, &p_data);
-    pid(location, &engine->e4, &p_data);
-    translation(&engine->e1);
-    translation(&engine->e2);
-    translation(&engine->e3);
-    translation(&engine->e4);
-}
+/* 
+ * File:   pid.c
+ * Author: Kevin Dederer
+ * Comments: controlling logic for the pid loops
+ * Revision history: 
+ */
+
+#include "config.h"
+
+PRIVATE timing_interval pid_interval;   // time between controller updates
+
+/*
+ * PID - controls the engine speed for the front left engine.
+ * @param location - struct with all of the location data. (user and actual)
+ * @param engine - pointer to struct with all of the pid necessary engine values
+ * @param set - the gains, kp, ki, kd and kff
+ * @param dt - seconds since the last update
+ * @param hold - nonzero if the attitude is the last good one, the integrator
+ *              is frozen so a stale error does not wind it up
+ */
+HOT_PATH void pid(location_data *location, struct e_data *engine, const params_set *set, float dt,
+                  int hold)
+{
+    PROFILE_START(prof_pid);
+    float error, pitch_error, roll_error, yaw_error, p, i, d, ff;
+    
+    pitch_error = (location->user.pitch - location->predicted.pitch) * engine->pitch_sign;
+    roll_error = (location->user.roll - location->predicted.roll) * engine->roll_sign;
+    yaw_error = (location->user.accel_z - location->predicted.accel_z);
+    error = (pitch_error + roll_error + yaw_error);
+    p = set->kp * error;
+    if(!hold) engine->total += error * dt;
+    i = engine->total * set->ki;
+    d = set->kd * (error - engine->last) / dt;
+    engine->last = error;
+    // the setpoint rate acts at once instead of waiting for the error to build up
+    ff = set->kff * (location->user_rate.pitch * engine->pitch_sign +
+                     location->user_rate.roll * engine->roll_sign);
+    engine->pid_out = (p + i + d + ff);
+    PROFILE_STOP(prof_pid);
+}
+
+/*
+ * PID CURVE - the thrust curve of the controller output, kept in flash with
+ *              pow() so the ram copy of translation() calls it long
+ * @param out - the magnitude of the pid output, truncated
+ * @return out to the power 2.4
+ */
+PRIVATE FLASH_CALL double pid_curve(int out)
+{
+    return pow(out, 2.4);
+}
+
+/* translation - manipulates the engine speed data to be within the desired range
+ * @param *engine - pointer to the struct of the engine being modified.
+ * @param set - the hover speed, output factor and motor limits
+ * @param scale - battery compensation of the throttle above MOTOR_ZERO, @see power.h
+ */
+HOT_PATH void translation(struct e_data *engine, const params_set *set, float scale)
+{
+    PROFILE_START(prof_translation);
+    float sgn = (engine->pid_out < 0) ? -1 : 1;
+    float temp = sgn * pid_curve(abs((int) engine->pid_out)) * set->pid_factor + set->hover;
+    temp = MOTOR_ZERO + (temp - MOTOR_ZERO) * scale;
+    temp = (temp > set->motor_max) ? set->motor_max : temp;
+    temp = (temp < set->motor_min) ? set->motor_min : temp;
+    engine->speed = temp;
+    PROFILE_STOP(prof_translation);
+}
+
+/*
+ * PID CONTROL FUNCTION - callable by main to run the 4 pid functions with a single call,
+ *              the new speeds are published to the pwm interrupt together
+ * @param location - struct with all of the location data. (user and actual)
+ * @param engine - struct with all of the pid necessary engine values
+ * @param stamp - timing_now() of the sample the attitude comes from, or of
+ *              this call when the attitude was not updated
+ * @param hold - nonzero if the attitude was not updated, @see mode_hold_attitude
+ */
+void pid_control_function(location_data *location, engine_data *engine, uint32_t stamp, int hold)
+{
+    float dt = timing_interval_dt(&pid_interval, stamp);
+    float scale = REPLAY_INPUT(thrust_scale, power_thrust_scale());
+
+    predict_setpoint(location, dt);
+    pid(location, &engine->e1, &params, dt, hold);
+    pid(location, &engine->e2, &params, dt, hold);
+    pid(location, &engine->e3, &params, dt, hold);
+    pid(location, &engine->e4, &params, dt, hold);
+    translation(&engine->e1, &params, scale);
+    translation(&engine->e2, &params, scale);
+    translation(&engine->e3, &params, scale);
+    translation(&engine->e4, &params, scale);
+    motor_publish(engine);
+}
@@ -0,0 +1,189 @@
+/*
+ * File:   pipe.c
+ * Author: Kevin Dederer
+ * Comments: the sample pipeline stages, @see pipe.h. Each stage takes the
+ *           frame of the current call and works on the block in place. The
+ *           fir keeps its history in front of the block, so appending a block
+ *           and moving the history down is done once per block instead of
+ *           shifting the whole history for every sample. Every sample is
+ *           filtered, at PIPE_DECIMATE 4 that is 5 outputs of 52 taps per
+ *           axis, of which decimate keeps one.
+ * Revision history:
+ */
+
+#include "config.h"
+
+/*
+ * pipe_frame - what the stages work on during one pipe_run()
+ * @param pipe - the state carried between blocks
+ * @param block - the samples of the tick
+ * @param lsm330 - zero offsets and sensitivity in, the filtered sample out
+ * @param location - receives the measured attitude in actual
+ * @param short_fir - use the 16 tap fir set
+ */
+typedef struct
+{
+    pipe_state *pipe;
+    sensor_block *block;
+    sensor_data *lsm330;
+    location_data *location;
+    int short_fir;
+} pipe_frame;
+
+#define X(name) PRIVATE void pipe_##name(pipe_frame *f);
+PIPE_STAGES
+#undef X
+
+/*
+ * PIPE OFFSET - adds the zero offsets to every sample
+ * @param *f - the frame
+ */
+HOT_PATH PRIVATE void pipe_offset(pipe_frame *f)
+{
+    sensor_block *b = f->block;
+    const int32_t zero[3] = { f->lsm330->zero_x, f->lsm330->zero_y, f->lsm330->zero_z };
+    int axis, i;
+
+    for(axis = 0; axis < 3; axis++)
+        for(i = 0; i < b->count; i++)
+            b->axis[axis][i] = lsm330_add_zero(b->axis[axis][i], zero[axis]);
+}
+
+/*
+ * PIPE NOTCH - pushes the z samples to the vibration analyser and runs every
+ *              axis through the dynamic notch
+ * @param *f - the frame
+ */
+HOT_PATH PRIVATE void pipe_notch(pipe_frame *f)
+{
+    sensor_block *b = f->block;
+    int axis, i;
+
+    for(i = 0; i < b->count; i++)
+        vibe_push_sample(b->axis[2][i]);
+    for(axis = 0; axis < 3; axis++)
+        vibe_notch(b->axis[axis], b->count, &f->pipe->notch[axis]);
+}
+
+/*
+ * PIPE FIR - low pass filters every sample. The block is appended to the
+ *              history so each output is a dot product over a contiguous
+ *              window, the newest sample last. The 16 tap set reads the newest
+ *              part of the same history, so the long set has a full window
+ *              the moment it takes over again. The group delay still changes
+ *              by (FIR_TAPS - FIR_SHORT_TAPS) / 2 samples at a switch, the
+ *              angle steps by the rotation in that time, @see predict.c.
+ * @param *f - the frame
+ */
+HOT_PATH PRIVATE void pipe_fir(pipe_frame *f)
+{
+    PROFILE_START(prof_filter);
+    static const int16_t B[FIR_TAPS] = { FIR_COEFFS };
+    static const int16_t S[FIR_SHORT_TAPS] = { FIR_SHORT_COEFFS };
+    sensor_block *b = f->block;
+    const int16_t *w;
+    int16_t *h, *x;
+    int32_t sum;
+    int axis, n, k;
+
+    // plain loops, memcpy and memmove are in flash
+    for(axis = 0; axis < 3; axis++)
+    {
+        h = f->pipe->history[axis];
+        x = b->axis[axis];
+        for(n = 0; n < b->count; n++)
+            h[FIR_TAPS - 1 + n] = x[n];
+        for(n = 0; n < b->count; n++)
+        {
+            w = &h[n];
+            sum = 1 << (FIR_SHIFT - 1);
+            if(f->short_fir)
+                for(k = 0; k < FIR_SHORT_TAPS; k++)
+                    sum += (int32_t) w[FIR_TAPS - 1 - k] * S[k];
+            else
+                for(k = 0; k < FIR_TAPS; k++)
+                    sum += (int32_t) w[k] * B[k];
+            sum >>= FIR_SHIFT;
+            x[n] = (sum > 32767) ? 32767 : (sum < -32768) ? -32768 : sum;
+        }
+        for(k = 0; k < FIR_TAPS - 1; k++)
+            h[k] = h[k + b->count];
+    }
+    PROFILE_STOP(prof_filter);
+}
+
+/*
+ * PIPE DECIMATE - reduces the block to its newest sample
+ * @param *f - the frame
+ */
+HOT_PATH PRIVATE void pipe_decimate(pipe_frame *f)
+{
+    sensor_block *b = f->block;
+    int axis;
+
+    for(axis = 0; axis < 3; axis++)
+        b->axis[axis][0] = b->axis[axis][b->count - 1];
+    b->count = 1;
+}
+
+/*
+ * PIPE ATTITUDE - stores the filtered sample in counts and in g and calculates
+ *              the pitch and roll of the drone
+ * @param *f - the frame
+ */
+HOT_PATH PRIVATE void pipe_attitude(pipe_frame *f)
+{
+    PROFILE_START(prof_attitude);
+    sensor_data *lsm330 = f->lsm330;
+    struct data *actual = &f->location->actual;
+    float g = lsm330->sensitivity;
+
+    lsm330->out_x = f->block->axis[0][0];
+    lsm330->out_y = f->block->axis[1][0];
+    lsm330->out_z = f->block->axis[2][0];
+    lsm330->accel_x = lsm330->out_x * g;
+    lsm330->accel_y = lsm330->out_y * g;
+    lsm330->accel_z = lsm330->out_z * g;
+    actual->accel_z = lsm330->accel_z;
+    actual->pitch = trig_atan2(lsm330->out_x, lsm330->out_z) * TRIG_RAD_PER_UNIT;
+    actual->roll = trig_atan2(lsm330->out_y, lsm330->out_z) * TRIG_RAD_PER_UNIT;
+    PROFILE_STOP(prof_attitude);
+}
+
+/*
+ * PIPE RUN - runs a block through PIPE_STAGES. The newest raw sample and the
+ *              block time are kept in lsm330 for the zero tracking.
+ * @param *pipe - the filter state
+ * @param *block - the samples of the tick, processed in place
+ * @param *lsm330 - zero offsets and sensitivity, receives the filtered sample
+ * @param *location - receives the measured attitude in actual
+ * @param short_fir - use the 16 tap fir set
+ */
+HOT_PATH void pipe_run(pipe_state *pipe, sensor_block *block, sensor_data *lsm330,
+                       location_data *location, int short_fir)
+{
+    pipe_frame f = { pipe, block, lsm330, location, short_fir };
+
+    lsm330->raw_x = block->axis[0][block->count - 1];
+    lsm330->raw_y = block->axis[1][block->count - 1];
+    lsm330->raw_z = block->axis[2][block->count - 1];
+    lsm330->time = block->time;
+
+#define X(name) pipe_##name(&f);
+    PIPE_STAGES
+#undef X
+}
+
+/*
+ * PIPE PRIME - fills the fir history with a block before flight
+ * @param *pipe - the filter state
+ * @param *block - the samples, processed in place
+ * @param *lsm330 - the zero offsets
+ */
+void pipe_prime(pipe_state *pipe, sensor_block *block, sensor_data *lsm330)
+{
+    pipe_frame f = { pipe, block, lsm330, NULL, 0 };
+
+    pipe_offset(&f);
+    pipe_fir(&f);
+}
@@ -0,0 +1,57 @@
+/*
+ * File:   pipe.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the sample pipeline between the imu and the pid.
+ *           The imu delivers the samples of a tick as one sensor_block and
+ *           every stage processes the whole block in place in one call, so
+ *           the call and set up cost is paid once per block and the inner
+ *           loops run over the contiguous samples of one axis. The stages
+ *           and their order are fixed at build time by PIPE_STAGES. With
+ *           PIPE_DECIMATE at 1 a block is the one sample of the tick.
+ * Revision history:
+ */
+
+#ifndef PIPE_H
+#define	PIPE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * PIPE_STAGES - the stages in the order they run, X(name) runs pipe_name()
+ * offset - adds the zero offsets so the filters see centred counts
+ * notch - feeds the vibration analyser and removes the motor peak
+ * fir - the low pass filter, the 16 tap set while overloaded
+ * decimate - keeps the newest sample, the fir is its anti-aliasing filter
+ * attitude - converts the sample to g and to pitch and roll
+ */
+#define PIPE_STAGES \
+    X(offset) \
+    X(notch) \
+    X(fir) \
+    X(decimate) \
+    X(attitude)
+
+/*
+ * pipe_state - the filter state carried from block to block
+ * @param history - per axis the last FIR_TAPS - 1 samples, oldest first,
+ *              with room behind them for a block
+ * @param notch - per axis the notch filter history
+ */
+typedef struct
+{
+    int16_t history[3][FIR_TAPS - 1 + PIPE_BLOCK];
+    notch_state notch[3];
+} pipe_state;
+
+HOT_PATH void pipe_run(pipe_state *pipe, sensor_block *block, sensor_data *lsm330,
+                       location_data *location, int short_fir);
+void pipe_prime(pipe_state *pipe, sensor_block *block, sensor_data *lsm330);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* PIPE_H */
+
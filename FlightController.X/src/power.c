@@ -0,0 +1,131 @@
+/*
+ * File:   power.c
+ * Author: Kevin Dederer
+ * Comments: battery monitor, @see power.h. ADC10 samples and converts by
+ *           itself, auto sampling with the internal counter ending each
+ *           sample, scanning the two inputs into one half of the 16 result
+ *           buffers while the interrupt reads the other. With 32 pb clocks as
+ *           TAD, 3.2us, a conversion is 31 + 12 TAD, 138us, so the interrupt
+ *           comes every 1.1ms and does all the float work. The control loop
+ *           reads one published float per tick.
+ * Revision history:
+ */
+
+#include "config.h"
+
+/*
+ * power_data - monitor state
+ * @param status - the published readings
+ */
+typedef struct
+{
+    power_status status;
+} power_data;
+
+PRIVATE power_data power = { .status = { .thrust_scale = 1.0 } };
+
+/*
+ * POWER SCAN - converts the sums of one interrupt and publishes the readings,
+ *              called from the adc interrupt
+ * @param vbat_counts - POWER_AVERAGE battery voltage conversions summed
+ * @param current_counts - POWER_AVERAGE current conversions summed
+ */
+void power_scan(uint32_t vbat_counts, uint32_t current_counts)
+{
+    power_status *s = &power.status;
+    float vbat = vbat_counts * (float) (POWER_VOLTS_PER_COUNT * POWER_VBAT_DIVIDER);
+    float current = (current_counts * (float) POWER_VOLTS_PER_COUNT - POWER_CURRENT_ZERO) * POWER_AMPS_PER_VOLT;
+
+    if(s->scans == 0)
+    {
+        s->vbat = vbat;
+        s->current = current;
+    }
+    s->vbat += POWER_SMOOTH * (vbat - s->vbat);
+    s->current += POWER_SMOOTH * (current - s->current);
+    vbat = s->vbat;
+    if(vbat < POWER_VBAT_PRESENT)
+        s->thrust_scale = 1.0;
+    else
+        s->thrust_scale = POWER_VBAT_NOMINAL / ((vbat < POWER_VBAT_MIN) ? POWER_VBAT_MIN : vbat);
+    s->scans++;
+}
+
+#if defined(HAL_HOST)
+
+// no pack on the host, the scale stays at 1 and no reading is published
+
+#else
+
+/*
+ * __ISR() AdcHandler() - one half of the buffers is full, even ones hold the
+ *              battery voltage and odd ones the current in scan order. The
+ *              converter fills the other half meanwhile, so at the lowest
+ *              priority the interrupt still has the whole 1.1ms to read them
+ *              instead of the 138us of the next conversion.
+ */
+void __ISR(_ADC_VECTOR, IPL1SOFT) AdcHandler(void)
+{
+    uint32_t vbat = 0, current = 0;
+    int i, base = ReadActiveBufferADC10() ? 0 : 2 * POWER_AVERAGE;  // the half not being filled
+
+    for(i = base; i < base + 2 * POWER_AVERAGE; i += 2)
+    {
+        vbat += ReadADC10(i);
+        current += ReadADC10(i + 1);
+    }
+    mAD1ClearIntFlag();
+    power_scan(vbat, current);
+}
+
+#endif /* HAL_HOST */
+
+/*
+ * POWER OPEN - starts the background scan of the battery inputs
+ */
+void power_open(void)
+{
+#if !defined(HAL_HOST)
+    CloseADC10();
+    SetChanADC10(ADC_CH0_NEG_SAMPLEA_NVREF);
+    OpenADC10(ADC_MODULE_ON | ADC_FORMAT_INTG | ADC_CLK_AUTO | ADC_AUTO_SAMPLING_ON,
+              ADC_VREF_AVDD_AVSS | ADC_OFFSET_CAL_DISABLE | ADC_SCAN_ON |
+              ADC_SAMPLES_PER_INT_8 | ADC_ALT_BUF_ON | ADC_ALT_INPUT_OFF,
+              ADC_CONV_CLK_PB | ADC_SAMPLE_TIME_31 | ADC_CONV_CLK_32Tcy,
+              ENABLE_AN2_ANA | ENABLE_AN3_ANA,
+              ~(SKIP_SCAN_AN2 | SKIP_SCAN_AN3));    // scans the inputs not skipped
+    mAD1SetIntPriority(1);
+    mAD1ClearIntFlag();
+    mAD1IntEnable(1);
+    EnableADC10();
+#endif
+}
+
+/*
+ * POWER THRUST SCALE - the factor for the throttle above zero
+ * @return nominal over measured voltage, 1 before the first reading.
+ */
+float power_thrust_scale(void)
+{
+    return power.status.thrust_scale;
+}
+
+/*
+ * POWER GET STATUS - read only access to the readings for telemetry
+ * @return the readings.
+ */
+const power_status *power_get_status(void)
+{
+    return &power.status;
+}
+
+/*
+ * POWER REPORT - prints the readings as one JSON line
+ */
+void power_report(void)
+{
+    const power_status *s = &power.status;
+
+    printf("{\"power\":{\"scans\":%u,\"vbat\":%.2f,\"current\":%.2f,\"thrust_scale\":%.3f}}\n",
+           (unsigned int) s->scans, s->vbat, s->current, s->thrust_scale);
+}
@@ -0,0 +1,62 @@
+/*
+ * File:   power.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the battery monitor. ADC10 scans the battery
+ *           voltage and current inputs on its own, the interrupt at the end of
+ *           every POWER_AVERAGE scans converts the sums and publishes the
+ *           voltage, the current and the thrust scale, the loop only loads
+ *           them. The same speed gives less thrust as the pack sags, the
+ *           translation multiplies the throttle above zero by nominal over
+ *           measured voltage so the integrators do not wind up to make up for
+ *           it.
+ * Revision history:
+ */
+
+#ifndef POWER_H
+#define	POWER_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+// the battery divider is on AN2 (RB2) and the current sensor on AN3 (RB3), the
+// scan converts them in that order, power_open() selects them
+
+#define POWER_AVERAGE (4)               // scans summed by one interrupt, 2 conversions each fill one 8 buffer half
+#define POWER_VREF (3.3)                // adc reference, AVDD, V
+#define POWER_VOLTS_PER_COUNT (POWER_VREF / 1024 / POWER_AVERAGE)   // at the pin, for a sum
+#define POWER_VBAT_DIVIDER (4.03)       // battery volts per volt at the pin, 10k over 3.3k
+#define POWER_AMPS_PER_VOLT (20.0)      // current sensor gain at the pin
+#define POWER_CURRENT_ZERO (0.0)        // current sensor output at 0 A, V
+#define POWER_SMOOTH (0.125)            // share of a new reading, about 8ms at the 1.1ms interrupt
+
+#define POWER_VBAT_NOMINAL (11.1)       // 3S pack, the voltage hover and pid_factor were tuned at
+#define POWER_VBAT_MIN (9.0)            // the scale stops growing below this, V
+#define POWER_VBAT_PRESENT (5.0)        // below this there is no pack, on the bench, and no scaling
+
+/*
+ * power_status - the published readings, written by the adc interrupt
+ * @param vbat - smoothed battery voltage, V
+ * @param current - smoothed battery current, A
+ * @param thrust_scale - factor on the throttle above zero, 1 without a pack
+ * @param scans - interrupts since power_open(), 0 until the first reading
+ */
+typedef struct
+{
+    volatile float vbat;
+    volatile float current;
+    volatile float thrust_scale;
+    volatile uint32_t scans;
+} power_status;
+
+void power_open(void);
+void power_scan(uint32_t vbat_counts, uint32_t current_counts);
+float power_thrust_scale(void);
+const power_status *power_get_status(void);
+void power_report(void);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* POWER_H */
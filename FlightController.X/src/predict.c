@@ -0,0 +1,124 @@
+/*
+ * File:   predict.c
+ * Author: Kevin Dederer
+ * Comments: attitude prediction and setpoint rate, @see predict.h. The fir
+ *           output is already smooth, so the trend is the measured angle
+ *           plus a smoothed finite difference rate times the horizon. The
+ *           horizon is params.predict_gain of the estimated latency, capped
+ *           at params.predict_max_ms, a long horizon on a noisy rate costs
+ *           more gain margin than it gives phase. A switch between the long
+ *           and the short fir changes the delay of the measured angle, the
+ *           step that makes in a steady rotation is taken out of the rate and
+ *           the horizon follows the new latency, so neither the trend nor the
+ *           predicted attitude jumps.
+ * Revision history:
+ */
+
+#include "config.h"
+
+/*
+ * predict_data - predictor state
+ * @param status - the trends and the last horizon
+ * @param primed - a previous angle is known
+ * @param fir_taps - taps of the fir the previous angle went through
+ * @param user - the previous setpoint, for the setpoint rate
+ * @param user_primed - user is valid
+ */
+typedef struct
+{
+    predict_status status;
+    int primed;
+    int fir_taps;
+    struct data user;
+    int user_primed;
+} predict_data;
+
+PRIVATE predict_data predict;
+
+/*
+ * PREDICT AXIS UPDATE - adds a measured angle to a trend
+ * @param *axis - the trend
+ * @param angle - the new measurement
+ * @param dt - seconds since the previous measurement
+ */
+HOT_PATH PRIVATE void predict_axis_update(predict_axis *axis, float angle, float dt)
+{
+    axis->rate += PREDICT_RATE_SMOOTH * ((angle - axis->last) / dt - axis->rate);
+    axis->last = angle;
+}
+
+/*
+ * PREDICT ATTITUDE - extrapolates the measured attitude to the time the next
+ *              command takes effect, the result is left in location->predicted
+ * @param *location - the measured attitude in actual
+ * @param dt - seconds since the previous sample, @see timing_sample
+ * @param stamp - timing_now() of the sample
+ * @param fir_taps - taps of the linear phase fir the sample went through, at PIPE_SAMPLE_HZ
+ */
+HOT_PATH void predict_attitude(location_data *location, float dt, uint32_t stamp, int fir_taps)
+{
+    predict_status *s = &predict.status;
+    float transfer, horizon, newer;
+
+    if(!predict.primed)
+    {
+        s->pitch = (predict_axis) { location->actual.pitch, 0 };
+        s->roll = (predict_axis) { location->actual.roll, 0 };
+        predict.fir_taps = fir_taps;
+        predict.primed = 1;
+    }
+    if(fir_taps != predict.fir_taps)
+    {
+        // the angle is newer by the group delay difference, move the previous
+        // one along the trend so the step is not taken for a rate
+        newer = (predict.fir_taps - fir_taps) / (2.0f * PIPE_SAMPLE_HZ);
+        s->pitch.last += s->pitch.rate * newer;
+        s->roll.last += s->roll.rate * newer;
+        predict.fir_taps = fir_taps;
+    }
+    predict_axis_update(&s->pitch, location->actual.pitch, dt);
+    predict_axis_update(&s->roll, location->actual.roll, dt);
+
+    transfer = (REPLAY_INPUT(now, timing_now()) - stamp) / (CORE_TICKS_PER_US * 1e6f);
+    s->latency_s = (fir_taps - 1) / (2.0f * PIPE_SAMPLE_HZ) + transfer +
+                   REPLAY_INPUT(latch_wait_s, motor_latch_wait_s());
+    horizon = params.predict_gain * s->latency_s;
+    if(horizon > params.predict_max_ms * 1e-3f) horizon = params.predict_max_ms * 1e-3f;
+    s->horizon_s = horizon;
+
+    location->predicted = location->actual;
+    location->predicted.pitch += s->pitch.rate * horizon;
+    location->predicted.roll += s->roll.rate * horizon;
+}
+
+/*
+ * PREDICT SETPOINT - tracks the rate of the pilot setpoint for the pid
+ *              feed-forward, the result is left in location->user_rate
+ * @param *location - the setpoint in user
+ * @param dt - seconds since the previous controller update
+ */
+void predict_setpoint(location_data *location, float dt)
+{
+    struct data *rate = &location->user_rate;
+    const struct data *user = &location->user;
+
+    if(!predict.user_primed)
+    {
+        predict.user = *user;
+        predict.user_primed = 1;
+    }
+    rate->pitch += PREDICT_FF_SMOOTH * ((user->pitch - predict.user.pitch) / dt - rate->pitch);
+    rate->roll += PREDICT_FF_SMOOTH * ((user->roll - predict.user.roll) / dt - rate->roll);
+    rate->accel_z += PREDICT_FF_SMOOTH * ((user->accel_z - predict.user.accel_z) / dt - rate->accel_z);
+    rate->yaw_rate += PREDICT_FF_SMOOTH * ((user->yaw_rate - predict.user.yaw_rate) / dt - rate->yaw_rate);
+    predict.user = *user;
+}
+
+/*
+ * PREDICT GET STATUS - read only access to the predictor
+ * @return the trends and the last horizon.
+ */
+const predict_status *predict_get_status(void)
+{
+    return &predict.status;
+}
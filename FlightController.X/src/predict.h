@@ -0,0 +1,60 @@
+/*
+ * File:   predict.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the latency compensation between the attitude
+ *           and the pid. A new command only acts after the fir group delay,
+ *           the read and filter time of the sample and the wait for the pwm
+ *           latch, @see motor_latch_wait_s(), so the pid is given the attitude extrapolated along its
+ *           recent trend to the time the command takes effect. The setpoint
+ *           rate is kept for the feed-forward term of the pid.
+ *           tools/latency_margin.py shows the margins this buys.
+ * Revision history:
+ */
+
+#ifndef PREDICT_H
+#define	PREDICT_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define PREDICT_GAIN (1.0)          // default share of the latency compensated, params.predict_gain
+#define PREDICT_MAX_MS (90.0)       // default longest horizon, params.predict_max_ms
+#define PREDICT_RATE_SMOOTH (0.3)   // share of each new rate taken into the trend
+#define PREDICT_FF_SMOOTH (0.5)     // share of each new setpoint rate taken into the feed-forward
+
+/*
+ * predict_axis - trend of one angle
+ * @param last - the previous measured angle
+ * @param rate - the smoothed rate of change, per second
+ */
+typedef struct
+{
+    float last;
+    float rate;
+} predict_axis;
+
+/*
+ * predict_status - read only view of the predictor
+ * @param latency_s - the last estimated time from sample to effect
+ * @param horizon_s - how far the last attitude was extrapolated
+ * @param pitch, roll - the angle trends
+ */
+typedef struct
+{
+    float latency_s;
+    float horizon_s;
+    predict_axis pitch;
+    predict_axis roll;
+} predict_status;
+
+HOT_PATH void predict_attitude(location_data *location, float dt, uint32_t stamp, int fir_taps);
+void predict_setpoint(location_data *location, float dt);
+const predict_status *predict_get_status(void);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* PREDICT_H */
+
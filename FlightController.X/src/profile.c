@@ -0,0 +1,76 @@
+/*
+ * File:   profile.c
+ * Author: Kevin Dederer
+ * Comments: cycle profiler for the control path kernels. Each kernel is timed
+ *           with the core timer, and after PROFILE_REPORT_TICKS control ticks
+ *           the results are written to the console as JSON. There is no
+ *           stored baseline, a board cannot be timed in CI, capture the
+ *           report of a known good build and compare a new one with it with
+ *           tools/profile_compare.py.
+ * Revision history:
+ */
+
+#include "config.h"
+
+#define CORE_TICK_NS (2.0e9 / SYS_FREQ)     // core timer counts at half the system clock
+#define CYCLES_PER_TICK (2)
+
+/*
+ * profile_data - accumulated timing of one kernel
+ * @param calls - number of timed calls
+ * @param total - sum of all timed core ticks
+ * @param min - the fastest call in core ticks
+ * @param max - the slowest call in core ticks
+ */
+typedef struct
+{
+    unsigned int calls;
+    uint64_t total;
+    unsigned int min;
+    unsigned int max;
+} profile_data;
+
+PRIVATE profile_data profile[PROFILE_KERNELS];
+
+PRIVATE const char *profile_name[PROFILE_KERNELS] = {
+    "convert_accel", "pipe_fir", "pipe_attitude", "pid", "translation", "pwm_update",
+    "imu_read"
+};
+
+/*
+ * PROFILE RECORD - adds one timed call to a kernel's statistics
+ * @param kernel - the kernel that was timed
+ * @param ticks - the core timer ticks the call took
+ */
+void profile_record(enum profile_kernel kernel, unsigned int ticks)
+{
+    profile_data *p = &profile[kernel];
+
+    if(p->calls == 0 || ticks < p->min) p->min = ticks;
+    if(ticks > p->max) p->max = ticks;
+    p->total += ticks;
+    p->calls++;
+}
+
+/*
+ * PROFILE REPORT - writes the kernel statistics as JSON
+ */
+void profile_report(void)
+{
+    int k;
+    unsigned int mean;
+
+    printf("{\"kernels\":[");
+    for(k = 0; k < PROFILE_KERNELS; k++)
+    {
+        profile_data *p = &profile[k];
+        mean = p->calls ? (p->total * CYCLES_PER_TICK) / p->calls : 0;
+
+        printf("%s{\"name\":\"%s\",\"calls\":%u,\"ns_per_call\":%.1f,"
+               "\"cycles_min\":%u,\"cycles_mean\":%u,\"cycles_max\":%u}",
+               k ? "," : "", profile_name[k], p->calls,
+               p->calls ? (double)p->total * CORE_TICK_NS / p->calls : 0.0,
+               p->min * CYCLES_PER_TICK, mean, p->max * CYCLES_PER_TICK);
+    }
+    printf("],\"run_from_ram\":%s}\n", HOT_PATH_IN_RAM ? "true" : "false");
+}
@@ -0,0 +1,47 @@
+/*
+ * File:   profile.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the control path kernel profiler. Define PROFILE
+ *           in config.h to time the kernels, otherwise the macros compile away.
+ *           The host build only simulates the core timer, its report shows the
+ *           path taken but no speed, make host-bench times the kernels on the
+ *           wall clock there.
+ * Revision history:
+ */
+
+#ifndef PROFILE_H
+#define	PROFILE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define PROFILE_REPORT_TICKS (1000)     // control ticks measured before the report is written
+
+/*
+ * profile_kernel - the kernels timed by the profiler
+ */
+enum profile_kernel
+{
+    prof_convert, prof_filter, prof_attitude, prof_pid, prof_translation, prof_pwm,
+    prof_imu,
+    PROFILE_KERNELS
+};
+
+#ifdef PROFILE
+#define PROFILE_START(k) unsigned int _prof_##k = hal_core_ticks()
+#define PROFILE_STOP(k) profile_record(k, hal_core_ticks() - _prof_##k)
+#else
+#define PROFILE_START(k)
+#define PROFILE_STOP(k)
+#endif
+
+FLASH_CALL void profile_record(enum profile_kernel kernel, unsigned int ticks);
+void profile_report(void);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* PROFILE_H */
+
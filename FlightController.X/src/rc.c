@@ -0,0 +1,298 @@
+/*
+ * File:   rc.c
+ * Author: Kevin Dederer
+ * Comments: rc receiver input. The receiver interrupt decodes the sticks and
+ *           publishes them through a sequence counted slot as soon as the
+ *           last needed channel arrives, the control loop copies the newest
+ *           setpoints at the start of each tick. The slot sequence is odd while
+ *           it is written, the loop retries a copy the interrupt cut into.
+ *           PPM uses input capture 1 (RD8) on timer 3, SBUS uses the inverted
+ *           rx of UART1 (RD2) with dma channel 2 filling whole frames.
+ * Revision history:
+ */
+
+#include "config.h"
+
+#define RC_DMA (DMA_CHANNEL2)
+#define RC_READ_RETRIES (4)
+
+// sbus channel range, 172 to 1811 with 992 at centre
+#define RC_SBUS_MIN (172)
+#define RC_SBUS_CENTRE (992)
+#define RC_SBUS_HALF (819.5)
+#define RC_SBUS_FLAGS (23)          // byte holding the frame lost and failsafe bits
+#define RC_SBUS_FAILSAFE (0x08)
+
+/*
+ * rc_data - receiver state
+ * @param seq - odd while the interrupt writes the slot
+ * @param slot - the newest setpoints
+ * @param ppm_last - the previous ppm capture
+ * @param ppm_channel - the next ppm channel, -1 until a sync gap is seen
+ * @param ppm_us - channel widths of the frame being decoded
+ * @param sbus - the sbus dma buffer
+ * @param sbus_sync - 0 while hunting for a frame header
+ * @param last_frames - frames count seen by the control loop
+ * @param stale - control ticks since the frames count last changed
+ */
+typedef struct
+{
+    volatile uint32_t seq;
+    volatile rc_setpoint slot;
+    uint16_t ppm_last;
+    int ppm_channel;
+    uint16_t ppm_us[RC_CHANNELS];
+    uint8_t sbus[RC_SBUS_FRAME];
+    int sbus_sync;
+    uint32_t last_frames;
+    int stale;
+} rc_data;
+
+PRIVATE rc_data rc;
+
+/*
+ * RC PUBLISH - writes new stick positions into the slot, interrupt only
+ * @param stick - roll, pitch, throttle and yaw, each -1..1
+ */
+PRIVATE void rc_publish(const float stick[RC_CHANNELS])
+{
+    rc.seq++;
+    __sync_synchronize();
+    rc.slot.roll = stick[0];
+    rc.slot.pitch = stick[1];
+    rc.slot.throttle = (stick[2] + 1) / 2;
+    rc.slot.yaw = stick[3];
+    rc.slot.frames++;
+    __sync_synchronize();
+    rc.seq++;
+}
+
+/*
+ * RC PPM EDGE - decodes one rising edge of the ppm stream, called from the
+ *              input capture interrupt
+ * @param capture - the timer 3 value at the edge
+ * @return 1 when the edge completed the sticks and they were published,
+ *              0 otherwise, -1 if the frame was dropped for a bad width.
+ */
+int rc_ppm_edge(uint16_t capture)
+{
+    unsigned int us = RC_PPM_US((uint16_t)(capture - rc.ppm_last));
+    float stick[RC_CHANNELS];
+    int i;
+
+    rc.ppm_last = capture;
+    if(us >= RC_PPM_SYNC_US)
+    {
+        rc.ppm_channel = 0;
+        return 0;
+    }
+    if(rc.ppm_channel < 0 || rc.ppm_channel >= RC_CHANNELS) return 0;
+    if(us < RC_PPM_MIN_US || us > RC_PPM_MAX_US)
+    {
+        rc.ppm_channel = -1;
+        return -1;
+    }
+
+    rc.ppm_us[rc.ppm_channel++] = us;
+    if(rc.ppm_channel < RC_CHANNELS) return 0;
+
+    // the remaining channels are not used, publish without waiting for the frame end
+    for(i = 0; i < RC_CHANNELS; i++)
+        stick[i] = (rc.ppm_us[i] - 1500) / 500.0;
+    rc_publish(stick);
+    return 1;
+}
+
+/*
+ * RC SBUS FRAME - decodes a complete sbus frame, called from the dma interrupt
+ * @param frame - the 25 frame bytes
+ * @return 1 if the sticks were published, 0 for a failsafe frame,
+ *              -1 if the frame is not aligned.
+ */
+int rc_sbus_frame(const uint8_t frame[RC_SBUS_FRAME])
+{
+    float stick[RC_CHANNELS];
+    unsigned int value;
+    int i, bit;
+
+    if(frame[0] != RC_SBUS_HEADER || frame[RC_SBUS_FRAME - 1] != RC_SBUS_FOOTER) return -1;
+    if(frame[RC_SBUS_FLAGS] & RC_SBUS_FAILSAFE) return 0;
+
+    // 16 channels of 11 bits packed lsb first from byte 1
+    for(i = 0; i < RC_CHANNELS; i++)
+    {
+        bit = i * 11;
+        value = frame[1 + bit / 8] | frame[2 + bit / 8] << 8 | frame[3 + bit / 8] << 16;
+        value = (value >> (bit % 8)) & 0x7ff;
+        stick[i] = ((int) value - RC_SBUS_CENTRE) / RC_SBUS_HALF;
+    }
+    rc_publish(stick);
+    return 1;
+}
+
+/*
+ * RC SBUS RECEIVED - handles a completed transfer into the frame buffer,
+ *              called from the dma interrupt. Out of sync the transfer was a
+ *              single byte, hunting for a header, then the rest of the frame
+ *              follows. A frame that does not decode but starts with a header
+ *              is followed by the next 24 bytes as its rest again, so a false
+ *              header in the channel data cannot hold the hunt, every retry
+ *              moves a byte along the stream until the frames line up.
+ * @param frame - the frame buffer the dma fills
+ * @param *count - receives the number of bytes of the next transfer
+ * @return the offset in the buffer the next transfer starts at.
+ */
+int rc_sbus_received(uint8_t frame[RC_SBUS_FRAME], int *count)
+{
+    if(rc.sbus_sync && rc_sbus_frame(frame) >= 0)
+    {
+        *count = RC_SBUS_FRAME;
+        return 0;
+    }
+    if(frame[0] == RC_SBUS_HEADER)
+    {
+        rc.sbus_sync = 1;
+        *count = RC_SBUS_FRAME - 1;
+        return 1;
+    }
+    rc.sbus_sync = 0;
+    *count = 1;
+    return 0;
+}
+
+#if defined(HAL_HOST)
+
+// no receiver on the host, the setpoints stay at their defaults
+
+#elif !defined(RC_SBUS)
+
+/*
+ * __ISR() InputCapture1Handler() - decodes the captured ppm edges
+ */
+void __ISR(_INPUT_CAPTURE_1_VECTOR, IPL5SOFT) InputCapture1Handler(void)
+{
+    while(mIC1CaptureReady())
+        rc_ppm_edge(mIC1ReadCapture());
+    mIC1ClearIntFlag();
+}
+
+#else
+
+/*
+ * RC SBUS ARM - starts the dma for the next transfer into the frame buffer
+ * @param offset - first byte of the buffer to fill
+ * @param count - bytes to transfer
+ */
+PRIVATE void rc_sbus_arm(int offset, int count)
+{
+    DmaChnSetTxfer(RC_DMA, (void *) &U1RXREG, &rc.sbus[offset], 1, count, 1);
+    DmaChnEnable(RC_DMA);
+}
+
+/*
+ * __ISR() DmaHandler2() - a frame, or a single byte while hunting for the
+ *              header, has arrived. Out of sync the dma is armed one byte at
+ *              a time until a header is seen, then for the rest of the frame.
+ */
+void __ISR(_DMA2_VECTOR, IPL5SOFT) DmaHandler2(void)
+{
+    int offset, count;
+
+    DmaChnClrEvFlags(RC_DMA, DMA_EV_ALL_EVNTS);
+    INTClearFlag(INT_SOURCE_DMA(RC_DMA));
+
+    offset = rc_sbus_received(rc.sbus, &count);
+    rc_sbus_arm(offset, count);
+}
+
+#endif /* RC_SBUS */
+
+/*
+ * RC OPEN - configures the receiver input
+ */
+void rc_open(void)
+{
+    rc.ppm_channel = -1;
+#if defined(HAL_HOST)
+#elif !defined(RC_SBUS)
+    OpenTimer3(T3_ON | T3_PS_1_8, 0xffff);
+    OpenCapture1(IC_ON | IC_CAP_16BIT | IC_TIMER3_SRC | IC_INT_1CAPTURE | IC_EVERY_RISE_EDGE);
+    ConfigIntCapture1(IC_INT_ON | IC_INT_PRIOR_5);
+#else
+    UARTConfigure(UART1, UART_ENABLE_PINS_TX_RX_ONLY);
+    UARTSetLineControl(UART1, UART_DATA_SIZE_8_BITS | UART_PARITY_EVEN | UART_STOP_BITS_2);
+    UARTSetDataRate(UART1, GetPeripheralClock(), 100000);
+    U1MODEbits.RXINV = 1;       // sbus is inverted
+    UARTEnable(UART1, UART_ENABLE_FLAGS(UART_PERIPHERAL | UART_RX));
+
+    DmaChnOpen(RC_DMA, DMA_CHN_PRI3, DMA_OPEN_DEFAULT);
+    DmaChnSetEventControl(RC_DMA, DMA_EV_START_IRQ_EN | DMA_EV_START_IRQ(_UART1_RX_IRQ));
+    DmaChnSetEvEnableFlags(RC_DMA, DMA_EV_BLOCK_DONE);
+    INTSetVectorPriority(INT_VECTOR_DMA(RC_DMA), INT_PRIORITY_LEVEL_5);
+    INTEnable(INT_SOURCE_DMA(RC_DMA), INT_ENABLED);
+    rc_sbus_arm(0, 1);
+#endif
+}
+
+/*
+ * RC READ - copies the newest setpoints, control loop only
+ * @param *setpoint - the setpoints, left unchanged on failure
+ * @return 0 on success, -1 if every copy was cut into by the interrupt.
+ */
+int rc_read(rc_setpoint *setpoint)
+{
+    rc_setpoint copy;
+    uint32_t seq;
+    int attempt;
+
+    for(attempt = 0; attempt < RC_READ_RETRIES; attempt++)
+    {
+        seq = rc.seq;
+        if(seq & 1) continue;
+        __sync_synchronize();
+        copy = *(rc_setpoint *) &rc.slot;
+        __sync_synchronize();
+        if(rc.seq == seq)
+        {
+            *setpoint = copy;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*
+ * RC UPDATE USER - moves the pilot setpoints into the user orientation, once
+ *              per control tick. Without frames for RC_TIMEOUT_TICKS the
+ *              craft is levelled and holds 1g.
+ * @param *user - the user orientation of the location data
+ */
+void rc_update_user(struct data *user)
+{
+    rc_setpoint setpoint;
+
+    if(rc_read(&setpoint) < 0) return;      // keep last tick's setpoints
+
+    if(setpoint.frames != rc.last_frames)
+    {
+        rc.last_frames = setpoint.frames;
+        rc.stale = 0;
+    }
+    else if(rc.stale < RC_TIMEOUT_TICKS)
+    {
+        rc.stale++;
+    }
+
+    if(rc.stale >= RC_TIMEOUT_TICKS || setpoint.frames == 0)
+    {
+        user->pitch = 0;
+        user->roll = 0;
+        user->yaw_rate = 0;
+        user->accel_z = 1.0;
+        return;
+    }
+    user->pitch = setpoint.pitch * params.rc_max_angle;
+    user->roll = setpoint.roll * params.rc_max_angle;
+    user->yaw_rate = setpoint.yaw * params.rc_max_yaw_rate;
+    user->accel_z = 1.0 + (setpoint.throttle - 0.5) * 2 * params.rc_max_accel;
+}
@@ -0,0 +1,61 @@
+/*
+ * File:   rc.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the rc receiver input. PPM is decoded from input
+ *           capture timestamps, SBUS (RC_SBUS) from uart frames moved by dma.
+ *           Both publish the newest setpoints from their interrupt.
+ * Revision history:
+ */
+
+#ifndef RC_H
+#define	RC_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define RC_CHANNELS (4)                 // roll, pitch, throttle, yaw in transmitter order
+// defaults of the stick scaling, tunable as params.rc_max_*
+#define RC_MAX_ANGLE (20.0 * RAD)       // pitch and roll setpoint at full stick
+#define RC_MAX_YAW_RATE (90.0 * RAD)    // yaw rate setpoint at full stick, rad/s
+#define RC_MAX_ACCEL (0.5)              // vertical acceleration at full throttle over hover, g
+#define RC_TIMEOUT_TICKS (LOOP_RATE_HZ / 10)    // control ticks without a frame before failsafe
+
+// ppm timing, timer 3 counts the pb clock / 8, 0.8us per count
+#define RC_PPM_US(counts) ((counts) * 8 / (GetPeripheralClock() / 1000000))
+#define RC_PPM_SYNC_US (3000)           // a gap this long starts a frame
+#define RC_PPM_MIN_US (800)             // shortest valid channel
+#define RC_PPM_MAX_US (2200)            // longest valid channel
+
+#define RC_SBUS_FRAME (25)              // bytes in an sbus frame
+#define RC_SBUS_HEADER (0x0F)
+#define RC_SBUS_FOOTER (0x00)
+
+/*
+ * rc_setpoint - the pilot input, sticks normalised to -1..1, throttle 0..1
+ * @param roll, pitch, yaw - stick positions
+ * @param throttle - throttle position
+ * @param frames - complete frames received, changes with every publish
+ */
+typedef struct
+{
+    float roll;
+    float pitch;
+    float yaw;
+    float throttle;
+    uint32_t frames;
+} rc_setpoint;
+
+void rc_open(void);
+int rc_ppm_edge(uint16_t capture);
+int rc_sbus_frame(const uint8_t frame[RC_SBUS_FRAME]);
+int rc_sbus_received(uint8_t frame[RC_SBUS_FRAME], int *count);
+int rc_read(rc_setpoint *setpoint);
+void rc_update_user(struct data *user);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* RC_H */
+
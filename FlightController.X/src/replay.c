@@ -0,0 +1,351 @@
+/*
+ * File:   replay.c
+ * Author: Kevin Dederer
+ * Comments: control input log, @see replay.h. Recording keeps the inputs of
+ *           the tick in replay_tick and queues it when the tick ends, the
+ *           idle job sends the queued frames as packets a few bytes per step.
+ *           Before the loop runs there is no slack, a full ring is sent at
+ *           once then. Replay maps the log and copies one frame at a time
+ *           into replay_tick, memory use is constant whatever the length of
+ *           the log. A host flight with RECORD and replay both write the same
+ *           line per tick with replay_emit, so the two outputs can be
+ *           compared with cmp, make host-replay-check does that. The target
+ *           does not write the lines, its console is far too slow for them.
+ * Revision history:
+ */
+
+#include <string.h>
+#include "config.h"
+
+#if defined(REPLAY) || defined(RECORD)
+
+#define REPLAY_MASK (REPLAY_RING - 1)
+#define REPLAY_SYNC0 ('R')
+#define REPLAY_SYNC1 ('P')
+#define REPLAY_PAYLOAD_AT (8)       // sync, type, length and index come first
+
+#ifdef RECORD
+// the packets of every tick must fit the uart with a tenth to spare
+typedef char replay_fits_uart[((sizeof(replay_frame) + REPLAY_PACKET_BYTES) * 10 * LOOP_RATE_HZ
+                              <= REPLAY_BAUD / 10 * 9) ? 1 : -1];
+typedef char replay_fits_length[(sizeof(replay_frame) <= 255) ? 1 : -1];
+#endif
+
+/*
+ * replay_data - position in the log
+ * @param header - the mapped log header
+ * @param frame - the next frame to replay
+ * @param frames - number of frames in the log
+ * @param index - frames read or begun, the one in replay_tick is index - 1
+ * @param vibe_steps, calib_steps - job steps counted when the frame being
+ *              recorded began
+ * @param start - the header to send, queued by replay_record_open()
+ * @param start_queued - the header is still to be sent
+ * @param ring - frames to send, the index of each in ring_index
+ * @param head, tail - frames queued and sent, the ring holds head - tail
+ * @param sent - bytes of the current packet sent
+ * @param sum1, sum2 - the fletcher-16 of the current packet so far
+ * @param dropped - frames lost to a full ring
+ */
+typedef struct
+{
+    const replay_header *header;
+    const uint8_t *frame;
+    uint32_t frames;
+    uint32_t index;
+    unsigned int vibe_steps;
+    unsigned int calib_steps;
+#ifdef RECORD
+    replay_header start;
+    int start_queued;
+    replay_frame ring[REPLAY_RING];
+    uint32_t ring_index[REPLAY_RING];
+    uint32_t head;
+    uint32_t tail;
+    unsigned int sent;
+    unsigned int sum1;
+    unsigned int sum2;
+    uint32_t dropped;
+#endif
+} replay_data;
+
+PRIVATE replay_data replay;
+replay_frame replay_tick;
+
+/*
+ * REPLAY PRINT HEADER - writes the column names of the replay_emit lines
+ */
+PRIVATE void replay_print_header(void)
+{
+#ifdef HAL_HOST
+    printf("frame,kind,filt_x,filt_y,filt_z,pitch,roll,pred_pitch,pred_roll,"
+           "out1,out2,out3,out4,speed1,speed2,speed3,speed4\n");
+#endif
+}
+
+#ifdef REPLAY
+/*
+ * REPLAY OPEN - maps the log, checks the header against the build and
+ *              restores the sensor configuration of the recorded flight
+ * @param *lsm330 - the sensor struct to receive the recorded zero offsets
+ * @return the number of frames in the log, -1 if no valid log is present.
+ */
+int replay_open(sensor_data *lsm330)
+{
+    size_t bytes;
+    const replay_header *h = hal_host_replay_map(&bytes);
+
+    if(h == NULL || bytes < sizeof(replay_header)) return -1;
+    if(h->magic != REPLAY_MAGIC || h->version != REPLAY_VERSION) return -1;
+    if(h->frame_bytes != sizeof(replay_frame) || h->loop_hz != LOOP_RATE_HZ ||
+       h->sample_hz != PIPE_SAMPLE_HZ)
+    {
+        fprintf(stderr, "replay: the log was recorded by a build with other rates or frames\n");
+        return -1;
+    }
+
+    replay.header = h;
+    replay.frame = (const uint8_t *) (h + 1);
+    replay.frames = (bytes - sizeof(replay_header)) / sizeof(replay_frame);
+    replay.index = 0;
+    lsm330->zero_x = h->zero_x;
+    lsm330->zero_y = h->zero_y;
+    lsm330->zero_z = h->zero_z;
+    lsm330->sensitivity = h->sensitivity;
+    replay_print_header();
+    return replay.frames;
+}
+
+/*
+ * REPLAY NEXT - moves the next recorded frame into replay_tick
+ * @return 0 if a frame was read, -1 at the end of the log.
+ */
+int replay_next(void)
+{
+    if(replay.index >= replay.frames) return -1;
+    memcpy(&replay_tick, replay.frame + (size_t) replay.index * sizeof(replay_frame), sizeof(replay_frame));
+    replay.index++;
+    return 0;
+}
+#endif /* REPLAY */
+
+#ifdef RECORD
+#ifdef HAL_HOST
+/*
+ * REPLAY SINK READY - the host file takes every byte
+ */
+PRIVATE int replay_sink_ready(void)
+{
+    return 1;
+}
+
+/*
+ * REPLAY SINK WRITE - appends a byte to the file, without FC_HOST_RECORD it
+ *              is dropped
+ * @param byte - the byte
+ */
+PRIVATE void replay_sink_write(uint8_t byte)
+{
+    hal_host_record_write(&byte, 1);
+}
+#else
+/*
+ * __ISR() ReplayUartHandler() - nothing is received while recording, bytes
+ *                      that arrive anyway are thrown away
+ */
+HAL_UART_ISR(ReplayUartHandler)
+{
+    while(hal_uart_rx_ready())
+        hal_uart_read();
+    hal_uart_clear();
+}
+
+PRIVATE int replay_sink_ready(void)
+{
+    return hal_uart_tx_ready();
+}
+
+PRIVATE void replay_sink_write(uint8_t byte)
+{
+    hal_uart_write(byte);
+}
+#endif /* HAL_HOST */
+
+/*
+ * REPLAY PACKET - the packet being sent
+ * @param **payload - receives its payload
+ * @param *type - receives its replay_packet_type
+ * @param *index - receives the frame index
+ * @return the payload length, 0 if nothing is queued.
+ */
+PRIVATE unsigned int replay_packet(const uint8_t **payload, uint8_t *type, uint32_t *index)
+{
+    unsigned int slot = replay.tail & REPLAY_MASK;
+
+    if(replay.start_queued)
+    {
+        *payload = (const uint8_t *) &replay.start;
+        *type = replay_packet_header;
+        *index = 0;
+        return sizeof(replay.start);
+    }
+    if(replay.head == replay.tail) return 0;
+    *payload = (const uint8_t *) &replay.ring[slot];
+    *type = replay_packet_frame;
+    *index = replay.ring_index[slot];
+    return sizeof(replay_frame);
+}
+
+/*
+ * REPLAY PACKET BYTE - the next byte of the packet being sent, the last one
+ *              takes the packet off the queue
+ * @param length - its payload length, @see replay_packet
+ * @param *payload, type, index - the packet
+ * @return the byte.
+ */
+PRIVATE uint8_t replay_packet_byte(unsigned int length, const uint8_t *payload, uint8_t type, uint32_t index)
+{
+    unsigned int at = replay.sent++;
+    uint8_t byte;
+
+    if(at == 0) return REPLAY_SYNC0;
+    if(at == 1) return REPLAY_SYNC1;
+    if(at < REPLAY_PAYLOAD_AT + length)
+    {
+        if(at == 2) replay.sum1 = replay.sum2 = 0;
+        byte = (at == 2) ? type : (at == 3) ? length :
+               (at < REPLAY_PAYLOAD_AT) ? index >> (8 * (at - 4)) : payload[at - REPLAY_PAYLOAD_AT];
+        replay.sum1 += byte;
+        if(replay.sum1 >= 255) replay.sum1 -= 255;
+        replay.sum2 += replay.sum1;
+        if(replay.sum2 >= 255) replay.sum2 -= 255;
+        return byte;
+    }
+    if(at == REPLAY_PAYLOAD_AT + length) return replay.sum1;
+
+    replay.sent = 0;
+    if(type == replay_packet_header) replay.start_queued = 0;
+    else replay.tail++;
+    return replay.sum2;
+}
+
+/*
+ * REPLAY RECORD STEP - sends up to REPLAY_STEP_BYTES of the queued packets,
+ *              what the uart takes without waiting. Called from the loop
+ *              slack, bounded by REPLAY_STEP_TICKS.
+ * @return 1 if a byte was sent, 0 otherwise.
+ */
+int replay_record_step(void)
+{
+    const uint8_t *payload;
+    uint8_t type;
+    uint32_t index;
+    unsigned int length;
+    int n;
+
+    for(n = 0; n < REPLAY_STEP_BYTES; n++)
+    {
+        length = replay_packet(&payload, &type, &index);
+        if(length == 0 || !replay_sink_ready()) break;
+        replay_sink_write(replay_packet_byte(length, payload, type, index));
+    }
+    return n > 0;
+}
+
+/*
+ * REPLAY RECORD OPEN - starts the log with the sensor configuration imu_open()
+ *              found, the header is the first packet sent
+ * @param *lsm330 - the zero offsets and sensitivity
+ * @return 0
+ */
+int replay_record_open(const sensor_data *lsm330)
+{
+    replay_header h = { REPLAY_MAGIC, REPLAY_VERSION, sizeof(replay_frame), LOOP_RATE_HZ,
+                        PIPE_SAMPLE_HZ, lsm330->zero_x, lsm330->zero_y, lsm330->zero_z,
+                        lsm330->sensitivity };
+
+#ifndef HAL_HOST
+    hal_uart_open(REPLAY_BAUD);
+#endif
+    replay.start = h;
+    replay.start_queued = 1;
+    replay_print_header();
+    return 0;
+}
+
+/*
+ * REPLAY RECORD BEGIN - starts the frame of a tick, before the control path
+ *              runs and changes the block in place. The REPLAY_INPUTs of
+ *              the tick fill in the rest.
+ * @param kind - what the loop does with the tick, a replay_kind
+ * @param *block - the block read, NULL for a hold
+ * @param *user - the pilot setpoint
+ */
+void replay_record_begin(int kind, const sensor_block *block, const struct data *user)
+{
+    memset(&replay_tick, 0, sizeof(replay_tick));
+    replay_tick.kind = kind;
+    replay_tick.user = *user;
+    replay_tick.set = params;
+    if(block != NULL) replay_tick.block = *block;
+    replay.index++;
+    replay.vibe_steps = idle_get_status()->job[job_vibe].steps;
+    replay.calib_steps = idle_get_status()->job[job_calib].steps;
+}
+
+/*
+ * REPLAY RECORD END - queues the frame of the tick, after the slack so the
+ *              analyser and offset tracking steps it ran are counted. A
+ *              frame that finds the ring full in flight is lost, the log can
+ *              only be replayed up to it.
+ */
+void replay_record_end(void)
+{
+    unsigned int slot = replay.head & REPLAY_MASK;
+
+    replay_tick.vibe_steps = idle_get_status()->job[job_vibe].steps - replay.vibe_steps;
+    replay_tick.calib_steps = idle_get_status()->job[job_calib].steps - replay.calib_steps;
+    if(replay_tick.kind == replay_prime)
+    {
+        while(replay.head - replay.tail >= REPLAY_RING)
+            replay_record_step();
+    }
+    else if(replay.head - replay.tail >= REPLAY_RING)
+    {
+        if(replay.dropped++ == 0) evlog_write(ev_replay_dropped, replay.index - 1);
+        return;
+    }
+    replay.ring[slot] = replay_tick;
+    replay.ring_index[slot] = replay.index - 1;
+    replay.head++;
+}
+#endif /* RECORD */
+
+/*
+ * REPLAY EMIT - writes one line with the output of every stage for the tick
+ *              that was just processed. Floats are written with 9 significant
+ *              digits so they round trip exactly.
+ * @param *filtered - the sensor struct after the zero offset and filters.
+ * @param *location - the attitude used by the pid.
+ * @param *engine - the pid output and motor commands.
+ */
+void replay_emit(const sensor_data *filtered, const location_data *location,
+                 const engine_data *engine)
+{
+#ifdef HAL_HOST
+    printf("%lu,%d,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,"
+           "%.9g,%.9g,%.9g,%.9g,%d,%d,%d,%d\n",
+           (unsigned long) replay.index - 1, replay_tick.kind,
+           filtered->accel_x, filtered->accel_y, filtered->accel_z,
+           location->actual.pitch, location->actual.roll,
+           location->predicted.pitch, location->predicted.roll,
+           engine->e1.pid_out, engine->e2.pid_out, engine->e3.pid_out, engine->e4.pid_out,
+           engine->e1.speed, engine->e2.speed, engine->e3.speed, engine->e4.speed);
+#else
+    (void) filtered;
+    (void) location;
+    (void) engine;
+#endif
+}
+
+#endif /* REPLAY || RECORD */
@@ -0,0 +1,170 @@
+/*
+ * File:   replay.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the control input log. Define RECORD to have the
+ *           flight loop write every input the control path reads, tick by
+ *           tick, and REPLAY to build firmware that runs such a log through
+ *           the same calls instead of flying.
+ *
+ *           RECORD builds for the target and the host. The frames are queued
+ *           in a ram ring and sent by an idle job as packets, on the target
+ *           out of UART1 at REPLAY_BAUD, on the host into the file named by
+ *           FC_HOST_RECORD. tools/replay_capture.py turns the packets into a
+ *           log, from the serial port or the file, and stops it at the first
+ *           frame lost to a full ring. REPLAY is a host build, the log is
+ *           memory mapped with FC_HOST_REPLAY, @see hal_host.h, so a flight
+ *           of the board replays on a PC. A log is about 50MB per hour at
+ *           100Hz.
+ *
+ *           packet  'R', 'P', type, length, index:u32, payload[length], sum:u16
+ *                   type 0 is the replay_header, 1 a replay_frame and index
+ *                   counts the frames from 0. sum is the fletcher-16 of type
+ *                   to the end of the payload, values are little endian.
+ *
+ *           The control path reads its inputs from other modules through
+ *           REPLAY_INPUT(field, value): in flight it is the value, with
+ *           RECORD the value is also kept in the frame of the tick, with
+ *           REPLAY it is the recorded value and the expression is not run.
+ *
+ *           What replays bit exact on another machine or C library: the
+ *           integer acquisition, the zero offset, notch, fir and decimation
+ *           on counts, the CORDIC angles and the fft. The float arithmetic
+ *           of the g conversion, prediction and pid is exact as well, the
+ *           basic operations, sqrtf and lroundf round the same on the
+ *           target's soft float and an SSE host, as long as double is 64 bit
+ *           in both builds. Two stages go through libm and only match
+ *           between equal libraries: the thrust curve pow() in translation()
+ *           and the sinf() and cosf() of the notch coefficients. The
+ *           coefficients are rounded to integers, so they only differ where
+ *           a last bit error crosses a rounding boundary, but then the notch
+ *           output and everything after it differs. make host-replay-check
+ *           compares a host recording with its replay, the same library.
+ * Revision history:
+ */
+
+#ifndef REPLAY_H
+#define	REPLAY_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define REPLAY_MAGIC (0x594c5052)   // "RPLY" little endian
+#define REPLAY_VERSION (3)          // 2: a frame holds every input of a tick, 3: and the offset tracking steps
+#define REPLAY_RING (8)             // frames queued for sending, must be a power of 2
+#define REPLAY_BAUD (1250000)       // uart rate of the target, pb / 8 exactly
+#define REPLAY_PACKET_BYTES (10)    // sync, type, length, index and sum around a payload
+#define REPLAY_STEP_BYTES (8)       // bytes one replay_record_step() sends at most
+#define REPLAY_STEP_TICKS (2000)    // worst case core ticks of a step (50us)
+
+#if defined(REPLAY) && !defined(HAL_HOST)
+#error "REPLAY is a host build, @see nbproject/Makefile-host.mk"
+#endif
+#if defined(REPLAY) && defined(RECORD)
+#error "define one of REPLAY and RECORD"
+#endif
+#if defined(RECORD) && !defined(HAL_HOST) && (defined(PARAMS_LINK) || defined(RC_SBUS))
+#error "RECORD sends the log out of UART1, build without PARAMS_LINK and RC_SBUS"
+#endif
+#if (REPLAY_RING & (REPLAY_RING - 1)) != 0
+#error "REPLAY_RING must be a power of 2"
+#endif
+
+/*
+ * replay_packet_type - what a packet of the recorder carries
+ */
+enum replay_packet_type
+{
+    replay_packet_header, replay_packet_frame
+};
+
+/*
+ * replay_kind - what the flight loop did with a frame
+ * replay_prime - the block went into pipe_prime() before the loop
+ * replay_sample - the block went through process_sample()
+ * replay_hold - no block, the pid ran on the last attitude
+ */
+enum replay_kind
+{
+    replay_prime, replay_sample, replay_hold
+};
+
+/*
+ * replay_header - start of a log, followed by replay_frames to the end of
+ *              the file. A log only replays on a build with the same frame
+ *              size and rates, a target log on a host build of the same
+ *              configuration.
+ * @param magic - REPLAY_MAGIC
+ * @param version - REPLAY_VERSION
+ * @param frame_bytes - sizeof(replay_frame) of the recording build
+ * @param loop_hz - LOOP_RATE_HZ of the recording build
+ * @param sample_hz - PIPE_SAMPLE_HZ of the recording build
+ * @param zero_x, zero_y, zero_z - the zero offsets imu_open() found, in
+ *              counts << LSM330_ZERO_SHIFT
+ * @param sensitivity - g per count
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t frame_bytes;
+    uint32_t loop_hz;
+    uint32_t sample_hz;
+    int32_t zero_x;
+    int32_t zero_y;
+    int32_t zero_z;
+    float sensitivity;
+} replay_header;
+
+/*
+ * replay_frame - the inputs of one control tick, as the control path read them
+ * @param kind - the replay_kind
+ * @param mode - overload_mode() the filter choice was made with
+ * @param vibe_steps - analyser steps run in the slack after the tick
+ * @param calib_steps - offset tracking steps run in the slack after the tick
+ * @param user - the pilot setpoint after rc_update_user()
+ * @param now - timing_now() read by the control path, for the transfer
+ *              latency of a sample or as the stamp of a hold
+ * @param latch_wait_s - motor_latch_wait_s() read by predict
+ * @param thrust_scale - power_thrust_scale() read by the pid
+ * @param set - the live parameters after params_tick()
+ * @param block - the block imu_read() returned, raw counts and timestamp
+ */
+typedef struct
+{
+    uint8_t kind;
+    uint8_t mode;
+    uint16_t vibe_steps;
+    uint16_t calib_steps;
+    struct data user;
+    uint32_t now;
+    float latch_wait_s;
+    float thrust_scale;
+    params_set set;
+    sensor_block block;
+} replay_frame;
+
+#if defined(RECORD)
+#define REPLAY_INPUT(field, value) (replay_tick.field = (value))
+#elif defined(REPLAY)
+#define REPLAY_INPUT(field, value) (replay_tick.field)
+#else
+#define REPLAY_INPUT(field, value) (value)
+#endif
+
+extern replay_frame replay_tick;
+
+int replay_open(sensor_data *lsm330);
+int replay_next(void);
+int replay_record_open(const sensor_data *lsm330);
+void replay_record_begin(int kind, const sensor_block *block, const struct data *user);
+void replay_record_end(void);
+int replay_record_step(void);
+void replay_emit(const sensor_data *filtered, const location_data *location,
+                 const engine_data *engine);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* REPLAY_H */
@@ -0,0 +1,214 @@
+/*
+ * File:   spi.c
+ * Author: Kevin Dederer
+ * Comments: SPI transport for the lsm330, replaces the I2C2 register access
+ *           when LSM330_USE_SPI is defined. The sensor runs in 4 wire mode
+ *           (CPOL 1, CPHA 1) with a chip select per device. Single register
+ *           accesses are polled, burst reads are moved by two dma channels so
+ *           the cpu only starts the transfer and checks that it finished.
+ * Revision history:
+ */
+
+#include "config.h"
+
+#ifdef LSM330_USE_SPI
+
+// first byte of a transfer. The gyro takes a 6 bit register address and the
+// increment flag, the accelerometer a 7 bit address and increments by the
+// ADD_INC bit configure_lsm330tr() sets in its control register
+#define SPI_READ (0x80)
+#define SPI_INCREMENT (0x40)    // gyro only
+#define SPI_I2C_INCREMENT (0x80)   // the i2c auto increment flag callers set in the register address
+
+/*
+ * spi_data - transport state
+ * @param open - the channel and dma are configured
+ * @param cs_open - the chip select pins set up so far
+ * @param tx, rx - dma buffers, command byte followed by the burst
+ * @param status - error counters
+ */
+typedef struct
+{
+    int open;
+    unsigned int cs_open;
+    uint8_t tx[SPI_BURST + 1];
+    uint8_t rx[SPI_BURST + 1];
+    spi_status status;
+} spi_data;
+
+PRIVATE spi_data spi;
+
+/*
+ * SPI FAIL - records an error
+ * @param error - the error code
+ * @return the error code, so it can be returned directly.
+ */
+PRIVATE int spi_fail(enum spi_error error)
+{
+    spi.status.last_error = error;
+    spi.status.errors[-error]++;
+    return error;
+}
+
+/*
+ * SPI CS - the chip select of a device, the pin is made an idle high output
+ *              the first time the device is used
+ * @param *bus - the device, @see lsm330_bus
+ * @return the port G bit.
+ */
+PRIVATE unsigned int spi_cs(const lsm330_bus *bus)
+{
+    if(!(spi.cs_open & bus->cs))
+    {
+        hal_spi_cs_open(bus->cs);
+        spi.cs_open |= bus->cs;
+    }
+    return bus->cs;
+}
+
+/*
+ * SPI IS GYRO - the device is the gyro of its package
+ * @param *bus - the device, @see lsm330_bus
+ */
+PRIVATE int spi_is_gyro(const lsm330_bus *bus)
+{
+    return bus->addr == LSM330_DEV_GYRO || bus->addr == LSM330_DEV_GYRO_ALT;
+}
+
+/*
+ * SPI OPEN - configures SPI2 and the two dma channels, once
+ */
+PRIVATE void spi_open(void)
+{
+    if(spi.open) return;
+    hal_spi_open(SPI_CLOCK_FREQ);
+    spi.open = 1;
+}
+
+/*
+ * SPI TRANSFER BYTE - polled full duplex transfer of one byte
+ * @param out - the byte to send
+ * @param *in - the byte received
+ * @param start - core timer value when the transfer started
+ * @return 0 or spi_timeout.
+ */
+PRIVATE int spi_transfer_byte(uint8_t out, uint8_t *in, unsigned int start)
+{
+    hal_spi_put(out);
+    while(!hal_spi_rx_ready())
+        if(hal_core_ticks() - start > SPI_TIMEOUT_US * CORE_TICKS_PER_US)
+            return spi_fail(spi_timeout);
+    *in = hal_spi_get();
+    return 0;
+}
+
+/*
+ * SPI END - releases the chip select and records the transfer time
+ * @param cs - the chip select bit
+ * @param start - core timer value when the transfer started
+ * @param rc - the result of the transfer
+ * @return rc
+ */
+PRIVATE int spi_end(unsigned int cs, unsigned int start, int rc)
+{
+    unsigned int us = (hal_core_ticks() - start) / CORE_TICKS_PER_US;
+
+    hal_spi_deselect(cs);
+    if(us > spi.status.max_us) spi.status.max_us = us;
+    return rc;
+}
+
+/*
+ * LSM330 READ REG - reads one register
+ * @param *bus - the device, @see lsm330_bus
+ * @param reg - the register address
+ * @param data - the byte to be read
+ * @return 0 or a negative spi_error
+ */
+int lsm330_read_reg(const lsm330_bus *bus, uint8_t reg, uint8_t *data)
+{
+    unsigned int cs = spi_cs(bus), start = hal_core_ticks();
+    uint8_t dummy;
+    int rc;
+
+    spi_open();
+    hal_spi_select(cs);
+    rc = spi_transfer_byte(SPI_READ | (reg & ~SPI_I2C_INCREMENT), &dummy, start);
+    if(rc == 0) rc = spi_transfer_byte(0, data, start);
+    return spi_end(cs, start, rc);
+}
+
+/*
+ * LSM330 WRITE REG - writes one register
+ * @param *bus - the device, @see lsm330_bus
+ * @param reg - the register address
+ * @param data - the byte to be written
+ * @return 0 or a negative spi_error
+ */
+int lsm330_write_reg(const lsm330_bus *bus, uint8_t reg, uint8_t data)
+{
+    unsigned int cs = spi_cs(bus), start = hal_core_ticks();
+    uint8_t dummy;
+    int rc;
+
+    spi_open();
+    hal_spi_select(cs);
+    rc = spi_transfer_byte(reg & ~SPI_I2C_INCREMENT, &dummy, start);
+    if(rc == 0) rc = spi_transfer_byte(data, &dummy, start);
+    return spi_end(cs, start, rc);
+}
+
+/*
+ * LSM330 READ MULTIPLE REG - reads up to SPI_BURST consecutive registers by dma
+ * @param *bus - the device, @see lsm330_bus
+ * @param reg - the first register address, the i2c auto increment flag is
+ *              translated to the spi one of the gyro
+ * @param data - pointer to an array to store the read bytes
+ * @param len - the number of bytes to read, at most SPI_BURST
+ * @return 0 or a negative spi_error
+ */
+int lsm330_read_multiple_reg(const lsm330_bus *bus, uint8_t reg, UINT8 *data, int len)
+{
+    unsigned int cs = spi_cs(bus), start = hal_core_ticks();
+    int i, rc = 0;
+
+    spi_open();
+    spi.tx[0] = SPI_READ | (reg & ~SPI_I2C_INCREMENT);
+    if(spi_is_gyro(bus)) spi.tx[0] |= SPI_INCREMENT;
+
+    hal_spi_select(cs);
+    hal_spi_burst(spi.tx, spi.rx, len + 1);
+    while(!hal_spi_burst_done())
+    {
+        if(hal_core_ticks() - start > SPI_TIMEOUT_US * CORE_TICKS_PER_US)
+        {
+            hal_spi_burst_abort();
+            rc = spi_fail(spi_timeout);
+            break;
+        }
+    }
+
+    if(rc == 0)
+    {
+        for(i = 0; i < len; i++)
+            data[i] = spi.rx[i + 1];
+        spi.status.bursts++;
+    }
+    return spi_end(cs, start, rc);
+}
+
+#endif /* LSM330_USE_SPI */
+
+/*
+ * SPI GET STATUS - read only access to the transport counters
+ * @return pointer to the transport status.
+ */
+const spi_status *spi_get_status(void)
+{
+#ifdef LSM330_USE_SPI
+    return &spi.status;
+#else
+    static const spi_status unused;
+    return &unused;
+#endif
+}
@@ -0,0 +1,53 @@
+/*
+ * File:   spi.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the SPI transport of the lsm330. Only built into
+ *           the register access functions with LSM330_USE_SPI.
+ * Revision history:
+ */
+
+#ifndef SPI_H
+#define	SPI_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define SPI_CLOCK_FREQ (5000000)    // the lsm330 takes 10mhz, spi2 is limited to half the pb clock
+#define SPI_BURST (6 * PIPE_BLOCK)  // bytes in the longest dma burst read, a block of accelerometer samples
+#define SPI_TIMEOUT_US (38 + 2 * SPI_BURST)    // longest wait for one transfer, a 6 byte burst takes about 12us
+
+/*
+ * spi_error - error codes returned by the transport, always negative
+ * spi_timeout - a transfer did not finish in time
+ */
+enum spi_error
+{
+    spi_ok = 0,
+    spi_timeout = -1,
+    SPI_ERRORS = 2
+};
+
+/*
+ * spi_status - counters of the transport
+ * @param last_error - the most recent error code
+ * @param errors - count of each error code, indexed by -code
+ * @param bursts - completed dma burst reads
+ * @param max_us - the longest transfer seen, in microseconds
+ */
+typedef struct
+{
+    enum spi_error last_error;
+    unsigned int errors[SPI_ERRORS];
+    unsigned int bursts;
+    unsigned int max_us;
+} spi_status;
+
+const spi_status *spi_get_status(void);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* SPI_H */
+
@@ -0,0 +1,104 @@
+/*
+ * File:   stack.c
+ * Author: Kevin Dederer
+ * Comments: stack watermark, @see stack.h. The paint goes from the limit up
+ *           to STACK_GUARD below the frame of stack_paint(), the count goes
+ *           up from the limit to the first word that is not paint. A word the
+ *           stack wrote with the paint value by chance makes the mark read a
+ *           little low.
+ * Revision history:
+ */
+
+#include "config.h"
+
+/*
+ * stack_data - watermark state
+ * @param bottom - the lowest word of the stack, the limit
+ * @param top - the word above the highest stack word
+ * @param status - the last measurement
+ */
+typedef struct
+{
+    uint32_t *bottom;
+    uint32_t *top;
+    stack_status status;
+} stack_data;
+
+PRIVATE stack_data stack;
+
+#if defined(HAL_HOST)
+
+// the host stack belongs to the C runtime, the HAL_HOST_STACK_BYTES below the
+// painting frame are painted instead, so the mark is the depth the firmware
+// reaches below main(). The sanitizers must not check the paint or the count,
+// they look at stack that is not in any frame.
+#define STACK_UNCHECKED __attribute__((no_sanitize_address))
+
+#else
+
+extern uint32_t _splim[];       // stack limit, from the linker script
+extern uint32_t _stack[];       // initial stack pointer, the top
+#define STACK_UNCHECKED
+
+#endif /* HAL_HOST */
+
+/*
+ * STACK PAINT - fills the unused stack with STACK_PAINT, called first thing
+ *              in main() while the stack is at its shallowest
+ */
+STACK_UNCHECKED void stack_paint(void)
+{
+    uint32_t *frame = (uint32_t *) __builtin_frame_address(0);
+    volatile uint32_t *p, *end = frame - STACK_GUARD / 4;
+
+#if defined(HAL_HOST)
+    stack.top = frame;
+    stack.bottom = frame - HAL_HOST_STACK_BYTES / 4;
+#else
+    stack.bottom = _splim;
+    stack.top = _stack;
+#endif
+    stack.status.size = (stack.top - stack.bottom) * 4;
+    // volatile so the loop is not made a memset call, whose frame is below this one
+    for(p = stack.bottom; p < end; p++)
+        *p = STACK_PAINT;
+}
+
+/*
+ * STACK HIGH WATER - measures the deepest stack use since stack_paint().
+ *              Scans the untouched part of the stack, keep it out of the
+ *              control path.
+ * @return the bytes used at most, 0 if nothing was painted.
+ */
+STACK_UNCHECKED unsigned int stack_high_water(void)
+{
+    volatile uint32_t *p = stack.bottom;
+
+    if(p == NULL) return 0;
+    while(p < stack.top && *p == STACK_PAINT)
+        p++;
+    stack.status.used = (stack.top - p) * 4;
+    stack.status.free = stack.status.size - stack.status.used;
+    return stack.status.used;
+}
+
+/*
+ * STACK GET STATUS - read only access to the last measurement
+ * @return the watermark.
+ */
+const stack_status *stack_get_status(void)
+{
+    return &stack.status;
+}
+
+/*
+ * STACK REPORT - measures the watermark and prints it as one JSON line
+ */
+void stack_report(void)
+{
+    const stack_status *s = &stack.status;
+
+    stack_high_water();
+    printf("{\"stack\":{\"size\":%u,\"used\":%u,\"free\":%u,\"low\":%s}}\n", s->size, s->used, s->free,
+           (s->size && s->free < STACK_WARN_BYTES) ? "true" : "false");
+}
@@ -0,0 +1,53 @@
+/*
+ * File:   stack.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the stack watermark. main() paints the free stack
+ *           with STACK_PAINT before anything else runs, stack_high_water()
+ *           later counts how much of the paint is gone. The stack runs down
+ *           from _stack to _splim of the XC32 linker script, the interrupts
+ *           that do not use a shadow register set push their context on it
+ *           too, so the mark includes the deepest nesting seen so far.
+ *           tools/map_report.py shows the space the linker left for it. On
+ *           the host HAL_HOST_STACK_BYTES below the frame of stack_paint()
+ *           stand in for the linker reserve.
+ * Revision history:
+ */
+
+#ifndef STACK_H
+#define	STACK_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define STACK_PAINT (0x5A5A5A5Au)   // fill of the unused stack
+#if defined(HAL_HOST)
+#define STACK_GUARD (256)           // bytes below the painting frame left alone, the x86-64 red zone is 128
+#else
+#define STACK_GUARD (64)            // bytes below the painting frame left alone, for its calls
+#endif
+#define STACK_WARN_BYTES (512)      // report a warning with less stack than this left
+
+/*
+ * stack_status - the watermark
+ * @param size - bytes between the stack limit and the top
+ * @param used - the deepest use seen, bytes
+ * @param free - size - used
+ */
+typedef struct
+{
+    unsigned int size;
+    unsigned int used;
+    unsigned int free;
+} stack_status;
+
+void stack_paint(void);
+unsigned int stack_high_water(void);
+const stack_status *stack_get_status(void);
+void stack_report(void);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* STACK_H */
@@ -0,0 +1,144 @@
+/*
+ * File:   timing.c
+ * Author: Kevin Dederer
+ * Comments: sample clock and interval tracking, @see timing.h. Timestamps are
+ *           32 bit core ticks and wrap after 107s, intervals are taken as
+ *           unsigned differences so the wrap does not matter.
+ * Revision history:
+ */
+
+#include "config.h"
+
+/*
+ * timing_data - the clock
+ * @param base - core ticks of all finished control ticks
+ * @param ticks - control ticks started, read by the pwm interrupt
+ * @param sample - interval between sensor samples
+ */
+typedef struct
+{
+    uint32_t base;
+    volatile uint32_t ticks;
+    timing_interval sample;
+} timing_data;
+
+PRIVATE timing_data timing;
+
+/*
+ * TIMING TICK - restarts the core timer for a new control tick, keeping the
+ *              ticks of the one that ended in the clock. The count is rewound
+ *              by what was read instead of zeroed, so the ticks that pass
+ *              meanwhile stay in it and the clock does not drift. Interrupts
+ *              are off for the three steps, the pwm interrupt would
+ *              otherwise see a timestamp a whole tick off or the new core
+ *              count with the old tick count.
+ */
+void timing_tick(void)
+{
+    unsigned int state = hal_interrupts_disable();
+    unsigned int elapsed = hal_core_ticks();
+
+    timing.base += elapsed;
+    hal_core_rewind(elapsed);
+    timing.ticks++;
+    hal_interrupts_restore(state);
+}
+
+/*
+ * TIMING TICKS - the control tick count, with hal_core_ticks() the position
+ *              in the control tick
+ * @return the control ticks started since boot.
+ */
+HOT_PATH uint32_t timing_ticks(void)
+{
+    return timing.ticks;
+}
+
+/*
+ * TIMING NOW - the current timestamp
+ * @return core ticks since boot, modulo 2^32.
+ */
+HOT_PATH uint32_t timing_now(void)
+{
+    return timing.base + hal_core_ticks();
+}
+
+/*
+ * TIMING INTERVAL DT - measures the time since the previous event
+ * @param *interval - the interval being measured
+ * @param stamp - timestamp of the new event
+ * @return the interval in seconds, DT for the first event, clamped to
+ *              TIMING_DT_MIN..TIMING_DT_MAX.
+ */
+HOT_PATH float timing_interval_dt(timing_interval *interval, uint32_t stamp)
+{
+    timing_stats *stats = &interval->stats;
+    uint32_t ticks = stamp - interval->last;
+    float us, delta, dt;
+    int primed = interval->primed;
+
+    interval->last = stamp;
+    interval->primed = 1;
+    if(!primed) return DT;
+
+    us = (float) ticks / CORE_TICKS_PER_US;
+    dt = us * 1e-6;
+    stats->count++;
+    if(stats->count == 1 || us < stats->min_us) stats->min_us = us;
+    if(us > stats->max_us) stats->max_us = us;
+    delta = us - stats->mean_us;
+    stats->mean_us += delta / stats->count;
+    stats->m2 += delta * (us - stats->mean_us);
+    if(dt > TIMING_LATE_DT) stats->late++;
+
+    if(dt < TIMING_DT_MIN || dt > TIMING_DT_MAX)
+    {
+        stats->clamped++;
+        evlog_write(ev_timing_clamped, (uint32_t) us);
+        dt = (dt < TIMING_DT_MIN) ? TIMING_DT_MIN : TIMING_DT_MAX;
+    }
+    return dt;
+}
+
+/*
+ * TIMING SAMPLE - records the timestamp of a new sensor sample
+ * @param stamp - acquisition time of the sample
+ * @return the interval since the previous sample in seconds, clamped.
+ */
+float timing_sample(uint32_t stamp)
+{
+    return timing_interval_dt(&timing.sample, stamp);
+}
+
+/*
+ * TIMING GET STATS - read only access to the sample interval statistics
+ * @return the statistics.
+ */
+const timing_stats *timing_get_stats(void)
+{
+    return &timing.sample.stats;
+}
+
+/*
+ * TIMING JITTER US - the standard deviation of the measured intervals
+ * @param *stats - the statistics
+ * @return the deviation in us, 0 with fewer than two intervals.
+ */
+float timing_jitter_us(const timing_stats *stats)
+{
+    if(stats->count < 2) return 0;
+    return sqrtf(stats->m2 / (stats->count - 1));
+}
+
+/*
+ * TIMING REPORT - prints the sample interval statistics as one JSON line
+ */
+void timing_report(void)
+{
+    const timing_stats *stats = &timing.sample.stats;
+
+    printf("{\"sample_dt\":{\"count\":%u,\"nominal_us\":%.1f,\"mean_us\":%.1f,\"jitter_us\":%.1f,"
+           "\"min_us\":%.1f,\"max_us\":%.1f,\"late\":%u,\"clamped\":%u}}\n",
+           stats->count, DT * 1e6, stats->mean_us, timing_jitter_us(stats),
+           stats->min_us, stats->max_us, stats->late, stats->clamped);
+}
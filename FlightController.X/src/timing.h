@@ -0,0 +1,70 @@
+/*
+ * File:   timing.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the sample clock. The control loop restarts the
+ *           core timer every tick, timing_now() adds the ticks already gone so
+ *           samples get a timestamp that keeps counting across ticks. The
+ *           interval between two timestamps is measured, clamped and tracked
+ *           for the controller instead of assuming a fixed DT.
+ * Revision history:
+ */
+
+#ifndef TIMING_H
+#define	TIMING_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define TIMING_DT_MIN (DT / 4)      // shortest interval the controller is given, s
+#define TIMING_DT_MAX (DT * 4)      // longest interval the controller is given, s
+#define TIMING_LATE_DT (DT * 1.5)   // intervals longer than this are counted late, s
+
+/*
+ * timing_stats - interval statistics since boot
+ * @param count - intervals measured
+ * @param late - intervals longer than TIMING_LATE_DT
+ * @param clamped - intervals outside TIMING_DT_MIN..TIMING_DT_MAX
+ * @param min_us, max_us - the shortest and longest interval measured
+ * @param mean_us - running mean of the measured intervals
+ * @param m2 - running sum of squared differences from the mean, us squared
+ */
+typedef struct
+{
+    unsigned int count;
+    unsigned int late;
+    unsigned int clamped;
+    float min_us;
+    float max_us;
+    float mean_us;
+    float m2;
+} timing_stats;
+
+/*
+ * timing_interval - the time between successive events of one kind
+ * @param last - timestamp of the previous event
+ * @param primed - last is valid
+ * @param stats - statistics of the measured intervals
+ */
+typedef struct
+{
+    uint32_t last;
+    int primed;
+    timing_stats stats;
+} timing_interval;
+
+void timing_tick(void);
+HOT_PATH uint32_t timing_ticks(void);
+HOT_PATH uint32_t timing_now(void);
+HOT_PATH float timing_interval_dt(timing_interval *interval, uint32_t stamp);
+float timing_sample(uint32_t stamp);
+const timing_stats *timing_get_stats(void);
+float timing_jitter_us(const timing_stats *stats);
+void timing_report(void);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* TIMING_H */
+
@@ -0,0 +1,170 @@
+/*
+ * File:   trig.c
+ * Author: Kevin Dederer
+ * Comments: fixed point atan2, asin and sincos by cordic, using only shifts,
+ *           adds and a 24 entry table, the loops have no branches. Largest
+ *           errors against libm double over the full input range:
+ *               trig_atan2      1.4e-7 rad
+ *               trig_atan2f     8.8e-7 rad for components from 1mg to 8g
+ *               trig_asin       3.1e-5 rad, limited by the Q15 input
+ *               trig_sincos     3.1e-5, one Q15 lsb
+ * Revision history:
+ */
+
+#include "config.h"
+
+#define TRIG_ONE_Q30 (1L << 30)
+#define TRIG_GAIN_Q30 (652032874)   // 1 / cordic gain after 24 iterations, 0.60725 in Q30
+#define TRIG_TOP_BIT (28)           // vectoring inputs are normalised to this bit for headroom
+
+// atan(2^-i) as binary angles
+PRIVATE const int32_t trig_atan_table[TRIG_ITERATIONS] = {
+     536870912,  316933406,  167458907,   85004756,
+      42667331,   21354465,   10679838,    5340245,
+       2670163,    1335087,     667544,     333772,
+        166886,      83443,      41722,      20861,
+         10430,       5215,       2608,       1304,
+           652,        326,        163,         81
+};
+
+/*
+ * TRIG ATAN2 - the angle of the vector (x, y)
+ * @param y - the y component, any scale
+ * @param x - the x component, same scale as y
+ * @return the angle from -pi to pi as a binary angle, 0 for (0, 0).
+ */
+HOT_PATH int32_t trig_atan2(int32_t y, int32_t x)
+{
+    uint32_t m = (x < 0 ? -(uint32_t) x : (uint32_t) x) | (y < 0 ? -(uint32_t) y : (uint32_t) y);
+    uint32_t z = 0;
+    int32_t t, d;
+    int i, shift;
+
+    if(m == 0) return 0;
+
+    // bring the larger component to bit 28, the cordic gain needs the headroom
+    shift = (31 - __builtin_clz(m)) - TRIG_TOP_BIT;
+    if(shift > 0)
+    {
+        x >>= shift;
+        y >>= shift;
+    }
+    else
+    {
+        x = (int32_t)((uint32_t) x << -shift);
+        y = (int32_t)((uint32_t) y << -shift);
+    }
+
+    // rotate into the right half plane, cordic converges within +-99 degrees
+    if(x < 0)
+    {
+        t = x;
+        if(y >= 0)
+        {
+            x = y;
+            y = -t;
+            z = TRIG_PI_2;
+        }
+        else
+        {
+            x = -y;
+            y = t;
+            z = -(uint32_t) TRIG_PI_2;
+        }
+    }
+
+    // d is 0 to rotate clockwise and -1 to rotate back, (v ^ d) - d negates v
+    // for d = -1 so the loop has no branches. The angle sums in uint32_t, a
+    // result near +-pi wraps like the binary angle instead of overflowing.
+    for(i = 0; i < TRIG_ITERATIONS; i++)
+    {
+        d = y >> 31;
+        t = x;
+        x += ((y >> i) ^ d) - d;
+        y -= ((t >> i) ^ d) - d;
+        z += (uint32_t) ((trig_atan_table[i] ^ d) - d);
+    }
+    return (int32_t) z;
+}
+
+/*
+ * TRIG ASIN - the arc sine
+ * @param s - the sine in Q15
+ * @return the angle from -pi/2 to pi/2 as a binary angle.
+ */
+int32_t trig_asin(int16_t s)
+{
+    uint32_t c2 = TRIG_ONE_Q30 - (int32_t) s * s;
+    uint32_t c = 0, bit = 1UL << 30;
+
+    // integer square root of the cosine squared, Q30 -> Q15
+    while(bit > c2) bit >>= 2;
+    while(bit)
+    {
+        if(c2 >= c + bit)
+        {
+            c2 -= c + bit;
+            c = (c >> 1) + bit;
+        }
+        else
+        {
+            c >>= 1;
+        }
+        bit >>= 2;
+    }
+    return trig_atan2(s, c);
+}
+
+/*
+ * TRIG SINCOS - the sine and cosine of an angle
+ * @param angle - the binary angle
+ * @param *s - the sine in Q15, saturated to 32767
+ * @param *c - the cosine in Q15, saturated to 32767
+ */
+void trig_sincos(int32_t angle, int16_t *s, int16_t *c)
+{
+    uint32_t z = (uint32_t) angle;
+    int32_t x = TRIG_GAIN_Q30, y = 0, t, d;
+    int i, flip = 0;
+
+    // fold the left half plane onto the right, adding pi wraps the binary
+    // angle, which only uint32_t arithmetic does without overflow
+    if(angle > TRIG_PI_2 || angle < -TRIG_PI_2)
+    {
+        z += 0x80000000u;
+        flip = 1;
+    }
+
+    for(i = 0; i < TRIG_ITERATIONS; i++)
+    {
+        d = (int32_t) z >> 31;
+        t = x;
+        x -= ((y >> i) ^ d) - d;
+        y += ((t >> i) ^ d) - d;
+        z -= (uint32_t) ((trig_atan_table[i] ^ d) - d);
+    }
+    if(flip)
+    {
+        x = -x;
+        y = -y;
+    }
+
+    // Q30 to Q15 with rounding, 1.0 does not fit
+    x = (x + (1 << 14)) >> 15;
+    y = (y + (1 << 14)) >> 15;
+    *c = (x > 32767) ? 32767 : (x < -32768) ? -32768 : x;
+    *s = (y > 32767) ? 32767 : (y < -32768) ? -32768 : y;
+}
+
+/*
+ * TRIG ATAN2F - trig_atan2 for readings in g, a drop in for atan2f on the
+ *              control path
+ * @param y - the y component, within +-16
+ * @param x - the x component, within +-16
+ * @return the angle in radians.
+ */
+HOT_PATH float trig_atan2f(float y, float x)
+{
+    return trig_atan2((int32_t)(y * TRIG_FLOAT_SCALE), (int32_t)(x * TRIG_FLOAT_SCALE)) *
+           (float) TRIG_RAD_PER_UNIT;
+}
@@ -0,0 +1,32 @@
+/*
+ * File:   trig.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the fixed point trigonometry kernel. Angles are
+ *           int32 binary angles, Q31 fractions of pi, so 0x40000000 is pi/2
+ *           and the full circle wraps with the integer.
+ * Revision history:
+ */
+
+#ifndef TRIG_H
+#define	TRIG_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define TRIG_ITERATIONS (24)                    // cordic iterations, one bit of angle each
+#define TRIG_PI_2 (0x40000000)                  // pi / 2 as a binary angle
+#define TRIG_RAD_PER_UNIT (M_PI / 2147483648.0) // radians per binary angle unit
+#define TRIG_FLOAT_SCALE (134217728.0)          // float to integer scale for trig_atan2f, 2^27
+
+HOT_PATH int32_t trig_atan2(int32_t y, int32_t x);
+int32_t trig_asin(int16_t s);
+void trig_sincos(int32_t angle, int16_t *s, int16_t *c);
+HOT_PATH float trig_atan2f(float y, float x);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* TRIG_H */
+
@@ -0,0 +1,243 @@
+/*
+ * File:   vibe.c
+ * Author: Kevin Dederer
+ * Comments: background vibration analyser. Accelerometer samples are buffered
+ *           as they arrive, and a full buffer is windowed and run through the Q15
+ *           fft a little at a time from the slack at the end of each control
+ *           tick. The dominant motor peak retunes a notch filter that sits on
+ *           the control path in front of the fir filter. Every sensor sample
+ *           is analysed, not one per tick. Below VIBE_MIN_SAMPLE_HZ the motor
+ *           vibration, well above 50hz, would alias into the spectrum and
+ *           tune the notch onto a frequency that is not there, the analyser
+ *           stays off and the notch passes everything.
+ * Revision history:
+ */
+
+#include "config.h"
+
+#define VIBE_POINTS (1 << VIBE_FFT_LOG2)    // real samples per analysis
+#define VIBE_BINS (VIBE_POINTS / 2)         // power bins (and complex points) per analysis
+#define VIBE_SAMPLE_RATE (PIPE_SAMPLE_HZ)   // every sensor sample is pushed
+#define VIBE_MIN_SAMPLE_HZ (400)            // lowest rate analysed, behind the 200hz sensor bandwidth
+#define VIBE_MIN_HZ (10.0)                  // ignore the gravity / attitude band below this
+#define VIBE_PEAK_RATIO (8.0)               // peak must stand this far above the mean bin
+#define VIBE_TRACK_GAIN (0.3)               // low pass on the notch centre frequency
+
+#if (VIBE_FFT_LOG2 != 6) && (VIBE_FFT_LOG2 != 7)
+#error "VIBE_FFT_LOG2 must be 6 (64 points) or 7 (128 points)"
+#endif
+
+enum vibe_state
+{
+    collect, window, bit_reverse, butterfly, power, peak, retune
+};
+
+/*
+ * vibe_data - analyser and notch filter state
+ * @param buffer - two sample buffers, one fills while the other is analysed
+ * @param fill - index of the buffer being filled
+ * @param count - number of samples in the buffer being filled
+ * @param state - the next step the analyser will run
+ * @param stage - the next butterfly stage to run
+ * @param re, im - the packed complex work area for the transform
+ * @param power - power per bin of the last analysis
+ * @param peak_hz - the last detected peak frequency
+ * @param notch - biquad coefficients of the notch with VIBE_NOTCH_SHIFT fraction
+ *              bits, enabled once a peak is found
+ */
+typedef struct
+{
+    int16_t buffer[2][VIBE_POINTS];
+    int fill;
+    int count;
+    enum vibe_state state;
+    int stage;
+    int16_t re[VIBE_BINS];
+    int16_t im[VIBE_BINS];
+    uint32_t power[VIBE_BINS];
+    float peak_hz;
+    struct
+    {
+        float centre_hz;
+        int32_t b0, b1, b2, a1, a2;
+        int enabled;
+    } notch;
+} vibe_data;
+
+PRIVATE vibe_data vibe;
+
+/*
+ * VIBE PUSH SAMPLE - stores one accelerometer sample for analysis. When a
+ *              buffer is full and the analyser is idle the buffers are swapped
+ *              and the analysis started, otherwise the buffer is restarted.
+ * @param sample - the unfiltered acceleration in counts, used as Q15 directly.
+ *              Ignored below VIBE_MIN_SAMPLE_HZ.
+ */
+HOT_PATH void vibe_push_sample(int16_t sample)
+{
+    if(VIBE_SAMPLE_RATE < VIBE_MIN_SAMPLE_HZ) return;
+    vibe.buffer[vibe.fill][vibe.count++] = sample;
+
+    if(vibe.count < VIBE_POINTS) return;
+
+    vibe.count = 0;
+    if(vibe.state == collect)
+    {
+        vibe.fill ^= 1;
+        vibe.state = window;
+    }
+}
+
+/*
+ * NOTCH RETUNE - computes the biquad coefficients for a new centre frequency
+ * @param centre_hz - the frequency to remove.
+ */
+PRIVATE void notch_retune(float centre_hz)
+{
+    float w0 = 2 * M_PI * centre_hz / VIBE_SAMPLE_RATE;
+    float alpha = sinf(w0) / (2 * VIBE_NOTCH_Q);
+    float one = (1 << VIBE_NOTCH_SHIFT) / (1 + alpha);
+
+    vibe.notch.b0 = lroundf(one);
+    vibe.notch.b1 = lroundf(-2 * cosf(w0) * one);
+    vibe.notch.b2 = vibe.notch.b0;
+    vibe.notch.a1 = vibe.notch.b1;
+    vibe.notch.a2 = lroundf((1 - alpha) * one);
+    vibe.notch.centre_hz = centre_hz;
+    vibe.notch.enabled = 1;
+}
+
+/*
+ * FIND PEAK - looks for a dominant bin in the power spectrum and interpolates
+ *              its frequency.
+ * @return 1 if a peak was found and stored in vibe.peak_hz, 0 otherwise.
+ */
+PRIVATE int find_peak(void)
+{
+    int k, first = VIBE_MIN_HZ * VIBE_POINTS / VIBE_SAMPLE_RATE + 1;
+    int max_k;
+
+    if(first < 2) first = 2;    // the hann window spreads gravity into bin 1
+    max_k = first;
+    float mean = 0, l, c, r, delta;
+
+    for(k = first; k < VIBE_BINS; k++)
+    {
+        mean += vibe.power[k];
+        if(vibe.power[k] > vibe.power[max_k])
+            max_k = k;
+    }
+    mean /= (VIBE_BINS - first);
+
+    if(vibe.power[max_k] < mean * VIBE_PEAK_RATIO) return 0;
+
+    // parabolic interpolation between the neighbouring bins
+    delta = 0;
+    if(max_k > first && max_k < VIBE_BINS - 1)
+    {
+        l = vibe.power[max_k - 1];
+        c = vibe.power[max_k];
+        r = vibe.power[max_k + 1];
+        if(l - 2 * c + r != 0)
+            delta = 0.5 * (l - r) / (l - 2 * c + r);
+    }
+    vibe.peak_hz = (max_k + delta) * VIBE_SAMPLE_RATE / VIBE_POINTS;
+    return 1;
+}
+
+/*
+ * VIBE STEP - runs the next short piece of the analysis. Each call is bounded
+ *              by VIBE_STEP_TICKS so it can be called from the loop slack
+ *              without delaying the next control tick.
+ * @return 1 while an analysis is in progress, 0 when idle.
+ */
+int vibe_step(void)
+{
+    const int16_t *samples = vibe.buffer[vibe.fill ^ 1];
+    int n, w_step = FFT_MAX_POINTS / VIBE_POINTS;
+    int32_t w_even, w_odd;
+
+    switch(vibe.state)
+    {
+        case collect:
+            break;
+        case window:
+            // hann window and pack even / odd samples as real / imaginary
+            for(n = 0; n < VIBE_BINS; n++)
+            {
+                w_even = (32767 - fft_cos_q15(2 * n * w_step)) >> 1;
+                w_odd = (32767 - fft_cos_q15((2 * n + 1) * w_step)) >> 1;
+                vibe.re[n] = (samples[2 * n] * w_even) >> 15;
+                vibe.im[n] = (samples[2 * n + 1] * w_odd) >> 15;
+            }
+            vibe.state = bit_reverse;
+            break;
+        case bit_reverse:
+            fft_bit_reverse(vibe.re, vibe.im, VIBE_FFT_LOG2 - 1);
+            vibe.stage = 0;
+            vibe.state = butterfly;
+            break;
+        case butterfly:
+            fft_stage(vibe.re, vibe.im, VIBE_FFT_LOG2 - 1, vibe.stage);
+            if(++vibe.stage == VIBE_FFT_LOG2 - 1)
+                vibe.state = power;
+            break;
+        case power:
+            fft_real_power(vibe.re, vibe.im, VIBE_FFT_LOG2 - 1, vibe.power);
+            vibe.state = peak;
+            break;
+        case peak:
+            vibe.state = find_peak() ? retune : collect;
+            break;
+        case retune:
+            if(vibe.notch.enabled)
+                notch_retune(vibe.notch.centre_hz + VIBE_TRACK_GAIN * (vibe.peak_hz - vibe.notch.centre_hz));
+            else
+                notch_retune(vibe.peak_hz);
+            vibe.state = collect;
+            break;
+    }
+    return vibe.state != collect;
+}
+
+/*
+ * VIBE NOTCH - passes a block of one axis through the dynamic notch filter in
+ *              place, the samples are left unchanged until the analyser has
+ *              found a peak.
+ * @param samples - the sensor readings in counts, oldest first
+ * @param count - the number of samples
+ * @param state - the notch history for the desired axis
+ */
+HOT_PATH void vibe_notch(int16_t *samples, int count, notch_state *state)
+{
+    const int32_t b0 = vibe.notch.b0, b1 = vibe.notch.b1, b2 = vibe.notch.b2;
+    const int32_t a1 = vibe.notch.a1, a2 = vibe.notch.a2;
+    int64_t acc;
+    int32_t out;
+    int i;
+
+    if(!vibe.notch.enabled) return;
+
+    for(i = 0; i < count; i++)
+    {
+        acc = (int64_t) b0 * samples[i] + (int64_t) b1 * state->x1 + (int64_t) b2 * state->x2 -
+              (int64_t) a1 * state->y1 - (int64_t) a2 * state->y2;
+        out = (int32_t)((acc + (1 << (VIBE_NOTCH_SHIFT - 1))) >> VIBE_NOTCH_SHIFT);
+        out = (out > 32767) ? 32767 : (out < -32768) ? -32768 : out;
+
+        state->x2 = state->x1;
+        state->x1 = samples[i];
+        state->y2 = state->y1;
+        state->y1 = out;
+        samples[i] = out;
+    }
+}
+
+/*
+ * VIBE PEAK HZ - the centre frequency the notch is currently tuned to
+ * @return the notch centre in hz, 0 if no peak has been found yet.
+ */
+float vibe_peak_hz(void)
+{
+    return vibe.notch.enabled ? vibe.notch.centre_hz : 0;
+}
@@ -0,0 +1,44 @@
+/*
+ * File:   vibe.h
+ * Author: Kevin Dederer
+ * Comments: Header file for the vibration analyser and the dynamic notch filter
+ * Revision history:
+ */
+
+#ifndef VIBE_H
+#define	VIBE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define VIBE_FFT_LOG2 (6)               // 6 for a 64 point analysis, 7 for 128 points
+#define VIBE_STEP_TICKS (8000)          // worst case core timer ticks of one vibe_step() (200us)
+
+#define VIBE_NOTCH_SHIFT (14)          // fraction bits of the notch coefficients, |a1| reaches 2
+#define VIBE_NOTCH_Q (2.0)              // notch quality factor, centre / bandwidth
+
+/*
+ * notch_state - the per axis history of the notch filter, direct form 1
+ * @param x1, x2 - the last two inputs, in counts
+ * @param y1, y2 - the last two outputs, in counts
+ */
+typedef struct
+{
+    int16_t x1;
+    int16_t x2;
+    int16_t y1;
+    int16_t y2;
+} notch_state;
+
+HOT_PATH void vibe_push_sample(int16_t sample);
+int vibe_step(void);
+HOT_PATH void vibe_notch(int16_t *samples, int count, notch_state *state);
+float vibe_peak_hz(void);
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+#endif	/* VIBE_H */
+
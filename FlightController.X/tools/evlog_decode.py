@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""
+evlog_decode.py - turns binary event log records back into readable messages.
+
+Input is a raw dump of evlog_record structs (16 bytes, little endian), either
+a memory export of the ring from the debugger or a captured record stream.
+Empty slots are skipped and records are printed in write order. The event
+ids and messages are read from EVLOG_EVENTS in src/evlog.h.
+
+usage: evlog_decode.py dump.bin [--header path/to/evlog.h]
+"""
+
+import argparse
+import os
+import re
+import struct
+
+RECORD = struct.Struct('<IHHII')   # seq, id, tick, time, arg
+
+
+def load_events(header):
+    """Returns the list of (name, message, arg) in event id order."""
+    events = []
+    with open(header) as f:
+        for line in f:
+            m = re.match(r'\s*X\((\w+),\s*"(.*)",\s*(\w+)\)', line)
+            if m:
+                events.append((m.group(1), m.group(2), m.group(3)))
+    return events
+
+
+def decode(data, events):
+    """Yields (seq, tick, time, text) for every committed record, in write order."""
+    records = []
+    for offset in range(0, len(data) - RECORD.size + 1, RECORD.size):
+        seq, ev, tick, time, arg = RECORD.unpack_from(data, offset)
+        if seq == 0:
+            continue
+        if ev < len(events):
+            name, message, kind = events[ev]
+            if kind == 'evlog_unsigned':
+                message += ' %u' % arg
+            elif kind == 'evlog_signed':
+                message += ' %d' % struct.unpack('<i', struct.pack('<I', arg))[0]
+            elif kind == 'evlog_hex':
+                message += ' 0x%x' % arg
+            text = '%s: %s' % (name, message)
+        else:
+            text = 'unknown event %u (arg %u)' % (ev, arg)
+        records.append((seq, tick, time, text))
+    return sorted(records)
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description='decode a binary event log dump')
+    parser.add_argument('dump', help='raw evlog_record data')
+    parser.add_argument('--header', default=os.path.join(here, '..', 'src', 'evlog.h'),
+                        help='evlog.h holding the EVLOG_EVENTS list')
+    args = parser.parse_args()
+
+    events = load_events(args.header)
+    with open(args.dump, 'rb') as f:
+        data = f.read()
+
+    for seq, tick, time, text in decode(data, events):
+        print('#%-6u [%u.%u] %s' % (seq - 1, tick, time, text))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""
+i2c_model.py - predicts the I2C bus occupancy of the sensor reads and checks
+it against i2c_profile_report() captures.
+
+The cost model counts what goes over the wire: every byte is 9 bit times
+with its acknowledge, a start or stop condition is one bit time, and
+i2c_start() adds a fixed settling delay after every start. Each read
+strategy is the list of operations one sample of one imu takes, the
+occupancy is that cost times the output data rate and the imu count.
+
+Captures are console logs of a build with PROFILE and I2C_PROFILE, the host
+build runs them against the simulated bus. Each capture is compared with the
+model, so the gap is the driver overhead, and two captures are compared
+with each other to give before and after numbers for a driver change.
+
+usage: i2c_model.py [--odr HZ] [--imus N] [--clock HZ] [before.log [after.log]]
+"""
+
+import argparse
+import json
+import sys
+
+START_DELAY_US = 10     # i2c_delay() in i2c_start()
+SAMPLE_BYTES = 6        # OUT_X_L..OUT_Z_H
+
+
+def read_reg():
+    """(starts, address bytes, data bytes, stops) of lsm330_read_reg()."""
+    return (2, 2, 2, 1)
+
+
+def write_reg():
+    """(starts, address bytes, data bytes, stops) of lsm330_write_reg()."""
+    return (1, 1, 2, 1)
+
+
+def read_multiple(n):
+    """(starts, address bytes, data bytes, stops) of an n byte burst read."""
+    return (2, 2, 1 + n, 1)
+
+
+# (name, description, operations of one sample of one imu)
+STRATEGIES = [
+    ('poll_burst', 'status read, then a 6 byte burst (read_accel)',
+     [('read_reg', read_reg()), ('read_multiple', read_multiple(SAMPLE_BYTES))]),
+    ('status_burst', 'one 7 byte burst from STATUS_A',
+     [('read_multiple', read_multiple(1 + SAMPLE_BYTES))]),
+    ('burst', 'a 6 byte burst, no status read',
+     [('read_multiple', read_multiple(SAMPLE_BYTES))]),
+    ('single', 'six single register reads',
+     [('read_reg', read_reg())] * SAMPLE_BYTES),
+]
+
+
+def op_us(shape, clock):
+    """Returns the predicted bus time of one operation in microseconds."""
+    starts, address, data, stops = shape
+    bit = 1e6 / clock
+    return starts * (bit + START_DELAY_US) + stops * bit + (address + data) * 9 * bit
+
+
+def load_report(path):
+    """Returns the last i2c report found in a captured console log."""
+    report = None
+    with open(path, errors='replace') as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith('{"i2c"'):
+                report = json.loads(line)['i2c']
+    if report is None:
+        sys.exit('%s: no i2c report found' % path)
+    return report
+
+
+def print_model(args):
+    """Prints the predicted cost and occupancy of every read strategy."""
+    print('model at %u hz, %u hz odr, %u imu%s' % (args.clock, args.odr, args.imus,
+                                                    '' if args.imus == 1 else 's'))
+    print('%-13s %9s %8s  %s' % ('strategy', 'us/sample', 'busy', 'operations'))
+    for name, text, ops in STRATEGIES:
+        us = sum(op_us(shape, args.clock) for _, shape in ops)
+        busy = 100.0 * us * args.odr * args.imus / 1e6
+        print('%-13s %9.1f %7.2f%%  %s' % (name, us, busy, text))
+
+
+def print_capture(path, report):
+    """Compares each operation of a capture with the model, returns busy_pct."""
+    clock = report['clock_hz']
+    print('\n%s: %.2f%% busy over %.1f s' % (path, report['busy_pct'], report['window_us'] / 1e6))
+    print('%-14s %7s %8s %8s %9s %8s %8s' % ('operation', 'calls', 'retries', 'failed',
+                                             'model us', 'mean us', 'overhead'))
+    for op in report['ops']:
+        if not op['calls']:
+            continue
+        calls = op['calls']
+        # the average shape actually seen, retries and all
+        shape = (op['starts'] / calls, op['address_bytes'] / calls,
+                 op['data_bytes'] / calls, 1)
+        model = op_us(shape, clock)
+        print('%-14s %7u %8u %8u %9.1f %8.1f %+7.1f%%' % (
+            op['name'], calls, op['nack_retries'], op['failed'], model, op['mean_us'],
+            100.0 * (op['mean_us'] - model) / model))
+    return report['busy_pct']
+
+
+def main():
+    parser = argparse.ArgumentParser(description='i2c bus occupancy model')
+    parser.add_argument('captures', nargs='*', help='logs holding an i2c report')
+    parser.add_argument('--odr', type=int, default=100, help='samples per second per imu')
+    parser.add_argument('--imus', type=int, default=1, help='imus on the bus')
+    parser.add_argument('--clock', type=int, default=400000, help='bus clock in hz')
+    args = parser.parse_args()
+
+    print_model(args)
+    busy = [print_capture(path, load_report(path)) for path in args.captures[:2]]
+    if len(busy) == 2:
+        print('\nbusy %.2f%% -> %.2f%% (%+.2f points)' % (busy[0], busy[1], busy[1] - busy[0]))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+"""
+latency_margin.py - gain and phase margin of the pitch loop against the
+latency compensated by the predictor.
+
+The loop is evaluated in the frequency domain with the blocks the firmware
+actually has: the discrete pid of pid.c, the fir set of fir_coeffs.h for
+the loop rate, the trend extrapolation of predict.c, the sample hold of the
+loop, a pure delay from the sample to the pwm latch, and a rigid body
+with a first order motor lag as the plant. The gains, the fir taps and the
+trend smoothing are read from the sources so the experiment follows them.
+
+The plant gain (angular acceleration per unit of pid output) and the motor
+lag are not identified on the craft, the default gain puts the crossover
+where the pid lead is largest, measured values should replace both. The gain
+margin is only printed for a stable loop. Feed-forward acts outside the loop
+and does not change the margins.
+
+The pwm period starts MOTOR_PWM_PHASE_US into the control tick, so the
+delay is that phase. With --free-run it is the read time and on average half
+of the free running period of MOTOR_PWM_FREE_RUN.
+
+usage: latency_margin.py [--rate HZ] [--short] [--free-run] [--plant-gain K]
+                         [--motor-lag S] [--step MS] [--max-ms MS]
+"""
+
+import argparse
+import cmath
+import math
+import os
+import re
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SRC = os.path.join(HERE, '..', 'src')
+PWM_FREE_PERIOD_S = 0.016   # MOTOR_PWM_PERIOD_S with MOTOR_PWM_FREE_RUN
+PWM_PHASE_TICK = 0.25       # default MOTOR_PWM_PHASE_US as a share of the tick
+TRANSFER_S = 0.0004     # status read and burst on the bus, tools/i2c_model.py
+
+
+def read(name):
+    with open(os.path.join(SRC, name)) as f:
+        return f.read()
+
+
+def load_fir(rate, short):
+    """Returns the coefficients of the fir set used at the loop rate."""
+    text = read('fir_coeffs.h')
+    block = re.search(r'#(?:el)?if PIPE_SAMPLE_HZ == %d\n(.*?)#(?:elif|else|endif)' % rate, text, re.S)
+    if block is None:
+        sys.exit('no fir set for %d hz' % rate)
+    name = 'FIR_SHORT_COEFFS' if short else 'FIR_COEFFS'
+    values = re.search(r'#define %s \\\n((?:.*\\\n)*.*)' % name, block.group(1))
+    return [int(v) for v in re.findall(r'-?\d+', values.group(1))]
+
+
+def load_param(name):
+    """Returns the default of a PARAMS entry, numeric defaults only."""
+    m = re.search(r'X\(%s,\s*\w+,\s*([-\d.]+)' % name, read('params.h'))
+    return float(m.group(1))
+
+
+def load_define(header, name):
+    m = re.search(r'#define %s \(([-\d.]+)\)' % name, read(header))
+    return float(m.group(1))
+
+
+class Loop:
+    """Open loop frequency response of the pitch loop."""
+
+    def __init__(self, args):
+        self.T = 1.0 / args.rate
+        self.fir = load_fir(args.rate, args.short)
+        self.fir_dc = float(sum(self.fir))
+        self.kp, self.ki, self.kd = (load_param(n) for n in ('kp', 'ki', 'kd'))
+        self.smooth = load_define('predict.h', 'PREDICT_RATE_SMOOTH')
+        if args.free_run:
+            self.delay = TRANSFER_S + PWM_FREE_PERIOD_S / 2
+        else:
+            self.delay = PWM_PHASE_TICK * self.T    # the sample is read at the start of the tick
+        self.latency = (len(self.fir) - 1) / 2.0 * self.T + self.delay
+        self.K = args.plant_gain
+        self.tau = args.motor_lag
+
+    def response(self, w, horizon):
+        """L(jw) with the attitude extrapolated over horizon seconds."""
+        T = self.T
+        zi = cmath.exp(-1j * w * T)     # z^-1
+        s = 1j * w
+        pid = self.kp + self.ki * T / (1 - zi) + self.kd * (1 - zi) / T
+        fir = sum(c * zi ** k for k, c in enumerate(self.fir)) / self.fir_dc
+        trend = self.smooth / (1 - (1 - self.smooth) * zi) * (1 - zi) / T
+        predict = 1 + horizon * trend
+        hold = (1 - cmath.exp(-s * T)) / (s * T)
+        delay = cmath.exp(-s * self.delay)
+        plant = self.K / (s * s * (self.tau * s + 1))
+        return pid * fir * predict * hold * delay * plant
+
+    def margins(self, horizon):
+        """Returns (phase margin deg, gain margin db, crossover hz), None where absent."""
+        points = 6000
+        w_lo, w_hi = 0.01, math.pi / self.T
+        ws = [w_lo * (w_hi / w_lo) ** (i / (points - 1.0)) for i in range(points)]
+        mags, phases, last = [], [], None
+        for w in ws:
+            L = self.response(w, horizon)
+            p = math.degrees(cmath.phase(L))
+            if last is not None:
+                while p - last > 180:
+                    p -= 360
+                while p - last < -180:
+                    p += 360
+            mags.append(abs(L))
+            phases.append(p)
+            last = p
+
+        wc = pm = gm = None
+        for i in range(1, points):
+            if mags[i - 1] >= 1 > mags[i]:
+                f = (mags[i - 1] - 1) / (mags[i - 1] - mags[i])
+                wc = ws[i - 1] + f * (ws[i] - ws[i - 1])
+                pm = 180 + phases[i - 1] + f * (phases[i] - phases[i - 1])
+                start = i
+                break
+        if wc is None:
+            return None, None, None
+        # the first -180 (mod 360) crossing above the gain crossover
+        for i in range(start, points):
+            a, b = phases[i - 1] + 180, phases[i] + 180
+            if math.floor(a / 360) != math.floor(b / 360):
+                f = (a - 360 * math.floor(max(a, b) / 360)) / (a - b) if a != b else 0
+                mag = mags[i - 1] + f * (mags[i] - mags[i - 1])
+                gm = -20 * math.log10(mag)
+                break
+        pm = (pm + 180) % 360 - 180
+        return pm, gm, wc / (2 * math.pi)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='loop margins against compensated latency')
+    parser.add_argument('--rate', type=int, default=100, help='LOOP_RATE_HZ, with PIPE_DECIMATE 1')
+    parser.add_argument('--short', action='store_true', help='the 16 tap overload filter')
+    parser.add_argument('--free-run', action='store_true',
+                        help='the pwm period not aligned to the tick, MOTOR_PWM_FREE_RUN')
+    parser.add_argument('--plant-gain', type=float, default=2.0,
+                        help='rad/s^2 per unit of pid output, not identified')
+    parser.add_argument('--motor-lag', type=float, default=0.05, help='motor time constant, s')
+    parser.add_argument('--step', type=float, default=5.0, help='ms between rows')
+    parser.add_argument('--max-ms', type=float, default=None,
+                        help='longest horizon, default the whole latency')
+    args = parser.parse_args()
+
+    loop = Loop(args)
+    top = loop.latency * 1e3 if args.max_ms is None else args.max_ms
+    print('%d hz, %d taps, latency %.1f ms (fir %.1f, read to latch %.1f), kp %g ki %g kd %g' % (
+        args.rate, len(loop.fir), loop.latency * 1e3, (loop.latency - loop.delay) * 1e3,
+        loop.delay * 1e3, loop.kp, loop.ki, loop.kd))
+    print('%8s %8s %8s %8s %10s' % ('comp ms', 'pm deg', 'gm db', 'fc hz', 'pm/ms'))
+
+    base = loop.margins(0)[0]
+    ms = 0.0
+    while ms <= top + 1e-9:
+        pm, gm, fc = loop.margins(ms * 1e-3)
+        if pm is None:
+            print('%8.1f %8s' % (ms, 'no crossover'))
+        else:
+            slope = (pm - base) / ms if ms and base is not None else 0.0
+            stable = pm > 0 and gm is not None
+            print('%8.1f %8.1f %8s %8.3f %+10.3f' % (ms, pm, '%.1f' % gm if stable else '-',
+                                                     fc, slope))
+        ms += args.step
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,331 @@
+#!/usr/bin/env python3
+"""
+map_report.py - reports memory use from the XC32 linker map.
+
+Reads the map written next to the image (dist/default/<type>/FlightController.X.<type>.map)
+and reports:
+  - the static ram and the flash used per module (object file or library)
+    and per symbol;
+  - the stack space the linker left between _splim and _stack, against
+    the high water mark the firmware measures at run time (stack.h);
+  - the code placed in ram by RUN_FROM_RAM (the .ramfunc sections) against
+    the ram that is left over by data, bss, stack and heap.
+
+With --budget the totals and the modules are checked against a JSON file.
+The exit status is 1 when a budget is exceeded or the ram does not fit.
+The Makefile runs this after every build with tools/map_budget.json:
+
+  {"source": "the map the budgets were set from",
+   "ram_static": bytes, "flash": bytes, "stack_min": bytes,
+   "modules": {"default": {"ram": bytes, "flash": bytes}, "<module>": {...}}}
+
+The default module budget applies to the project objects, libraries are
+only checked when they are named. --write-budget FILE sets every budget
+from the map instead, the use plus --headroom percent rounded up to 256
+bytes and the stack space as it is, so the budgets always come from a
+target map, a module added later falls under the largest module budget.
+A budget without a map as its source is reported as such.
+
+usage: map_report.py FlightController.X.production.map [--budget FILE] [--top N] [--json]
+       map_report.py FlightController.X.production.map --write-budget FILE [--headroom PCT]
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+RAM_REGION = 'kseg1_data_mem'
+RAM_BASES = (0xa0000000, 0x80000000)    # kseg1 and kseg0 views of the data ram
+
+SECTION_RE = re.compile(r'^(\.\S+|COMMON)\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)(?:\s+(.*))?$')
+NAME_ONLY_RE = re.compile(r'^(\.\S+|COMMON)\s*$')
+ADDR_SIZE_RE = re.compile(r'^\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)(?:\s+(.*))?$')
+SYMBOL_RE = re.compile(r'^\s+(0x[0-9a-fA-F]+)\s+([A-Za-z_]\w*)\s*$')
+ASSIGN_RE = re.compile(r'^\s+(0x[0-9a-fA-F]+)\s+(?:PROVIDE \()?(_\w+)\s+=')
+LINKER_SYMBOLS = ('_splim', '_stack', '_min_stack_size', '_min_heap_size')
+FLASH_REGIONS = ('program_mem', 'boot_mem', 'exception_mem')
+RESERVED_RAM = ('.stack', '.heap')      # ram output sections that are reserved, not static data
+REGION_RE = re.compile(r'^(\S+)\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)')
+
+
+def parse_map(path):
+    """
+    Parses a GNU ld map file.
+    Returns (regions, sections, symbols) where regions maps a memory region
+    name to (origin, length), sections is a list of dicts with the keys
+    output, name, address, size, object and symbols, one per input section,
+    symbols being (address, name) pairs, and symbols maps the LINKER_SYMBOLS
+    found to their values.
+    """
+    regions = {}
+    sections = []
+    linker = {}
+    output = None
+    pending = None      # (indent, name) of a section whose address is on the next line
+    in_regions = False
+    in_map = False
+
+    with open(path, errors='replace') as f:
+        lines = f.read().splitlines()
+
+    for line in lines:
+        if line.startswith('Memory Configuration'):
+            in_regions = True
+            continue
+        if line.startswith('Linker script and memory map'):
+            in_regions = False
+            in_map = True
+            continue
+        if in_regions:
+            m = REGION_RE.match(line)
+            if m and m.group(1) != 'Name':
+                regions[m.group(1)] = (int(m.group(2), 16), int(m.group(3), 16))
+            continue
+        if not in_map:
+            continue
+
+        if pending:
+            m = ADDR_SIZE_RE.match(line)
+            indent, name = pending
+            pending = None
+            if m:
+                line = (' ' if indent else '') + '%s %s %s %s' % (name, m.group(1), m.group(2), m.group(3) or '')
+        top = not line.startswith(' ')
+        stripped = line.strip() if not top else line
+
+        m = NAME_ONLY_RE.match(stripped)
+        if m and (top or line.startswith(' .') or line.startswith(' COMMON')):
+            pending = (not top, m.group(1))
+            continue
+
+        m = SECTION_RE.match(stripped)
+        if m and (top or line.startswith(' .') or line.startswith(' COMMON')):
+            name, address, size, rest = m.group(1), int(m.group(2), 16), int(m.group(3), 16), (m.group(4) or '').strip()
+            if top:
+                output = name
+                sections.append({'output': name, 'name': name, 'address': address, 'size': size,
+                                 'object': None, 'symbols': [], 'top': True})
+            elif size:
+                sections.append({'output': output, 'name': name, 'address': address, 'size': size,
+                                 'object': rest.split()[0] if rest else None, 'symbols': [], 'top': False})
+            continue
+
+        m = ASSIGN_RE.match(line)
+        if m and m.group(2) in LINKER_SYMBOLS:
+            linker[m.group(2)] = int(m.group(1), 16)
+            continue
+
+        m = SYMBOL_RE.match(line)
+        if m and sections and not sections[-1]['top']:
+            sections[-1]['symbols'].append((int(m.group(1), 16), m.group(2)))
+
+    return regions, sections, linker
+
+
+def in_ram(address, regions):
+    """True if the address lies in the data ram."""
+    origin, length = regions.get(RAM_REGION, (RAM_BASES[0], 0x8000))
+    offset = origin & 0x1fffffff
+    return any(base + offset <= address < base + offset + length for base in RAM_BASES)
+
+
+def region_of(address, regions):
+    """The name of the memory region holding the address, None if there is none."""
+    physical = address & 0x1fffffff
+    for name, (origin, length) in regions.items():
+        if (origin & 0x1fffffff) <= physical < (origin & 0x1fffffff) + length:
+            return name
+    return None
+
+
+def memory_of(section, regions):
+    """'ram', 'flash' or None for a section, by the region it was placed in."""
+    name = region_of(section['address'], regions)
+    if name is None:
+        return 'ram' if in_ram(section['address'], regions) else None
+    if 'data_mem' in name:
+        return 'ram'
+    if any(r in name for r in FLASH_REGIONS):
+        return 'flash'
+    return None
+
+
+def module_of(obj):
+    """The module of an input section: the object name, or the library for an archive member."""
+    if not obj:
+        return '(linker)'
+    m = re.match(r'(.*\.a)\(.*\)$', obj)
+    if m:
+        return os.path.basename(m.group(1))
+    return re.sub(r'\.o$', '', os.path.basename(obj))
+
+
+def symbol_sizes(section):
+    """(name, bytes) of every symbol of an input section, each runs to the next one."""
+    syms = sorted(section['symbols'])
+    if not syms:
+        return [('%s(%s)' % (module_of(section['object']), section['name']), section['size'])]
+    end = section['address'] + section['size']
+    sizes = []
+    for i, (address, name) in enumerate(syms):
+        following = syms[i + 1][0] if i + 1 < len(syms) else end
+        sizes.append((name, following - address))
+    if syms[0][0] > section['address']:     # unnamed bytes in front of the first symbol
+        sizes.append(('%s(%s)' % (module_of(section['object']), section['name']), syms[0][0] - section['address']))
+    return sizes
+
+
+def usage_report(regions, sections, linker):
+    """Static ram and flash per module and per symbol, and the stack space."""
+    origin, length = regions.get(RAM_REGION, (RAM_BASES[0], 0x8000))
+    flash_bytes = sum(l for name, (o, l) in regions.items() if any(r in name for r in FLASH_REGIONS))
+    modules, symbols = {}, []
+    for s in sections:
+        if s['top'] or s['output'] in RESERVED_RAM:
+            continue
+        memory = memory_of(s, regions)
+        if memory is None:
+            continue
+        module = module_of(s['object'])
+        entry = modules.setdefault(module, {'name': module, 'ram': 0, 'flash': 0,
+                                            'library': module.endswith('.a')})
+        entry[memory] += s['size']
+        for name, size in symbol_sizes(s):
+            symbols.append({'name': name, 'module': module, 'memory': memory, 'bytes': size})
+
+    tops = [s for s in sections if s['top'] and s['size']]
+    reserved = {s['name']: s['size'] for s in tops if s['name'] in RESERVED_RAM}
+    static = sum(s['size'] for s in tops if s['name'] not in RESERVED_RAM and memory_of(s, regions) == 'ram')
+    flash = sum(s['size'] for s in tops if memory_of(s, regions) == 'flash')
+    stack = None
+    if '_stack' in linker and '_splim' in linker:
+        stack = linker['_stack'] - linker['_splim']
+    return {
+        'ram_bytes': length,
+        'ram_static': static,
+        'heap_bytes': reserved.get('.heap', 0),
+        'stack_reserved': reserved.get('.stack', 0),
+        'stack_space': stack,
+        'flash_bytes': flash_bytes,
+        'flash_used': flash,
+        'modules': sorted(modules.values(), key=lambda m: -(m['ram'] + m['flash'])),
+        'symbols': sorted(symbols, key=lambda s: -s['bytes']),
+    }
+
+
+def check_budget(usage, budget):
+    """Returns the list of exceeded budgets as strings."""
+    over = []
+    if 'ram_static' in budget and usage['ram_static'] > budget['ram_static']:
+        over.append('static ram %d over %d' % (usage['ram_static'], budget['ram_static']))
+    if 'flash' in budget and usage['flash_used'] > budget['flash']:
+        over.append('flash %d over %d' % (usage['flash_used'], budget['flash']))
+    if 'stack_min' in budget and usage['stack_space'] is not None and usage['stack_space'] < budget['stack_min']:
+        over.append('stack space %d under %d' % (usage['stack_space'], budget['stack_min']))
+    limits = budget.get('modules', {})
+    for m in usage['modules']:
+        limit = limits.get(m['name'], None if m['library'] or m['name'] == '(linker)' else limits.get('default'))
+        for memory in ('ram', 'flash'):
+            if limit and memory in limit and m[memory] > limit[memory]:
+                over.append('%s %s %d over %d' % (m['name'], memory, m[memory], limit[memory]))
+    return over
+
+
+def budget_from(usage, source, headroom):
+    """Budgets of the usage plus headroom percent, for --write-budget."""
+    def room(used):
+        return max(256, -(-int(used * (100 + headroom) / 100) // 256) * 256)
+    modules = {m['name']: {'ram': room(m['ram']), 'flash': room(m['flash'])}
+               for m in usage['modules'] if not m['library'] and m['name'] != '(linker)'}
+    # a module added later gets the largest budget of the ones there are
+    modules['default'] = {memory: max([b[memory] for b in modules.values()] or [256])
+                          for memory in ('ram', 'flash')}
+    budget = {'source': source, 'ram_static': room(usage['ram_static']),
+              'flash': room(usage['flash_used'])}
+    if usage['stack_space'] is not None:
+        budget['stack_min'] = usage['stack_space']
+    budget['modules'] = modules
+    return budget
+
+
+def ramfunc_report(regions, sections):
+    """Summarises the hot code placed in ram against the free ram."""
+    origin, length = regions.get(RAM_REGION, (RAM_BASES[0], 0x8000))
+    outputs = [s for s in sections if s['top'] and s['size'] and in_ram(s['address'], regions)]
+    hot = [s for s in sections if not s['top'] and s['output'] and s['output'].startswith('.ramfunc')]
+    hot_size = sum(s['size'] for s in hot)
+    used = sum(s['size'] for s in outputs)
+    return {
+        'ram_bytes': length,
+        'ram_used': used,
+        'ram_free': length - used,
+        'ramfunc_bytes': hot_size,
+        'ramfunc_pct_of_ram': round(100.0 * hot_size / length, 1) if length else 0,
+        'functions': [{'name': ','.join(n for _, n in s['symbols']) or s['name'], 'bytes': s['size'], 'object': s['object']}
+                      for s in sorted(hot, key=lambda s: -s['size'])],
+        'ram_sections': [{'name': s['name'], 'bytes': s['size']} for s in outputs],
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description='report memory use from an XC32 map file')
+    parser.add_argument('map', help='linker map file')
+    parser.add_argument('--budget', help='JSON budget file, tools/map_budget.json')
+    parser.add_argument('--top', type=int, default=15, help='largest symbols listed per memory, 0 for all')
+    parser.add_argument('--json', action='store_true', help='write the report as JSON')
+    parser.add_argument('--write-budget', metavar='FILE', help='set the budgets of FILE from the map')
+    parser.add_argument('--headroom', type=int, default=10, help='percent over the use for --write-budget')
+    args = parser.parse_args()
+
+    regions, sections, linker = parse_map(args.map)
+    usage = usage_report(regions, sections, linker)
+    report = ramfunc_report(regions, sections)
+    if args.write_budget:
+        with open(args.write_budget, 'w') as f:
+            json.dump(budget_from(usage, os.path.basename(args.map), args.headroom), f, indent=2)
+            f.write('\n')
+        return 0
+    over = []
+    if args.budget:
+        with open(args.budget) as f:
+            budget = json.load(f)
+        over = check_budget(usage, budget)
+        if not budget.get('source', '').endswith('.map'):
+            print('note: %s was not set from a target map, run --write-budget' % args.budget, file=sys.stderr)
+    failed = bool(over) or report['ram_free'] < 0
+    if args.json:
+        json.dump({'usage': usage, 'ramfunc': report, 'over_budget': over}, sys.stdout, indent=2)
+        print()
+        return 1 if failed else 0
+
+    print('modules %28s %8s' % ('ram', 'flash'))
+    for m in usage['modules']:
+        print('  %-28s %6d %8d' % (m['name'], m['ram'], m['flash']))
+    for memory in ('ram', 'flash'):
+        listed = [s for s in usage['symbols'] if s['memory'] == memory]
+        print('largest %s symbols' % memory)
+        for s in listed[:args.top or len(listed)]:
+            print('  %-28s %6d  %s' % (s['name'], s['bytes'], s['module']))
+    print('static ram %d, heap %d, stack reserve %d of %d' % (
+        usage['ram_static'], usage['heap_bytes'], usage['stack_reserved'], usage['ram_bytes']))
+    if usage['stack_space'] is not None:
+        print('stack space %d (_splim to _stack), compare the stack report of a PROFILE build' % usage['stack_space'])
+    print('flash %d of %d' % (usage['flash_used'], usage['flash_bytes']))
+
+    print('hot code in ram (.ramfunc)')
+    for f in report['functions']:
+        print('  %-28s %6d  %s' % (f['name'], f['bytes'], f['object'] or ''))
+    print('  %-28s %6d  (%.1f%% of ram)' % ('total', report['ramfunc_bytes'], report['ramfunc_pct_of_ram']))
+    print('ram sections')
+    for s in report['ram_sections']:
+        print('  %-28s %6d' % (s['name'], s['bytes']))
+    print('  %-28s %6d of %d, %d free' % ('total', report['ram_used'], report['ram_bytes'], report['ram_free']))
+    for o in over:
+        print('over budget: %s' % o)
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""
+params_cli.py - reads and changes the tunable parameters over the serial link.
+
+Talks the frame protocol described in src/params_link.h to a board built with
+PARAMS_LINK, or to the host build's pty (FC_HOST_PTY). Values are set one by
+one into the shadow set and then committed together, so the board switches
+to the new set on a single control tick or not at all.
+
+usage: params_cli.py PORT list
+       params_cli.py PORT get NAME...
+       params_cli.py PORT set NAME=VALUE... [--no-commit]
+"""
+
+import argparse
+import os
+import select
+import struct
+import termios
+import time
+import tty
+
+SYNC = 0xA5
+PING, INFO, GET, SET, COMMIT = range(5)
+ERROR = 0x80
+VERSION = 1
+TYPES = ('float', 'int')
+ERRORS = {-1: 'unknown parameter', -2: 'read only', -3: 'out of range',
+          -4: 'inconsistent set'}
+LINK_ERRORS = {1: 'bad command', 2: 'bad length', 3: 'bad index'}
+BAUD = termios.B57600
+
+
+def crc8(data):
+    """crc8 with polynomial 0x07, as plink_crc()."""
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07 if crc & 0x80 else crc << 1) & 0xff
+    return crc
+
+
+class Link:
+    """One open serial port and the frame parser."""
+
+    def __init__(self, port, timeout):
+        self.fd = os.open(port, os.O_RDWR | os.O_NOCTTY)
+        tty.setraw(self.fd)
+        attrs = termios.tcgetattr(self.fd)
+        attrs[4] = attrs[5] = BAUD
+        termios.tcsetattr(self.fd, termios.TCSANOW, attrs)
+        termios.tcflush(self.fd, termios.TCIOFLUSH)
+        self.timeout = timeout
+        self.buffer = b''
+
+    def read_frame(self, deadline):
+        """Returns (command, payload) of the next good frame, None on timeout."""
+        while True:
+            start = self.buffer.find(bytes([SYNC]))
+            if start < 0:
+                self.buffer = b''
+            else:
+                self.buffer = self.buffer[start:]
+                if len(self.buffer) >= 3:
+                    length = self.buffer[2]
+                    if len(self.buffer) >= length + 4:
+                        frame = self.buffer[1:length + 4]
+                        if crc8(frame[:-1]) == frame[-1]:
+                            self.buffer = self.buffer[length + 4:]
+                            return frame[0], frame[2:-1]
+                        self.buffer = self.buffer[1:]
+                        continue
+            left = deadline - time.monotonic()
+            if left <= 0 or not select.select([self.fd], [], [], left)[0]:
+                return None
+            self.buffer += os.read(self.fd, 256)
+
+    def request(self, command, payload=b''):
+        """Sends a frame and returns the payload of its answer."""
+        body = bytes([command, len(payload)]) + payload
+        os.write(self.fd, bytes([SYNC]) + body + bytes([crc8(body)]))
+        deadline = time.monotonic() + self.timeout
+        while True:
+            answer = self.read_frame(deadline)
+            if answer is None:
+                raise SystemExit('no answer to command %u' % command)
+            cmd, data = answer
+            if cmd == command | ERROR:
+                raise SystemExit('link error: %s' % LINK_ERRORS.get(data[0], data[0]))
+            if cmd == command:
+                return data
+
+
+def pack(param, text):
+    """Turns a value typed on the command line into the 4 value bytes."""
+    if param['type'] == 'float':
+        return struct.pack('<f', float(text))
+    return struct.pack('<i', int(text, 0))
+
+
+def unpack(param, raw):
+    """Turns the 4 value bytes back into a number."""
+    return struct.unpack('<f' if param['type'] == 'float' else '<i', raw)[0]
+
+
+def load_table(link):
+    """Returns the parameter descriptions by name, in index order."""
+    version, count = link.request(PING)
+    if version != VERSION:
+        raise SystemExit('link version %u, expected %u' % (version, VERSION))
+    table = {}
+    for index in range(count):
+        data = link.request(INFO, bytes([index]))
+        kind, flags, low, high = struct.unpack_from('<BBff', data, 1)
+        name = data[11:].decode('ascii')
+        table[name] = {'index': index, 'type': TYPES[kind], 'ro': bool(flags & 1),
+                       'min': low, 'max': high}
+    return table
+
+
+def get(link, param):
+    """Returns the live value of a parameter."""
+    data = link.request(GET, bytes([param['index']]))
+    return unpack(param, data[1:5])
+
+
+def main():
+    parser = argparse.ArgumentParser(description='tune the flight controller parameters')
+    parser.add_argument('port', help='serial port or host build pty')
+    parser.add_argument('command', choices=('list', 'get', 'set'))
+    parser.add_argument('items', nargs='*', help='NAME for get, NAME=VALUE for set')
+    parser.add_argument('--no-commit', action='store_true',
+                        help='leave the values in the shadow set')
+    parser.add_argument('--timeout', type=float, default=1.0,
+                        help='seconds to wait for each answer')
+    args = parser.parse_args()
+
+    link = Link(args.port, args.timeout)
+    table = load_table(link)
+
+    if args.command == 'list':
+        for name, param in table.items():
+            print('%-16s %-12.6g %-5s %g..%g%s' % (name, get(link, param), param['type'],
+                                                 param['min'], param['max'],
+                                                 ' ro' if param['ro'] else ''))
+        return
+
+    if args.command == 'get':
+        for name in args.items:
+            if name not in table:
+                raise SystemExit('unknown parameter %s' % name)
+            print('%s = %g' % (name, get(link, table[name])))
+        return
+
+    for item in args.items:
+        name, _, text = item.partition('=')
+        if name not in table or not text:
+            raise SystemExit('expected NAME=VALUE, got %s' % item)
+        param = table[name]
+        data = link.request(SET, bytes([param['index']]) + pack(param, text))
+        status = struct.unpack('<b', data[1:2])[0]
+        if status:
+            raise SystemExit('%s: %s' % (name, ERRORS.get(status, status)))
+    if args.no_commit:
+        return
+    status = struct.unpack('<b', link.request(COMMIT))[0]
+    if status:
+        raise SystemExit('commit refused: %s' % ERRORS.get(status, status))
+    print('committed %u value%s' % (len(args.items), '' if len(args.items) == 1 else 's'))
+
+
+if __name__ == '__main__':
+    main()
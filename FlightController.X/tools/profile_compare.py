@@ -0,0 +1,53 @@
+#!/usr/bin/env python3
+"""
+profile_compare.py - compares two profile_report() outputs kernel by kernel.
+
+Capture the JSON line printed by a PROFILE build once with RUN_FROM_RAM off and
+once with it on, then compare them to see what running the hot path from ram
+buys on the target. The same works for a change: the report of the build
+before it against the one after, the firmware keeps no baseline of its own.
+Any line of the capture that is not the report is ignored.
+
+usage: profile_compare.py flash.json ram.json
+"""
+
+import argparse
+import json
+import sys
+
+
+def load_report(path):
+    """Returns the last profile report found in a captured console log."""
+    report = None
+    with open(path, errors='replace') as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith('{"kernels"'):
+                report = json.loads(line)
+    if report is None:
+        sys.exit('%s: no profile report found' % path)
+    return report
+
+
+def main():
+    parser = argparse.ArgumentParser(description='compare two cycle profile reports')
+    parser.add_argument('before', help='report captured from the flash build')
+    parser.add_argument('after', help='report captured from the RUN_FROM_RAM build')
+    args = parser.parse_args()
+
+    before, after = load_report(args.before), load_report(args.after)
+    kernels = {k['name']: k for k in after['kernels']}
+
+    print('%-16s %10s %10s %8s %10s' % ('kernel', 'before', 'after', 'change', 'max after'))
+    for k in before['kernels']:
+        a = kernels.get(k['name'])
+        if a is None or not k['cycles_mean']:
+            continue
+        change = 100.0 * (a['cycles_mean'] - k['cycles_mean']) / k['cycles_mean']
+        print('%-16s %10d %10d %+7.1f%% %10d' % (k['name'], k['cycles_mean'], a['cycles_mean'],
+                                                  change, a['cycles_max']))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
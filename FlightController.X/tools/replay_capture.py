@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""
+replay_capture.py - turns the packets of a RECORD build into a replay log.
+
+The recorder sends the replay_header and then one replay_frame per control
+tick, each in a packet, @see src/replay.h:
+
+    'R', 'P', type, length, index:u32, payload[length], sum:u16
+
+Input is the packet stream, from a file (the FC_HOST_RECORD file of a host
+build, or a raw capture) or read live from the serial port the board's UART1
+is wired to, which needs pyserial. Bytes between packets and packets with a
+bad sum are skipped. The log ends at the first frame whose index does not
+follow the one before, what comes after a lost frame cannot be replayed.
+
+usage: replay_capture.py input output.log
+       replay_capture.py /dev/ttyUSB0 output.log --baud 1250000
+"""
+
+import argparse
+import struct
+import sys
+
+SYNC = b'RP'
+HEAD = struct.Struct('<2sBBI')  # sync, type, length, index
+SUM = struct.Struct('<BB')      # sum1, sum2
+PACKET_HEADER = 0
+PACKET_FRAME = 1
+
+
+def fletcher16(data):
+    """Returns (sum1, sum2) of data, the recorder's checksum."""
+    sum1 = sum2 = 0
+    for byte in data:
+        sum1 = (sum1 + byte) % 255
+        sum2 = (sum2 + sum1) % 255
+    return sum1, sum2
+
+
+def packets(read):
+    """Yields (type, index, payload) for every packet with a good sum, read(n)
+    returns up to n bytes and an empty result at the end of the input."""
+    buf = b''
+    done = False
+    while True:
+        if not done and len(buf) < HEAD.size + 255 + SUM.size:
+            more = read(4096)
+            done = not more
+            buf += more
+        start = buf.find(SYNC)
+        if start < 0:
+            buf = buf[-1:]
+            if done:
+                return
+            continue
+        buf = buf[start:]
+        if len(buf) < HEAD.size:
+            if done:
+                return
+            continue
+        sync, kind, length, index = HEAD.unpack_from(buf)
+        end = HEAD.size + length + SUM.size
+        if len(buf) < end:
+            if done:
+                return
+            continue
+        if SUM.unpack_from(buf, end - SUM.size) == fletcher16(buf[2:end - SUM.size]):
+            yield kind, index, buf[HEAD.size:end - SUM.size]
+            buf = buf[end:]
+        else:
+            buf = buf[1:]  # a sync in the data, look for the next one
+
+
+def capture(read, out):
+    """Writes the header and the frames that follow without a gap to out.
+    Returns the number of frames written."""
+    header = None
+    frames = 0
+    for kind, index, payload in packets(read):
+        if kind == PACKET_HEADER:
+            if header is not None:
+                print('replay_capture: the board restarted, the log ends there', file=sys.stderr)
+                break
+            header = payload
+            frame_bytes = struct.unpack_from('<I', header, 8)[0]
+            out.write(header)
+        elif kind == PACKET_FRAME and header is not None:
+            if index != frames or len(payload) != frame_bytes:
+                print('replay_capture: frame %u lost, the log ends there' % frames, file=sys.stderr)
+                break
+            out.write(payload)
+            frames += 1
+    if header is None:
+        print('replay_capture: no log header found', file=sys.stderr)
+    return frames
+
+
+def main():
+    parser = argparse.ArgumentParser(description='turn recorder packets into a replay log')
+    parser.add_argument('input', help='packet file, or the serial port with --baud')
+    parser.add_argument('output', help='replay log to write, for FC_HOST_REPLAY')
+    parser.add_argument('--baud', type=int, help='read the serial port at this rate until ctrl-c')
+    args = parser.parse_args()
+
+    if args.baud:
+        import serial
+        src = serial.Serial(args.input, args.baud, timeout=1)
+
+        def read(n):
+            # a timeout is not the end of the flight, only ctrl-c is
+            while True:
+                data = src.read(max(1, min(n, src.in_waiting)))
+                if data:
+                    return data
+    else:
+        src = open(args.input, 'rb')
+        read = src.read
+
+    with src, open(args.output, 'wb') as out:
+        try:
+            frames = capture(read, out)
+        except KeyboardInterrupt:
+            frames = None
+    if frames is not None:
+        print('replay_capture: %u frames' % frames, file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()